@@ -1,3 +1,7 @@
 C:/VulkanSDK/1.3.216.0/Bin/glslc shader.vert -o vert.spv
+C:/VulkanSDK/1.3.216.0/Bin/glslc depth.vert -o depth_vert.spv
 C:/VulkanSDK/1.3.216.0/Bin/glslc shader.frag -o frag.spv
+C:/VulkanSDK/1.3.216.0/Bin/glslc shader_bindless.frag -o frag_bindless.spv
+C:/VulkanSDK/1.3.216.0/Bin/glslc depth_pyramid.comp -o depth_pyramid.spv
+C:/VulkanSDK/1.3.216.0/Bin/glslc occlusion_cull.comp -o occlusion_cull.spv
 pause
\ No newline at end of file
@@ -0,0 +1,17 @@
+#!/bin/sh
+#builds the spir-v next to the sources, GLSLC overrides the compiler
+set -e
+cd "$(dirname "$0")"
+
+GLSLC="${GLSLC:-glslc}"
+if ! command -v "$GLSLC" >/dev/null 2>&1; then
+	echo "error: $GLSLC not found, install the Vulkan SDK or set GLSLC" >&2
+	exit 1
+fi
+
+"$GLSLC" shader.vert -o vert.spv
+"$GLSLC" depth.vert -o depth_vert.spv
+"$GLSLC" shader.frag -o frag.spv
+"$GLSLC" shader_bindless.frag -o frag_bindless.spv
+"$GLSLC" depth_pyramid.comp -o depth_pyramid.spv
+"$GLSLC" occlusion_cull.comp -o occlusion_cull.spv
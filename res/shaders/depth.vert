@@ -0,0 +1,55 @@
+#version 450
+
+//set by the application, see VertexFormat in Vertex.h
+layout(constant_id = 0) const bool quantizedVertices = false;
+
+//only the position, the pre-pass pipeline leaves the other attributes out
+layout(location = 0) in vec4 iPosition;
+
+//must match shader.vert bit for bit, the main pass tests against this depth with equal
+invariant gl_Position;
+
+layout(binding = 0) uniform UniformBufferObject
+{
+    mat4 view;
+    mat4 proj;
+    vec4 lightPos;
+    vec4 cameraPos;
+    vec4 positionOffset;
+    vec4 positionScale;
+} ubo;
+
+struct Transform
+{
+    mat4 model;
+    mat4 normal;
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer TransformBuffer
+{
+    Transform transforms[];
+};
+
+struct Instance
+{
+    uint node;
+    uint material;
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+
+void main() {
+    vec3 position = iPosition.xyz;
+
+    if (quantizedVertices)
+        position = ubo.positionOffset.xyz + iPosition.xyz * ubo.positionScale.xyz;
+
+    Instance instance = instances[gl_InstanceIndex];
+    Transform transform = transforms[instance.node];
+    vec3 worldPos = vec3(transform.model * vec4(position, 1.0));
+
+    gl_Position = ubo.proj * ubo.view * vec4(worldPos, 1.0);
+}
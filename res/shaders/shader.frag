@@ -3,6 +3,7 @@
 layout(location = 0) in vec3 iWorldPos;
 layout(location = 1) in vec3 iNormal;
 layout(location = 2) in vec2 iTexCoord;
+layout(location = 4) in vec4 iTangent;
 
 layout(location = 0) out vec4 oColor;
 
@@ -16,10 +17,8 @@ const float PI = 3.14159265359;
 
 layout(binding = 0) uniform UniformBufferObject
 {
-    mat4 model;
     mat4 view;
     mat4 proj;
-    mat4 normal;
     vec4 lightPos;
     vec4 cameraPos;
 } ubo;
@@ -27,15 +26,30 @@ layout(binding = 0) uniform UniformBufferObject
 
 vec3 getNormal()
 {
-    vec3 normal = 2 * texture(normalTexture, iTexCoord).rgb - 1;
-	vec3 q1 = dFdx(iWorldPos);
-	vec3 q2 = dFdy(iWorldPos);
-	vec2 st1 = dFdx(iTexCoord);
-	vec2 st2 = dFdy(iTexCoord);
-
-	vec3 N = normalize(iNormal);
-	vec3 T = normalize(q1 * st2.t - q2 * st1.t);
-	vec3 B = -normalize(cross(N, T));
+    //z is rebuilt so two channel (bc5) normal maps work as well
+    vec2 xy = 2 * texture(normalTexture, iTexCoord).rg - 1;
+    vec3 normal = vec3(xy, sqrt(max(1 - dot(xy, xy), 0)));
+    //derivatives are taken outside of the branch, they are undefined in non uniform control flow
+    vec3 q1 = dFdx(iWorldPos);
+    vec3 q2 = dFdy(iWorldPos);
+    vec2 st1 = dFdx(iTexCoord);
+    vec2 st2 = dFdy(iTexCoord);
+
+    vec3 N = normalize(iNormal);
+    vec3 T;
+    vec3 B;
+    if (dot(iTangent.xyz, iTangent.xyz) > 0.0)
+    {
+        //vertex tangent, orthogonalized against the interpolated normal
+        T = normalize(iTangent.xyz - N * dot(N, iTangent.xyz));
+        B = cross(N, T) * iTangent.w;
+    }
+    else
+    {
+        //no tangent in the model, derived from the screen space derivatives
+        T = normalize(q1 * st2.t - q2 * st1.t);
+        B = -normalize(cross(N, T));
+    }
     mat3 TBN = mat3(T, B, N);
     
     return normalize(TBN * normal);
@@ -1,29 +1,90 @@
 #version 450
 #extension GL_OES_standard_derivatives : enable
 
-layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec3 iNormal;
+//set by the application, see VertexFormat in Vertex.h
+layout(constant_id = 0) const bool quantizedVertices = false;
+
+//quantized: position is unorm16 with the tangent sign in w, normal and tangent are octahedral snorm16.
+//float: the tangent is zero if the model has none
+layout(location = 0) in vec4 iPosition;
+layout(location = 1) in vec4 iNormal;
 layout(location = 2) in vec2 iTexCoord;
 layout(location = 3) in vec4 iTangent;
 
 layout(location = 0) out vec3 oWorldPos;
 layout(location = 1) out vec3 oNormal;
 layout(location = 2) out vec2 oTexCoord;
+layout(location = 3) flat out uint oMaterial;
+//world space tangent and handedness, zero without a tangent
+layout(location = 4) out vec4 oTangent;
+
+//the depth pre-pass computes the same position in depth.vert, the main pass tests it with equal
+invariant gl_Position;
 
 layout(binding = 0) uniform UniformBufferObject
 {
-    mat4 model;
     mat4 view;
     mat4 proj;
-    mat4 normal;
     vec4 lightPos;
     vec4 cameraPos;
+    vec4 positionOffset;
+    vec4 positionScale;
 } ubo;
 
+struct Transform
+{
+    mat4 model;
+    mat4 normal;
+};
+
+//world matrices of the scene graph nodes
+layout(std430, set = 0, binding = 2) readonly buffer TransformBuffer
+{
+    Transform transforms[];
+};
+
+struct Instance
+{
+    uint node;
+    uint material;
+};
+
+//every instance drawn this frame, draws pass the start of their range as firstInstance
+layout(std430, set = 0, binding = 3) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main() {
-    oWorldPos = vec3(ubo.model * vec4(iPosition, 1.0));
-    oNormal = iNormal;
+    vec3 position = iPosition.xyz;
+    vec3 normal = iNormal.xyz;
+    vec4 tangent = iTangent;
+
+    if (quantizedVertices)
+    {
+        position = ubo.positionOffset.xyz + iPosition.xyz * ubo.positionScale.xyz;
+        normal = octDecode(iNormal.xy);
+        //w is 0 or 1 for the handedness and 0.5 for vertices without a tangent
+        bool hasTangent = abs(iPosition.w - 0.5) > 0.25;
+        tangent = hasTangent ? vec4(octDecode(iTangent.xy), iPosition.w > 0.5 ? 1.0 : -1.0) : vec4(0.0);
+    }
+
+    Instance instance = instances[gl_InstanceIndex];
+    Transform transform = transforms[instance.node];
+    oWorldPos = vec3(transform.model * vec4(position, 1.0));
+    oNormal = mat3(transform.normal) * normal;
+    oTangent = vec4(mat3(transform.model) * tangent.xyz, tangent.w);
     oTexCoord = iTexCoord;
+    oMaterial = instance.material;
 
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(iPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * vec4(oWorldPos, 1.0);
 }
\ No newline at end of file
@@ -1,36 +1,64 @@
 #include "Application.h"
 
 #include "framework/utils/Utils.h"
+#include "framework/utils/Log.h"
+#include "framework/utils/Timer.h"
 #include "ShaderMatrixInfo.h"
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
 #include <glm/gtc/matrix_transform.hpp>
 
-Application::Application()
+Application::Application(bool keepGeometry)
 {
     Renderer::createSwapchain();
     Renderer::createDepthImage();
 	m_renderPass.create(Renderer::getSwapchainFormat());
+    m_earlyRenderPass.create(Renderer::getSwapchainFormat(), true, false);
+    m_lateRenderPass.create(Renderer::getSwapchainFormat(), false, true);
     Renderer::createFramebuffers(m_renderPass);
 
-    m_model.loadFromDisk("res/models/Sponza/glTF/Sponza.gltf");
+    //textures stream in while the first frames are rendered
+    ModelLoadOptions options;
+    options.streamTextures = true;
+    options.vertexFormat = VertexFormat::eQuantized;
+    m_model.loadFromDisk("res/models/Sponza/glTF/Sponza.gltf", options);
 
-    m_indexBuffer.create(utils::vectorsizeof(m_model.getIndexData()));
-    m_indexBuffer.mapMemory(m_model.getIndexData());
-    
-    m_vertexBuffer.create(utils::vectorsizeof(m_model.getVertexData()));
-    m_vertexBuffer.mapMemory(m_model.getVertexData());
+    m_geometryPool.create(geometryPoolVertexBytes, geometryPoolIndexBytes, m_geometryPlacement);
+    uploadGeometry();
 
-    m_uniformBuffers.resize(Device::maxFramesInFlight);
-    for (auto& buffer : m_uniformBuffers)
-        buffer.create(sizeof(ShaderMatrixInfo));
+    m_frameAllocator.create(frameAllocatorBytes);
+
+    size_t nodeCount = std::max<size_t>(m_model.getSceneGraph().size(), 1);
+    m_transforms.resize(nodeCount, { glm::mat4(1.0f), glm::mat4(1.0f) });
+    m_transformVersions.resize(Device::maxFramesInFlight, ~0ull);
+    m_transformBuffers.resize(Device::maxFramesInFlight);
+    for (auto& buffer : m_transformBuffers)
+    {
+        buffer.setName("transforms");
+        buffer.create(sizeof(ShaderTransform) * nodeCount);
+    }
+
+    //every instance is drawn at most once per frame
+    size_t instanceCount = 1;
+    for (auto& primitive : m_model.getMesh())
+        instanceCount += primitive.instanceCount;
+    m_visibleInstances.reserve(instanceCount);
+    m_instanceRange = sizeof(ShaderInstance) * std::max<size_t>(instanceCount, 1);
 
     setupDescriptors();
+    createPipeline();
 
-    m_pipeline.setVertexDescriptionInfo(m_vertexBuffer.getVertexDescriptionInfo());
-    m_pipeline.addDescriptorLayout(m_descriptorSet.getLayout());
-    m_pipeline.addDescriptorLayout(m_materialDescriptorSet.getLayout());
-	m_pipeline.create(m_renderPass, "res/shaders/", Renderer::getSwapchainExtent());
+    m_gpuTimer.create(Renderer::getDevice());
+    m_clusterCuller.create(m_model.getMeshlets(), m_model.getMesh(), m_model.getInstances());
+    m_primitiveCuller.create(m_model.getMesh(), m_model.getInstances());
+    if (Renderer::getDevice().supportsDrawIndirectCount())
+        m_occlusionCuller.create(m_primitiveCuller.getTestedCount(), m_frameAllocator);
+
+    //vertices and indices only live on the gpu from here on, unless they are uploaded again later
+    if (!keepGeometry)
+        m_model.releaseGeometry();
 
     m_camera.getPosition() = { -9.f, 1.f, -0.5f };
     m_camera.getRotation() = { 0.f, 0.f };
@@ -39,16 +67,38 @@ Application::Application()
 
 Application::~Application()
 {
-    m_indexBuffer.destroy();
-    m_vertexBuffer.destroy();
+    Renderer::getDevice().handle.waitIdle();
+
+    if (m_memoryDumpInterval > 0)
+    {
+        MemoryStats::get().logSummary();
+        MemoryStats::get().writeJson(m_memoryDumpPath + ".json");
+    }
+
+    m_geometryPool.destroy();
+
+    m_frameAllocator.destroy();
 
-    for (auto& buffer : m_uniformBuffers)
+    for (auto& buffer : m_transformBuffers)
         buffer.destroy();
 
     m_descriptorSet.destroy();
     m_materialDescriptorSet.destroy();
+    if (Renderer::getDevice().supportsBindless())
+    {
+        m_bindlessDescriptorSet.destroy();
+        m_materialBuffer.destroy();
+    }
     m_pipeline.destroy();
+    m_depthPipeline.destroy();
+    m_gpuTimer.destroy();
+    if (m_parallelRecording)
+        m_parallelRecorder.destroy();
+    if (Renderer::getDevice().supportsDrawIndirectCount())
+        m_occlusionCuller.destroy();
     m_renderPass.destroy();
+    m_earlyRenderPass.destroy();
+    m_lateRenderPass.destroy();
     m_model.destroy();
 }
 
@@ -58,6 +108,16 @@ void Application::run()
     {
         glfwPollEvents();
         m_camera.input(0.16f);
+
+        //p switches the depth pre-pass once per press, the gpu time of the mode it leaves is logged
+        bool prepassKey = glfwGetKey(Renderer::getWindow(), GLFW_KEY_P) == GLFW_PRESS;
+        if (prepassKey && !m_prepassKeyDown)
+        {
+            Log::info("depth pre-pass {}: gpu {:.3f} ms", m_depthPrepass ? "on" : "off", m_lastGpuTime);
+            setDepthPrepass(!m_depthPrepass);
+        }
+        m_prepassKeyDown = prepassKey;
+
         doFrame();
     }
 
@@ -66,34 +126,745 @@ void Application::run()
 
 void Application::doFrame()
 {
-    vk::DeviceSize offsets[1] = { vk::DeviceSize() };
     //Log::info("x {}, y {}, z {}", m_camera.getPosition().x, m_camera.getPosition().y, m_camera.getPosition().z);
-    updateUniforms();
+    m_model.updateStreaming();
 
+    //the frame's fence has signaled once prepareFrame() returns, so the gpu no longer reads its memory
     auto commandBuffer = Renderer::prepareFrame();
+    uint32_t frameIndex = Renderer::getCurrentFrameIndex();
+    m_frameAllocator.beginFrame(frameIndex);
+    updateUniforms();
+    updateTransforms();
+    //prepareFrame() waited on this frame's fence, so its previous timestamps are available
+    m_lastGpuTime = m_gpuTimer.getElapsedMs(frameIndex);
+    writeMaterialDescriptors();
+
+    m_gpuTimer.begin(commandBuffer, frameIndex);
+    if (isOcclusionCulling())
+        recordOcclusionCulledFrame(commandBuffer);
+    else
+        recordFrame(commandBuffer);
+    m_gpuTimer.end(commandBuffer, frameIndex);
+
+    Renderer::endFrame();
+
+    if (m_memoryDumpInterval > 0 && MemoryStats::get().getFrame() % m_memoryDumpInterval == 0)
+        MemoryStats::get().writeCsv(m_memoryDumpPath + ".csv");
+}
+
+void Application::recordFrame(vk::CommandBuffer commandBuffer)
+{
+    uint32_t baseIndex = m_geometryPool.getFirstIndex(m_geometry);
+    int32_t baseVertex = m_geometryPool.getBaseVertex(m_geometry);
+
+    Timer recordTimer;
+    buildDrawList();
+    buildRenderQueue();
+    uint32_t instanceOffset = m_frameAllocator.push(DataView<ShaderInstance>(m_visibleInstances), m_instanceRange);
+
+    uint32_t commandOffset = 0;
+    uint32_t prepassCommandOffset = 0;
+    if (isIndirectDrawing())
+    {
+        buildIndirectCommands(baseIndex, baseVertex);
+        commandOffset = m_frameAllocator.push(DataView<vk::DrawIndexedIndirectCommand>(m_indirectCommands), 0);
+        prepassCommandOffset = commandOffset;
+        if (m_depthPrepass && !isBindless())
+        {
+            buildPrepassCommands(baseIndex, baseVertex);
+            prepassCommandOffset = m_frameAllocator.push(DataView<vk::DrawIndexedIndirectCommand>(m_prepassCommands), 0);
+        }
+    }
+    m_frameAllocator.flush();
+
+    if (m_matrixOffset == FrameAllocator::invalidOffset || instanceOffset == FrameAllocator::invalidOffset ||
+        commandOffset == FrameAllocator::invalidOffset || prepassCommandOffset == FrameAllocator::invalidOffset)
+    {
+        recordEmptyFrame(commandBuffer);
+        m_lastRecordTime = recordTimer.elapsedMs();
+        return;
+    }
+
+    Timer drawTimer;
     auto renderPassInfo = Renderer::beginRenderPass(m_renderPass, Renderer::getCurrentFramebuffer());
+    if (isParallelRecording())
+    {
+        //a pass with secondary contents only executes the buffers the workers recorded
+        commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+        recordParallelDraws(commandBuffer, baseIndex, baseVertex, instanceOffset);
+    }
+    else
+    {
+        commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+        bindFrameState(commandBuffer, instanceOffset, m_frameStats);
 
+        if (m_depthPrepass)
+            recordDepthPrepass(commandBuffer, baseIndex, baseVertex, prepassCommandOffset);
+
+        if (isIndirectDrawing())
+            recordIndirectDraws(commandBuffer, commandOffset);
+        else
+            recordDirectDraws(commandBuffer, baseIndex, baseVertex, 0, static_cast<uint32_t>(m_renderQueue.size()), m_frameStats);
+    }
+    m_lastDrawRecordTime = drawTimer.elapsedMs();
+    m_lastRecordTime = recordTimer.elapsedMs();
+
+    commandBuffer.endRenderPass();
+}
+
+void Application::recordEmptyFrame(vk::CommandBuffer commandBuffer)
+{
+    //the allocator logged the error, drawing with another allocation's data would show garbage
+    auto renderPassInfo = Renderer::beginRenderPass(m_renderPass, Renderer::getCurrentFramebuffer());
     commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+    commandBuffer.endRenderPass();
+}
+
+void Application::bindFrameState(vk::CommandBuffer commandBuffer, uint32_t instanceOffset, FrameStats& stats)
+{
     commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline.handle);
 
-    commandBuffer.bindVertexBuffers(0, 1, &m_vertexBuffer.handle, offsets);
-    commandBuffer.bindIndexBuffer(m_indexBuffer.handle, 0, vk::IndexType::eUint32);
+    //every model lives in the pool, so its arenas are bound once per command buffer
+    m_geometryPool.bind(commandBuffer, m_model.getIndexType());
 
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline.getLayout(), 0, { m_descriptorSet[Renderer::getCurrentFrameIndex()] }, {});
+    //dynamic offsets in binding order, the matrices at binding 0 and the instances at binding 3
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline.getLayout(), 0, { m_descriptorSet[Renderer::getCurrentFrameIndex()] },
+        { m_matrixOffset, instanceOffset });
+    stats.descriptorBinds++;
+    if (isBindless())
+    {
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline.getLayout(), 1, { m_bindlessDescriptorSet[0] }, {});
+        stats.descriptorBinds++;
+    }
+}
+
+void Application::recordParallelDraws(vk::CommandBuffer commandBuffer, uint32_t baseIndex, int32_t baseVertex, uint32_t instanceOffset)
+{
+    m_parallelRecorder.beginFrame(Renderer::getCurrentFrameIndex());
+    vk::Framebuffer framebuffer = Renderer::getCurrentFramebuffer();
+    vk::Extent2D extent = Renderer::getSwapchainExtent();
+    uint32_t drawCount = static_cast<uint32_t>(m_renderQueue.size());
 
-    auto& mesh = m_model.getMesh();
+    //every slice counts into its own stats, they are added up once all slices are recorded
+    m_sliceStats.assign(m_parallelRecorder.getThreadCount(), {});
 
-    for (auto& primitive : mesh)
+    //the whole pre-pass is executed before the first shaded slice, so every slice tests against the final depth
+    if (m_depthPrepass)
     {
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline.getLayout(),
-            1, { m_materialDescriptorSet[primitive.materialIndex] }, {});
+        m_parallelRecorder.record(commandBuffer, m_renderPass, framebuffer, extent, drawCount,
+            [&](vk::CommandBuffer cmd, uint32_t slice, uint32_t first, uint32_t count)
+            {
+                bindFrameState(cmd, instanceOffset, m_sliceStats[slice]);
+                cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_depthPipeline.handle);
+                recordDepthDraws(cmd, baseIndex, baseVertex, first, count, m_sliceStats[slice]);
+            });
+        m_frameStats.secondaryBuffers += m_parallelRecorder.getSliceCount();
+    }
+
+    m_parallelRecorder.record(commandBuffer, m_renderPass, framebuffer, extent, drawCount,
+        [&](vk::CommandBuffer cmd, uint32_t slice, uint32_t first, uint32_t count)
+        {
+            bindFrameState(cmd, instanceOffset, m_sliceStats[slice]);
+            recordDirectDraws(cmd, baseIndex, baseVertex, first, count, m_sliceStats[slice]);
+        });
+    m_frameStats.secondaryBuffers += m_parallelRecorder.getSliceCount();
+
+    for (auto& stats : m_sliceStats)
+    {
+        m_frameStats.drawCalls += stats.drawCalls;
+        m_frameStats.recordedDrawCalls += stats.recordedDrawCalls;
+        m_frameStats.prepassDrawCalls += stats.prepassDrawCalls;
+        m_frameStats.descriptorBinds += stats.descriptorBinds;
+        m_frameStats.bindsSaved += stats.bindsSaved;
+        m_frameStats.triangles += stats.triangles;
+        m_frameStats.instances += stats.instances;
+    }
+}
+
+void Application::recordOcclusionCulledFrame(vk::CommandBuffer commandBuffer)
+{
+    uint32_t frameIndex = Renderer::getCurrentFrameIndex();
+    uint32_t baseIndex = m_geometryPool.getFirstIndex(m_geometry);
+    int32_t baseVertex = m_geometryPool.getBaseVertex(m_geometry);
+
+    Timer recordTimer;
+    buildCullObjects(baseIndex, baseVertex);
 
-        commandBuffer.drawIndexed(primitive.indexCount, 1, primitive.firstIndex, 0, 0);
+    //the gpu decides what is drawn, its counts arrive once the frame that last used this index has finished
+    OcclusionCounts counts = m_occlusionCuller.getCounts(frameIndex);
+    m_frameStats = {};
+    m_frameStats.objectsTested = static_cast<uint32_t>(m_cullObjects.size());
+    m_frameStats.objectsVisible = counts.earlyDraws + counts.lateDraws;
+    m_frameStats.drawCalls = counts.earlyDraws + counts.lateDraws;
+    m_frameStats.instances = counts.earlyDraws + counts.lateDraws;
+    m_frameStats.triangles = counts.triangles;
+    m_frameStats.lateDraws = counts.lateDraws;
+
+    //instance i belongs to object i, the culling shader passes the object as firstInstance
+    uint32_t instanceOffset = m_frameAllocator.push(DataView<ShaderInstance>(m_visibleInstances), m_instanceRange);
+    bool culled = m_occlusionCuller.update(DataView<ShaderCullObject>(m_cullObjects), m_camera.getViewMatrix(), m_camera.getProjMatrix());
+    m_frameAllocator.flush();
+
+    if (!culled || m_matrixOffset == FrameAllocator::invalidOffset || instanceOffset == FrameAllocator::invalidOffset)
+    {
+        recordEmptyFrame(commandBuffer);
+        m_lastRecordTime = recordTimer.elapsedMs();
+        return;
     }
 
+    m_occlusionCuller.beginFrame(commandBuffer);
+    m_occlusionCuller.cull(commandBuffer, OcclusionPhase::eEarly);
+    recordOcclusionPhase(commandBuffer, m_earlyRenderPass, OcclusionPhase::eEarly, instanceOffset);
+
+    m_occlusionCuller.buildPyramid(commandBuffer);
+    m_occlusionCuller.cull(commandBuffer, OcclusionPhase::eLate);
+    recordOcclusionPhase(commandBuffer, m_lateRenderPass, OcclusionPhase::eLate, instanceOffset);
+    m_lastRecordTime = recordTimer.elapsedMs();
+}
+
+void Application::recordOcclusionPhase(vk::CommandBuffer commandBuffer, RenderPass& renderPass, OcclusionPhase phase, uint32_t instanceOffset)
+{
+    uint32_t frameIndex = Renderer::getCurrentFrameIndex();
+    auto renderPassInfo = Renderer::beginRenderPass(renderPass, Renderer::getCurrentFramebuffer());
+
+    commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline.handle);
+    m_geometryPool.bind(commandBuffer, m_model.getIndexType());
+
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline.getLayout(), 0, { m_descriptorSet[frameIndex] },
+        { m_matrixOffset, instanceOffset });
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline.getLayout(), 1, { m_bindlessDescriptorSet[0] }, {});
+    m_frameStats.descriptorBinds += 2;
+
+    //the same commands are drawn twice, the gpu culled them once for both
+    if (m_depthPrepass)
+    {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_depthPipeline.handle);
+        m_occlusionCuller.draw(commandBuffer, phase);
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline.handle);
+        m_frameStats.recordedDrawCalls++;
+        m_frameStats.prepassDrawCalls++;
+    }
+
+    m_occlusionCuller.draw(commandBuffer, phase);
+    m_frameStats.recordedDrawCalls++;
+
     commandBuffer.endRenderPass();
+}
 
-    Renderer::endFrame();
+void Application::buildCullObjects(uint32_t baseIndex, int32_t baseVertex)
+{
+    m_primitiveCuller.updateBounds(m_model.getSceneGraph());
+
+    auto mesh = m_model.getMesh();
+    m_cullObjects.resize(m_primitiveCuller.getTestedCount());
+    m_visibleInstances.clear();
+    for (uint32_t object = 0; object < m_cullObjects.size(); object++)
+    {
+        const Primitive& primitive = mesh[m_primitiveCuller.getPrimitive(object)];
+        ShaderCullObject& cullObject = m_cullObjects[object];
+        cullObject.sphere = m_primitiveCuller.getSphere(object);
+        //like the draws of the cpu path, objects are skipped until their material has finished streaming
+        cullObject.indexCount = m_materialWritten[primitive.materialIndex] ? primitive.indexCount : 0;
+        cullObject.firstIndex = baseIndex + primitive.firstIndex;
+        cullObject.vertexOffset = baseVertex + static_cast<int32_t>(primitive.firstVertex);
+        cullObject.instance = object;
+
+        m_visibleInstances.push_back({ m_primitiveCuller.getNode(object), primitive.materialIndex });
+    }
+}
+
+void Application::setMemoryDump(const std::string& path, uint32_t interval)
+{
+    m_memoryDumpPath = path;
+    m_memoryDumpInterval = interval;
+}
+
+void Application::recordDepthPrepass(vk::CommandBuffer commandBuffer, uint32_t baseIndex, int32_t baseVertex, uint32_t commandOffset)
+{
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_depthPipeline.handle);
+
+    //materials don't matter for depth, so even without bindless the draws are recorded without binds in one front to back run
+    if (isIndirectDrawing())
+    {
+        if (!m_indirectCommands.empty())
+        {
+            commandBuffer.drawIndexedIndirect(m_frameAllocator.handle, commandOffset, static_cast<uint32_t>(m_indirectCommands.size()),
+                sizeof(vk::DrawIndexedIndirectCommand));
+            m_frameStats.recordedDrawCalls++;
+            m_frameStats.prepassDrawCalls++;
+        }
+    }
+    else
+        recordDepthDraws(commandBuffer, baseIndex, baseVertex, 0, static_cast<uint32_t>(m_renderQueue.size()), m_frameStats);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline.handle);
+}
+
+void Application::recordDepthDraws(vk::CommandBuffer commandBuffer, uint32_t baseIndex, int32_t baseVertex, uint32_t first, uint32_t count, FrameStats& stats)
+{
+    auto& packets = getPrepassQueue().getPackets();
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        const DrawRange& draw = m_draws[packets[i].draw];
+        commandBuffer.drawIndexed(draw.indexCount, draw.instanceCount, baseIndex + draw.firstIndex, baseVertex + static_cast<int32_t>(draw.vertexOffset), draw.firstInstance);
+        stats.recordedDrawCalls++;
+        stats.prepassDrawCalls++;
+    }
+}
+
+void Application::recordDirectDraws(vk::CommandBuffer commandBuffer, uint32_t baseIndex, int32_t baseVertex, uint32_t first, uint32_t count, FrameStats& stats)
+{
+    auto& packets = m_renderQueue.getPackets();
+    uint32_t boundMaterial = ~0u;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        const DrawRange& draw = m_draws[packets[i].draw];
+        if (!isBindless())
+        {
+            //the queue is sorted by material, so the set only changes between runs of a material
+            if (draw.materialIndex != boundMaterial)
+            {
+                commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline.getLayout(),
+                    1, { m_materialDescriptorSet[draw.materialIndex] }, {});
+                stats.descriptorBinds++;
+                boundMaterial = draw.materialIndex;
+            }
+            else
+                stats.bindsSaved++;
+        }
+
+        commandBuffer.drawIndexed(draw.indexCount, draw.instanceCount, baseIndex + draw.firstIndex, baseVertex + static_cast<int32_t>(draw.vertexOffset), draw.firstInstance);
+        stats.drawCalls++;
+        stats.recordedDrawCalls++;
+        stats.instances += draw.instanceCount;
+        stats.triangles += uint64_t(draw.indexCount / 3) * draw.instanceCount;
+    }
+}
+
+void Application::recordIndirectDraws(vk::CommandBuffer commandBuffer, uint32_t commandOffset)
+{
+    constexpr uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+
+    //the shaders find the material of every draw themselves, so the whole list is one call
+    if (isBindless() && !m_indirectCommands.empty())
+    {
+        commandBuffer.drawIndexedIndirect(m_frameAllocator.handle, commandOffset, static_cast<uint32_t>(m_indirectCommands.size()), stride);
+        m_frameStats.recordedDrawCalls++;
+        return;
+    }
+
+    for (auto& batch : m_drawBatches)
+    {
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline.getLayout(),
+            1, { m_materialDescriptorSet[batch.materialIndex] }, {});
+        m_frameStats.descriptorBinds++;
+
+        commandBuffer.drawIndexedIndirect(m_frameAllocator.handle, commandOffset + batch.firstCommand * stride, batch.commandCount, stride);
+        m_frameStats.recordedDrawCalls++;
+        m_frameStats.bindsSaved += batch.commandCount - 1;
+    }
+}
+
+void Application::buildIndirectCommands(uint32_t baseIndex, int32_t baseVertex)
+{
+    m_drawBatches.clear();
+    m_indirectCommands.resize(m_renderQueue.size());
+
+    auto& packets = m_renderQueue.getPackets();
+    for (uint32_t i = 0; i < packets.size(); i++)
+    {
+        const DrawRange& draw = m_draws[packets[i].draw];
+        if (m_drawBatches.empty() || m_drawBatches.back().materialIndex != draw.materialIndex)
+            m_drawBatches.push_back({ draw.materialIndex, i, 0 });
+        m_drawBatches.back().commandCount++;
+
+        vk::DrawIndexedIndirectCommand& command = m_indirectCommands[i];
+        command.indexCount = draw.indexCount;
+        command.instanceCount = draw.instanceCount;
+        command.firstIndex = baseIndex + draw.firstIndex;
+        command.vertexOffset = baseVertex + static_cast<int32_t>(draw.vertexOffset);
+        command.firstInstance = draw.firstInstance;
+
+        m_frameStats.drawCalls++;
+        m_frameStats.instances += draw.instanceCount;
+        m_frameStats.triangles += uint64_t(draw.indexCount / 3) * draw.instanceCount;
+    }
+}
+
+void Application::buildPrepassCommands(uint32_t baseIndex, int32_t baseVertex)
+{
+    auto& packets = m_depthQueue.getPackets();
+    m_prepassCommands.resize(packets.size());
+    for (uint32_t i = 0; i < packets.size(); i++)
+    {
+        const DrawRange& draw = m_draws[packets[i].draw];
+        vk::DrawIndexedIndirectCommand& command = m_prepassCommands[i];
+        command.indexCount = draw.indexCount;
+        command.instanceCount = draw.instanceCount;
+        command.firstIndex = baseIndex + draw.firstIndex;
+        command.vertexOffset = baseVertex + static_cast<int32_t>(draw.vertexOffset);
+        command.firstInstance = draw.firstInstance;
+    }
+}
+
+void Application::buildRenderQueue()
+{
+    //a single pipeline for now, its slot in the key is kept for pipelines that are added later
+    constexpr uint32_t pipeline = 0;
+    //bindless draws don't switch anything between materials, so they are only sorted front to back
+    bool sortByMaterial = !isBindless();
+    //the pre-pass only writes depth, so it gets its own queue without the material bits to be drawn front to back
+    bool depthQueue = m_depthPrepass && sortByMaterial;
+
+    m_renderQueue.clear();
+    m_depthQueue.clear();
+    for (uint32_t i = 0; i < m_draws.size(); i++)
+    {
+        //skip primitives until their textures have finished streaming
+        uint32_t material = m_draws[i].materialIndex;
+        if (!m_materialWritten[material])
+            continue;
+
+        m_renderQueue.push(RenderQueue::makeKey(pipeline, sortByMaterial ? material : 0, m_drawDepths[i]), i);
+        if (depthQueue)
+            m_depthQueue.push(RenderQueue::makeKey(pipeline, 0, m_drawDepths[i]), i);
+    }
+    m_renderQueue.sort();
+    m_depthQueue.sort();
+}
+
+void Application::buildDrawList()
+{
+    m_frameStats = {};
+    m_draws.clear();
+    m_drawDepths.clear();
+
+    const SceneGraph& sceneGraph = m_model.getSceneGraph();
+    glm::vec3 cameraPosition = m_camera.getPosition();
+    Frustum frustum = Frustum::fromMatrix(m_camera.getProjMatrix() * m_camera.getViewMatrix());
+
+    m_lodSelector.update(m_camera.getProjMatrix(), static_cast<float>(Renderer::getSwapchainExtent().height), cameraPosition);
+    if (m_frustumCulling)
+    {
+        m_primitiveCuller.updateBounds(sceneGraph);
+        m_primitiveCuller.update(frustum);
+        m_frameStats.objectsTested = m_primitiveCuller.getTestedCount();
+    }
+    else
+        m_primitiveCuller.setAllVisible();
+    m_frameStats.objectsVisible = m_primitiveCuller.getVisibleCount();
+
+    if (m_clusterCulling)
+    {
+        m_clusterCuller.updateBounds(sceneGraph);
+        m_clusterCuller.update(frustum, cameraPosition);
+        m_frameStats.clustersTested = m_clusterCuller.getTestedCount();
+        m_frameStats.clustersVisible = m_clusterCuller.getVisibleCount();
+    }
+
+    m_visibleInstances.clear();
+    auto lods = m_model.getLods();
+    auto instances = m_model.getInstances();
+    auto mesh = m_model.getMesh();
+    //primitives without a visible instance are skipped as a whole
+    for (uint32_t primitiveIndex : m_primitiveCuller.getVisiblePrimitives())
+    {
+        const Primitive& primitive = mesh[primitiveIndex];
+        if (primitive.instanceCount > 1)
+        {
+            appendInstancedDraws(primitiveIndex);
+            continue;
+        }
+
+        uint32_t node = instances[primitive.firstInstance];
+        uint32_t firstInstance = static_cast<uint32_t>(m_visibleInstances.size());
+        const glm::mat4& world = sceneGraph.getWorldMatrix(node);
+        size_t drawCount = m_draws.size();
+        glm::vec3 center = world * glm::vec4(primitive.center, 1.0f);
+        float radius = primitive.radius * utils::getMaxScale(world);
+
+        //meshlets only exist for the original geometry, simplified levels are culled as a whole
+        uint32_t lod = m_lodSelector.select(primitive, lods, world);
+        if (lod == 0)
+        {
+            if (m_clusterCulling)
+                m_clusterCuller.appendVisible(primitive, firstInstance, m_draws);
+            else
+                m_draws.push_back({ primitive.firstIndex, primitive.indexCount, primitive.firstVertex, primitive.materialIndex, firstInstance, 1 });
+        }
+        else
+        {
+            auto& level = lods[primitive.firstLod + lod];
+            m_draws.push_back({ level.firstIndex, level.indexCount, primitive.firstVertex, primitive.materialIndex, firstInstance, 1 });
+            m_frameStats.simplifiedDraws++;
+        }
+
+        //all draws of the primitive share its one instance and its depth
+        if (m_draws.size() != drawCount)
+        {
+            m_visibleInstances.push_back({ node, primitive.materialIndex });
+            m_drawDepths.resize(m_draws.size(), std::max(glm::distance(cameraPosition, center) - radius, 0.0f));
+        }
+    }
+}
+
+void Application::appendInstancedDraws(uint32_t primitiveIndex)
+{
+    const Primitive& primitive = m_model.getMesh()[primitiveIndex];
+    uint32_t firstObject = m_primitiveCuller.getFirstObject(primitiveIndex);
+    const SceneGraph& sceneGraph = m_model.getSceneGraph();
+    auto lods = m_model.getLods();
+    auto instances = m_model.getInstances();
+
+    m_lodInstances.resize(std::max<size_t>(m_lodInstances.size(), std::max(primitive.lodCount, 1u)));
+    for (auto& bucket : m_lodInstances)
+        bucket.clear();
+    m_lodDepths.assign(m_lodInstances.size(), std::numeric_limits<float>::max());
+
+    glm::vec3 cameraPosition = m_camera.getPosition();
+    for (uint32_t i = primitive.firstInstance; i < primitive.firstInstance + primitive.instanceCount; i++)
+    {
+        if (!m_primitiveCuller.isVisible(firstObject + i - primitive.firstInstance))
+            continue;
+
+        const glm::mat4& world = sceneGraph.getWorldMatrix(instances[i]);
+        glm::vec3 center = world * glm::vec4(primitive.center, 1.0f);
+        float radius = primitive.radius * utils::getMaxScale(world);
+
+        uint32_t lod = m_lodSelector.select(primitive, lods, world);
+        m_lodInstances[lod].push_back(instances[i]);
+        //an instanced draw is as near as its nearest instance
+        m_lodDepths[lod] = std::min(m_lodDepths[lod], std::max(glm::distance(cameraPosition, center) - radius, 0.0f));
+    }
+
+    //one draw per lod for all of its instances, they are consecutive in the instance buffer
+    for (uint32_t lod = 0; lod < m_lodInstances.size(); lod++)
+    {
+        auto& bucket = m_lodInstances[lod];
+        if (bucket.empty())
+            continue;
+
+        uint32_t firstIndex = lod == 0 ? primitive.firstIndex : lods[primitive.firstLod + lod].firstIndex;
+        uint32_t indexCount = lod == 0 ? primitive.indexCount : lods[primitive.firstLod + lod].indexCount;
+        m_draws.push_back({ firstIndex, indexCount, primitive.firstVertex, primitive.materialIndex,
+            static_cast<uint32_t>(m_visibleInstances.size()), static_cast<uint32_t>(bucket.size()) });
+        m_drawDepths.push_back(m_lodDepths[lod]);
+        for (uint32_t node : bucket)
+            m_visibleInstances.push_back({ node, primitive.materialIndex });
+
+        if (lod != 0)
+            m_frameStats.simplifiedDraws++;
+    }
+}
+
+void Application::waitForStreaming()
+{
+    auto ready = [this]()
+    {
+        return !m_model.isStreaming() && std::find(m_materialWritten.begin(), m_materialWritten.end(), false) == m_materialWritten.end();
+    };
+
+    while (!ready() && !glfwWindowShouldClose(Renderer::getWindow()))
+    {
+        glfwPollEvents();
+        doFrame();
+    }
+}
+
+double Application::measureGpuTime(uint32_t frames)
+{
+    //the first results still belong to frames recorded before the call
+    for (uint32_t i = 0; i < Device::maxFramesInFlight; i++)
+        doFrame();
+
+    double total = 0.0;
+    uint32_t measured = 0;
+    for (uint32_t i = 0; i < frames && !glfwWindowShouldClose(Renderer::getWindow()); i++)
+    {
+        glfwPollEvents();
+        doFrame();
+        if (m_lastGpuTime >= 0.0)
+        {
+            total += m_lastGpuTime;
+            measured++;
+        }
+    }
+
+    return measured > 0 ? total / measured : 0.0;
+}
+
+void Application::setTextureMaxLod(float maxLod)
+{
+    //samplers are recreated, so nothing may still be using them
+    Renderer::getDevice().handle.waitIdle();
+    m_model.setMaxLod(maxLod);
+
+    std::fill(m_materialWritten.begin(), m_materialWritten.end(), false);
+    std::fill(m_textureWritten.begin(), m_textureWritten.end(), false);
+    writeMaterialDescriptors();
+}
+
+void Application::setBindlessMaterials(bool enabled)
+{
+    if (enabled == m_bindlessMaterials)
+        return;
+
+    Renderer::getDevice().handle.waitIdle();
+    m_bindlessMaterials = enabled;
+
+    m_pipeline.destroy();
+    m_depthPipeline.destroy();
+    createPipeline();
+
+    //the other path's descriptors may not have been written yet
+    std::fill(m_materialWritten.begin(), m_materialWritten.end(), false);
+    writeMaterialDescriptors();
+}
+
+bool Application::setVertexFormat(VertexFormat format)
+{
+    if (format == m_model.getVertexFormat())
+        return true;
+
+    if (m_model.getVertexData().empty())
+    {
+        Log::error("error in Application::setVertexFormat(): the vertices were released after the upload");
+        return false;
+    }
+
+    Renderer::getDevice().handle.waitIdle();
+    m_model.setVertexFormat(format);
+    uploadGeometry();
+
+    m_pipeline.destroy();
+    m_depthPipeline.destroy();
+    createPipeline();
+    return true;
+}
+
+void Application::setParallelRecording(bool enabled, uint32_t threadCount)
+{
+    //the pools may still hold buffers of frames in flight
+    Renderer::getDevice().handle.waitIdle();
+    if (m_parallelRecording)
+        m_parallelRecorder.destroy();
+
+    m_parallelRecording = enabled;
+    if (m_parallelRecording)
+        m_parallelRecorder.create(threadCount);
+}
+
+void Application::setDepthPrepass(bool enabled)
+{
+    if (enabled == m_depthPrepass)
+        return;
+
+    //the main pipeline changes its depth test
+    Renderer::getDevice().handle.waitIdle();
+    m_depthPrepass = enabled;
+
+    m_pipeline.destroy();
+    m_depthPipeline.destroy();
+    createPipeline();
+}
+
+bool Application::setGeometryPlacement(BufferPlacement placement)
+{
+    if (placement == m_geometryPlacement)
+        return true;
+
+    if (m_model.getVertexData().empty())
+    {
+        Log::error("error in Application::setGeometryPlacement(): the vertices were released after the upload");
+        return false;
+    }
+
+    Renderer::getDevice().handle.waitIdle();
+    m_geometryPlacement = placement;
+
+    m_geometryPool.destroy();
+    m_geometryPool.create(geometryPoolVertexBytes, geometryPoolIndexBytes, m_geometryPlacement);
+    m_geometry = GeometryPool::invalidHandle;
+    uploadGeometry();
+    return true;
+}
+
+void Application::uploadGeometry()
+{
+    //a new vertex format changes the stride, so the model gets a new range
+    m_geometryPool.free(m_geometry);
+
+    uint32_t stride = m_model.getVertexDescription().bindingDescription.stride;
+    uint32_t indexSize = m_model.getIndexType() == vk::IndexType::eUint16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    m_geometry = m_geometryPool.allocate(m_model.getVertexStreamSize(), stride, m_model.getIndexStreamSize(), indexSize);
+    if (m_geometry == GeometryPool::invalidHandle)
+        return;
+
+    //the model converts straight into the mapped range, or into staging memory for device local arenas
+    m_model.writeIndexStream(static_cast<uint8_t*>(m_geometryPool.mapIndices(m_geometry)));
+    m_geometryPool.unmapIndices();
+    m_model.writeVertexStream(static_cast<uint8_t*>(m_geometryPool.mapVertices(m_geometry)));
+    m_geometryPool.unmapVertices();
+
+    //staging copies have to finish before the next frame draws from the pool
+    Renderer::getUploadContext().flush();
+}
+
+void Application::createPipeline()
+{
+    m_pipeline.setVertexDescriptionInfo(m_model.getVertexDescription());
+    m_pipeline.setSpecializationConstant(0, m_model.getVertexFormat() == VertexFormat::eQuantized);
+
+    m_pipeline.clearDescriptorLayouts();
+    m_pipeline.addDescriptorLayout(m_descriptorSet.getLayout());
+    if (isBindless())
+    {
+        m_pipeline.addDescriptorLayout(m_bindlessDescriptorSet.getLayout());
+        m_pipeline.setShaderFiles("vert.spv", "frag_bindless.spv");
+    }
+    else
+    {
+        m_pipeline.addDescriptorLayout(m_materialDescriptorSet.getLayout());
+        m_pipeline.setShaderFiles("vert.spv", "frag.spv");
+    }
+    //after the pre-pass every visible pixel already has its final depth, so it is shaded once and depth isn't written again
+    if (m_depthPrepass)
+        m_pipeline.setDepthState(vk::CompareOp::eEqual, false);
+    else
+        m_pipeline.setDepthState(vk::CompareOp::eLessOrEqual, true);
+    m_pipeline.create(m_renderPass, "res/shaders/", Renderer::getSwapchainExtent());
+    if (!m_pipeline.handle && isBindless())
+    {
+        Log::error("error in Application::createPipeline(): no bindless pipeline, materials are bound per draw instead");
+        m_bindlessMaterials = false;
+        m_pipeline.destroy();
+        createPipeline();
+        return;
+    }
+
+    //the vertex buffer is shared, the pre-pass only fetches the position at location 0
+    VertexDescription positionOnly = m_model.getVertexDescription();
+    auto& attributes = positionOnly.attributeDescriptions;
+    attributes.erase(std::remove_if(attributes.begin(), attributes.end(), [](const auto& attribute) { return attribute.location != 0; }), attributes.end());
+
+    m_depthPipeline.setVertexDescriptionInfo(positionOnly);
+    m_depthPipeline.setSpecializationConstant(0, m_model.getVertexFormat() == VertexFormat::eQuantized);
+    m_depthPipeline.clearDescriptorLayouts();
+    m_depthPipeline.addDescriptorLayout(m_descriptorSet.getLayout());
+    m_depthPipeline.addDescriptorLayout(isBindless() ? m_bindlessDescriptorSet.getLayout() : m_materialDescriptorSet.getLayout());
+    m_depthPipeline.setShaderFiles("depth_vert.spv", "");
+    m_depthPipeline.create(m_renderPass, "res/shaders/", Renderer::getSwapchainExtent());
+
+    //the main pipeline only tests for equal depth, so without the pre-pass it has to write depth again
+    if (!m_depthPipeline.handle && m_depthPrepass)
+    {
+        Log::error("error in Application::createPipeline(): no depth pipeline, the pre-pass is disabled");
+        m_depthPrepass = false;
+        m_pipeline.destroy();
+        m_depthPipeline.destroy();
+        createPipeline();
+    }
 }
 
 void Application::updateUniforms()
@@ -113,28 +884,66 @@ void Application::updateUniforms()
     }
 
     ShaderMatrixInfo info;
-    info.model = m_model.getModelMatrix();
     info.view = m_camera.getViewMatrix();
     info.proj = m_camera.getProjMatrix();
-    info.normal = glm::mat3(glm::transpose(glm::inverse(m_model.getModelMatrix())));
     info.lightPos = { lightPos.x, lightPos.y, lightPos.z, 0.0f };
     info.cameraPos = { cameraPos, 0.0f };
+    info.positionOffset = m_model.getPositionDequantization().offset;
+    info.positionScale = m_model.getPositionDequantization().scale;
+
+    m_matrixOffset = m_frameAllocator.push(info);
+}
+
+void Application::updateTransforms()
+{
+    SceneGraph& sceneGraph = m_model.getSceneGraph();
+    sceneGraph.update();
+
+    //nodes that moved since the matrices were last computed, all of them on the first call
+    if (m_transformsVersion != sceneGraph.getVersion())
+    {
+        for (uint32_t node = 0; node < sceneGraph.size(); node++)
+        {
+            if (sceneGraph.getNodeVersion(node) <= m_transformsVersion)
+                continue;
 
-    m_uniformBuffers[Renderer::getCurrentFrameIndex()].mapMemory<ShaderMatrixInfo>(info);
+            const glm::mat4& world = sceneGraph.getWorldMatrix(node);
+            m_transforms[node].model = world;
+            m_transforms[node].normal = glm::mat4(glm::transpose(glm::inverse(glm::mat3(world))));
+        }
+        m_transformsVersion = sceneGraph.getVersion();
+    }
+
+    //every frame in flight owns a copy, it is rewritten when the graph changed since that frame last used it
+    uint32_t frame = Renderer::getCurrentFrameIndex();
+    if (m_transformVersions[frame] != sceneGraph.getVersion())
+    {
+        m_transformBuffers[frame].mapMemory(DataView<ShaderTransform>(m_transforms));
+        m_transformVersions[frame] = sceneGraph.getVersion();
+    }
 }
 
 void Application::setupDescriptors()
 {
-    m_descriptorSet.addBinding(vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0);
+    //per frame data comes from the frame allocator, the bindings are moved to it with dynamic offsets
+    m_descriptorSet.addBinding(vk::DescriptorType::eUniformBufferDynamic, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0);
     m_descriptorSet.addBinding(vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment, 1);
+    m_descriptorSet.addBinding(vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eVertex, 2);
+    m_descriptorSet.addBinding(vk::DescriptorType::eStorageBufferDynamic, vk::ShaderStageFlagBits::eVertex, 3);
 
-    m_descriptorSet.addPoolSize(vk::DescriptorType::eUniformBuffer, m_uniformBuffers.size());
+    m_descriptorSet.addPoolSize(vk::DescriptorType::eUniformBufferDynamic, m_transformBuffers.size());
     m_descriptorSet.addPoolSize(vk::DescriptorType::eCombinedImageSampler, 1);
+    m_descriptorSet.addPoolSize(vk::DescriptorType::eStorageBuffer, m_transformBuffers.size());
+    m_descriptorSet.addPoolSize(vk::DescriptorType::eStorageBufferDynamic, m_transformBuffers.size());
 
     m_descriptorSet.create();
 
-    for (int i = 0; i < m_uniformBuffers.size(); i++)
-        m_descriptorSet.writeDescriptor(m_uniformBuffers[i], 0, i);
+    for (int i = 0; i < m_transformBuffers.size(); i++)
+    {
+        m_descriptorSet.writeDescriptor(m_frameAllocator.getDescriptor(vk::DescriptorType::eUniformBufferDynamic, sizeof(ShaderMatrixInfo)), 0, i);
+        m_descriptorSet.writeDescriptor(m_transformBuffers[i], 2, i);
+        m_descriptorSet.writeDescriptor(m_frameAllocator.getDescriptor(vk::DescriptorType::eStorageBufferDynamic, m_instanceRange), 3, i);
+    }
 
     //m_descriptorSet.writeDescriptor(Renderer::getDepthTexture(), 1);
 
@@ -146,11 +955,80 @@ void Application::setupDescriptors()
     m_materialDescriptorSet.addPoolSize(vk::DescriptorType::eCombinedImageSampler, m_model.getMaterials().size());
     m_materialDescriptorSet.create();
 
+    m_materialWritten.resize(m_model.getMaterials().size(), false);
+
+    if (Renderer::getDevice().supportsBindless())
+        setupBindlessDescriptors();
+
+    writeMaterialDescriptors();
+}
+
+void Application::setupBindlessDescriptors()
+{
+    uint32_t textureCount = static_cast<uint32_t>(std::max<size_t>(m_model.getTextureCount(), 1));
+    if (textureCount > Renderer::getDevice().getMaxBindlessTextures())
+        Log::error("error in Application::setupBindlessDescriptors(): {} textures exceed the device limit of {}", textureCount,
+            Renderer::getDevice().getMaxBindlessTextures());
+
+    //textures are written as they finish streaming, while frames using the set are in flight
+    vk::DescriptorBindingFlags textureFlags = vk::DescriptorBindingFlagBits::ePartiallyBound
+        | vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+    m_bindlessDescriptorSet.addBinding(vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment, 0, textureCount, textureFlags);
+    m_bindlessDescriptorSet.addBinding(vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eFragment, 1);
+    m_bindlessDescriptorSet.addPoolSize(vk::DescriptorType::eCombinedImageSampler, textureCount);
+    m_bindlessDescriptorSet.addPoolSize(vk::DescriptorType::eStorageBuffer, 1);
+    m_bindlessDescriptorSet.setSetCount(1);
+    m_bindlessDescriptorSet.create();
+    m_textureWritten.resize(textureCount, false);
+
+    std::vector<ShaderMaterial> materials;
+    for (auto& material : m_model.getMaterials())
+    {
+        glm::vec4 factors(material.metallicFactor, material.roughnessFactor, 0.0f, 0.0f);
+        materials.push_back({ material.albedoIndex, material.normalIndex, material.metallicRoughnessIndex, 0, material.baseColorFactor, factors });
+    }
+    if (materials.empty())
+        materials.push_back({});
+
+    m_materialBuffer.setName("materials");
+    m_materialBuffer.create(sizeof(ShaderMaterial) * materials.size(), BufferIntent::eStatic);
+    m_materialBuffer.mapMemory(DataView<ShaderMaterial>(materials));
+    Renderer::getUploadContext().flush();
+
+    m_bindlessDescriptorSet.writeDescriptor(m_materialBuffer, 1, 0);
+}
+
+void Application::writeMaterialDescriptors()
+{
+    //a set is only written once, so it is never updated while a frame in flight uses it
     auto& materials = m_model.getMaterials();
     for (int i = 0; i < materials.size(); i++)
     {
+        if (m_materialWritten[i] || !m_model.isMaterialReady(i))
+            continue;
+
+        if (isBindless())
+        {
+            //adding a material only writes the array elements of textures no other material wrote yet
+            writeBindlessTexture(*materials[i].albedo, materials[i].albedoIndex);
+            writeBindlessTexture(*materials[i].normal, materials[i].normalIndex);
+            writeBindlessTexture(*materials[i].metallicRoughness, materials[i].metallicRoughnessIndex);
+            m_materialWritten[i] = true;
+            continue;
+        }
+
         m_materialDescriptorSet.writeDescriptor(*materials[i].albedo, 0, i);
         m_materialDescriptorSet.writeDescriptor(*materials[i].normal, 1, i);
         m_materialDescriptorSet.writeDescriptor(*materials[i].metallicRoughness, 2, i);
+        m_materialWritten[i] = true;
     }
+}
+
+void Application::writeBindlessTexture(const Texture& texture, uint32_t index)
+{
+    if (m_textureWritten[index])
+        return;
+
+    m_bindlessDescriptorSet.writeDescriptor(texture, 0, 0, index);
+    m_textureWritten[index] = true;
 }
\ No newline at end of file
@@ -2,38 +2,205 @@
 
 #include "framework/Renderer.h"
 
-#include "framework/buffer/VertexBuffer.h"
-#include "framework/buffer/IndexBuffer.h"
-#include "framework/buffer/UniformBuffer.h"
+#include "framework/buffer/GeometryPool.h"
+#include "framework/buffer/FrameAllocator.h"
+#include "framework/buffer/StorageBuffer.h"
 
 #include "framework/rendering/DescriptorSet.h"
+#include "framework/rendering/RenderQueue.h"
+#include "framework/rendering/ParallelRecorder.h"
 
 #include "framework/image/Texture.h"
+#include "framework/debug/GpuTimer.h"
+#include "framework/debug/FrameStats.h"
+#include "framework/culling/ClusterCuller.h"
+#include "framework/culling/PrimitiveCuller.h"
+#include "framework/culling/LodSelector.h"
+#include "framework/culling/OcclusionCuller.h"
 
 #include "Vertex.h"
 #include "framework/Camera.h"
 #include "framework/model/Model.h"
+#include "ShaderMatrixInfo.h"
 
 class Application
 {
 public:
-	Application();
+	/// keepGeometry keeps the imported vertices and indices after the upload, so setVertexFormat() and setGeometryPlacement() can upload them again
+	explicit Application(bool keepGeometry = false);
 	~Application();
 
 	void run();
 	void doFrame();
 	void updateUniforms();
+	/// updates the scene graph and uploads the world matrices of the current frame
+	void updateTransforms();
+
+	/// renders frames until every texture has finished streaming
+	void waitForStreaming();
+	/// renders frames without input and returns the average gpu time of the main render pass
+	double measureGpuTime(uint32_t frames);
+	void setTextureMaxLod(float maxLod);
+	/// waits for the gpu, then uploads the vertices again and rebuilds the pipeline for the new layout.
+	/// returns false if the geometry was released, see Application()
+	bool setVertexFormat(VertexFormat format);
+	/// waits for the gpu, then recreates the geometry pool in the given memory, eAuto picks it from the device.
+	/// returns false if the geometry was released, see Application()
+	bool setGeometryPlacement(BufferPlacement placement);
+	BufferPlacement getGeometryPlacement() const { return m_geometryPool.getPlacement(); }
+	const Model& getModel() const { return m_model; }
+	/// skips primitive instances whose bounding box or sphere is outside the frustum
+	void setFrustumCulling(bool enabled) { m_frustumCulling = enabled; }
+	/// draws only the meshlets inside the frustum that face the camera, otherwise every primitive
+	void setClusterCulling(bool enabled) { m_clusterCulling = enabled; }
+	/// projected lod error in pixels, 0 always draws the original geometry
+	void setLodThreshold(float pixels) { m_lodSelector.setThreshold(pixels); }
+	/// records the draw list as one multi draw indirect call per material instead of a drawIndexed per draw,
+	/// ignored if the device doesn't support multi draw indirect
+	void setIndirectDraws(bool enabled) { m_indirectDraws = enabled; }
+	bool isIndirectDrawing() const { return m_indirectDraws && Renderer::getDevice().supportsMultiDrawIndirect(); }
+	/// textures are indexed from one descriptor array instead of binding a set per material, waits for the gpu and rebuilds the pipeline.
+	/// ignored if the device doesn't support descriptor indexing
+	void setBindlessMaterials(bool enabled);
+	bool isBindless() const { return m_bindlessMaterials && Renderer::getDevice().supportsBindless(); }
+	/// culls and draws on the gpu: what was visible last frame is drawn first, its depth is reduced into a pyramid and the rest of the frustum
+	/// is drawn if it isn't behind it. draws the original geometry of every object without cluster culling or lods.
+	/// ignored without bindless materials, draw indirect count or the culling shaders
+	void setOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; m_occlusionCuller.resetVisibility(); }
+	bool isOcclusionCulling() const { return m_occlusionCulling && isBindless() && m_occlusionCuller.isValid(); }
+	/// draws every draw's depth with a position only pipeline first, the main pass then shades each pixel once with an equal depth test.
+	/// waits for the gpu and rebuilds the pipelines, stays off if the depth shader couldn't be loaded
+	void setDepthPrepass(bool enabled);
+	bool isDepthPrepass() const { return m_depthPrepass; }
+	const FrameStats& getFrameStats() const { return m_frameStats; }
+	/// cpu time spent building and recording the draws of the last frame
+	double getLastRecordTime() const { return m_lastRecordTime; }
+	/// the part of getLastRecordTime() spent recording draw commands, after the draw list was built
+	double getLastDrawRecordTime() const { return m_lastDrawRecordTime; }
+	/// records the draws on worker threads into secondary command buffers, threadCount of 0 uses one thread per hardware thread.
+	/// waits for the gpu. only direct draws are split, a few indirect calls aren't worth a thread
+	void setParallelRecording(bool enabled, uint32_t threadCount = 0);
+	bool isParallelRecording() const { return m_parallelRecording && !isIndirectDrawing(); }
+	/// appends the memory stats to path.csv every interval frames and writes path.json on exit, 0 disables it
+	void setMemoryDump(const std::string& path, uint32_t interval);
+	Camera& getCamera() { return m_camera; }
 private:
+	/// builds the draw list on the cpu and draws it in one render pass
+	void recordFrame(vk::CommandBuffer commandBuffer);
+	/// only clears and presents, for frames whose data didn't fit into the frame allocator
+	void recordEmptyFrame(vk::CommandBuffer commandBuffer);
+	/// both phases of the occlusion culling with the depth pyramid between them
+	void recordOcclusionCulledFrame(vk::CommandBuffer commandBuffer);
+	void recordOcclusionPhase(vk::CommandBuffer commandBuffer, RenderPass& renderPass, OcclusionPhase phase, uint32_t instanceOffset);
+	/// one cull object and one instance per primitive instance, in the order of the primitive culler
+	void buildCullObjects(uint32_t baseIndex, int32_t baseVertex);
+	void buildDrawList();
+	/// sorts the draws whose material is ready by material, then front to back
+	void buildRenderQueue();
+	/// writes the render queue into m_indirectCommands, one batch per run of the same material
+	void buildIndirectCommands(uint32_t baseIndex, int32_t baseVertex);
+	/// writes the pre-pass queue into m_prepassCommands
+	void buildPrepassCommands(uint32_t baseIndex, int32_t baseVertex);
+	/// front to back order of the draws for the pre-pass, the render queue itself is only front to back with bindless materials
+	const RenderQueue& getPrepassQueue() const { return isBindless() ? m_renderQueue : m_depthQueue; }
+	/// binds the pipeline, the geometry and the frame's descriptor sets
+	void bindFrameState(vk::CommandBuffer commandBuffer, uint32_t instanceOffset, FrameStats& stats);
+	/// draws count packets of the render queue starting at first, stats are passed in so slices can be recorded in parallel
+	void recordDirectDraws(vk::CommandBuffer commandBuffer, uint32_t baseIndex, int32_t baseVertex, uint32_t first, uint32_t count, FrameStats& stats);
+	void recordDepthDraws(vk::CommandBuffer commandBuffer, uint32_t baseIndex, int32_t baseVertex, uint32_t first, uint32_t count, FrameStats& stats);
+	/// the pre-pass and the direct draws split into slices on m_parallelRecorder
+	void recordParallelDraws(vk::CommandBuffer commandBuffer, uint32_t baseIndex, int32_t baseVertex, uint32_t instanceOffset);
+	/// commandOffset is where the commands of buildIndirectCommands() were pushed into the frame allocator
+	void recordIndirectDraws(vk::CommandBuffer commandBuffer, uint32_t commandOffset);
+	/// depth of the pre-pass queue with m_depthPipeline, leaves m_pipeline bound
+	void recordDepthPrepass(vk::CommandBuffer commandBuffer, uint32_t baseIndex, int32_t baseVertex, uint32_t commandOffset);
+	/// groups the visible instances of a primitive with more than one instance by lod and emits one instanced draw per lod
+	void appendInstancedDraws(uint32_t primitiveIndex);
+	/// gives the model a new range of the geometry pool and writes its vertices and indices into it
+	void uploadGeometry();
+	void createPipeline();
 	void setupDescriptors();
+	void setupBindlessDescriptors();
+	void writeMaterialDescriptors();
+	void writeBindlessTexture(const Texture& texture, uint32_t index);
 private:
-	VertexBuffer<Vertex> m_vertexBuffer;
-	IndexBuffer m_indexBuffer;
-	std::vector<UniformBuffer> m_uniformBuffers;
+	//initial arena sizes, the pool grows when models don't fit
+	static constexpr vk::DeviceSize geometryPoolVertexBytes = 256 * 1024 * 1024;
+	static constexpr vk::DeviceSize geometryPoolIndexBytes = 128 * 1024 * 1024;
+	GeometryPool m_geometryPool;
+	GeometryHandle m_geometry = GeometryPool::invalidHandle;
+	BufferPlacement m_geometryPlacement = BufferPlacement::eAuto;
+	//uniforms and other data rewritten every frame
+	static constexpr vk::DeviceSize frameAllocatorBytes = 4 * 1024 * 1024;
+	FrameAllocator m_frameAllocator;
+	uint32_t m_matrixOffset = 0;
+	std::vector<StorageBuffer> m_transformBuffers;
+	//scene graph version each transform buffer was last written with
+	std::vector<uint64_t> m_transformVersions;
+	std::vector<ShaderTransform> m_transforms;
+	uint64_t m_transformsVersion = 0;
+	//scene graph node of every instance drawn this frame, draws reference ranges of it
+	std::vector<ShaderInstance> m_visibleInstances;
+	vk::DeviceSize m_instanceRange = 0;
+	//instances of an instanced primitive grouped by their lod
+	std::vector<std::vector<uint32_t>> m_lodInstances;
 
 	DescriptorSet m_descriptorSet;
 	DescriptorSet m_materialDescriptorSet;
+	std::vector<bool> m_materialWritten;
+	//bindless path: every texture of the model in one array, materials reference them from a storage buffer
+	bool m_bindlessMaterials = true;
+	DescriptorSet m_bindlessDescriptorSet;
+	StorageBuffer m_materialBuffer;
+	std::vector<bool> m_textureWritten;
 	Pipeline m_pipeline;
+	//position only, shares the descriptor layouts of m_pipeline so the bound sets stay valid between them
+	Pipeline m_depthPipeline;
+	bool m_depthPrepass = false;
+	bool m_prepassKeyDown = false;
 	RenderPass m_renderPass;
+	//the early pass of the occlusion culling clears and the late pass presents, both use the framebuffers of m_renderPass
+	RenderPass m_earlyRenderPass;
+	RenderPass m_lateRenderPass;
 	Camera m_camera;
+	GpuTimer m_gpuTimer;
+	double m_lastGpuTime = -1.0;
+	double m_lastRecordTime = 0.0;
+	double m_lastDrawRecordTime = 0.0;
+	ParallelRecorder m_parallelRecorder;
+	bool m_parallelRecording = false;
+	//draw counters of every slice, merged into m_frameStats after recording
+	std::vector<FrameStats> m_sliceStats;
+	PrimitiveCuller m_primitiveCuller;
+	bool m_frustumCulling = true;
+	ClusterCuller m_clusterCuller;
+	bool m_clusterCulling = true;
+	LodSelector m_lodSelector;
+	OcclusionCuller m_occlusionCuller;
+	//replaces the cpu draw list with its toggles, so it is opt-in
+	bool m_occlusionCulling = false;
+	std::vector<ShaderCullObject> m_cullObjects;
+	std::vector<DrawRange> m_draws;
+	//distance from the camera to the nearest point of every draw's bounds
+	std::vector<float> m_drawDepths;
+	//nearest instance of every lod bucket of an instanced primitive
+	std::vector<float> m_lodDepths;
+	RenderQueue m_renderQueue;
+	//the draws of the render queue sorted by depth alone, only built for the pre-pass without bindless
+	RenderQueue m_depthQueue;
+	//commands of one material are contiguous, so a batch is drawn with a single drawIndexedIndirect
+	struct DrawBatch
+	{
+		uint32_t materialIndex;
+		uint32_t firstCommand;
+		uint32_t commandCount;
+	};
+	bool m_indirectDraws = true;
+	std::vector<vk::DrawIndexedIndirectCommand> m_indirectCommands;
+	std::vector<DrawBatch> m_drawBatches;
+	std::vector<vk::DrawIndexedIndirectCommand> m_prepassCommands;
+	FrameStats m_frameStats;
+	std::string m_memoryDumpPath;
+	uint32_t m_memoryDumpInterval = 0;
 	Model m_model;
 };
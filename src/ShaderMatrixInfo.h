@@ -2,12 +2,69 @@
 
 #include <glm/mat4x4.hpp>
 
+#include <cstdint>
+
 struct ShaderMatrixInfo
 {
-	glm::mat4 model;
 	glm::mat4 view;
 	glm::mat4 proj;
-	glm::mat4 normal;
 	glm::vec4 lightPos;
 	glm::vec4 cameraPos;
+	//position = positionOffset + quantized * positionScale, identity for float vertices
+	glm::vec4 positionOffset = glm::vec4(0.0f);
+	glm::vec4 positionScale = glm::vec4(1.0f);
+};
+
+//one per scene graph node, indexed with gl_InstanceIndex in shader.vert
+struct ShaderTransform
+{
+	glm::mat4 model;
+	glm::mat4 normal;
+};
+
+//one per instance drawn in a frame, read with gl_InstanceIndex in shader.vert
+struct ShaderInstance
+{
+	uint32_t node;
+	uint32_t material;
+};
+
+//material of the bindless path, indices into the texture array of shader_bindless.frag
+struct ShaderMaterial
+{
+	uint32_t albedo;
+	uint32_t normal;
+	uint32_t metallicRoughness;
+	uint32_t padding = 0;
+	glm::vec4 baseColorFactor;
+	//x metallic, y roughness
+	glm::vec4 metallicRoughnessFactor;
+};
+
+//one per object of the gpu occlusion culling, read by occlusion_cull.comp
+struct ShaderCullObject
+{
+	//world space center and radius
+	glm::vec4 sphere;
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t instance;
+};
+
+//view of the frame for occlusion_cull.comp
+struct ShaderCullData
+{
+	glm::mat4 view;
+	//world space frustum planes, see Frustum
+	glm::vec4 planes[6];
+	//x proj[0][0], y proj[1][1], z proj[2][2], w proj[3][2]
+	glm::vec4 projection;
+	float nearDistance;
+	uint32_t objectCount;
+	//first command of the late phase
+	uint32_t lateCommandOffset;
+	uint32_t padding = 0;
+	uint32_t pyramidWidth;
+	uint32_t pyramidHeight;
 };
\ No newline at end of file
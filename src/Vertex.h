@@ -2,10 +2,39 @@
 
 #include <glm/glm.hpp>
 
+#include "framework/buffer/VertexLayout.h"
+
+enum class VertexFormat : uint32_t
+{
+	eFloat,
+	eQuantized
+};
+
 struct Vertex
 {
 	glm::vec3 position;
 	glm::vec3 normal;
 	glm::vec2 texCoord;
 	glm::vec4 tangent;
+
+	static VertexDescription getDescription()
+	{
+		return makeVertexDescription(&Vertex::position, &Vertex::normal, &Vertex::texCoord, &Vertex::tangent);
+	}
+};
+
+//20 bytes instead of 48, decoded in shader.vert
+struct QuantizedVertex
+{
+	//xyz normalized to the model bounds, w is the tangent handedness: 0 for -1, 1 for +1, 0.5 without a tangent
+	Unorm16x4 position;
+	//octahedral encoded
+	Snorm16x2 normal;
+	Snorm16x2 tangent;
+	Half2 texCoord;
+
+	static VertexDescription getDescription()
+	{
+		return makeVertexDescription(&QuantizedVertex::position, &QuantizedVertex::normal, &QuantizedVertex::texCoord, &QuantizedVertex::tangent);
+	}
 };
\ No newline at end of file
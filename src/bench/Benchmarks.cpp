@@ -0,0 +1,496 @@
+#include "Benchmarks.h"
+
+#include "Application.h"
+#include "framework/culling/PrimitiveCuller.h"
+#include "framework/model/Model.h"
+#include "framework/utils/Log.h"
+#include "framework/utils/Timer.h"
+#include "framework/utils/Utils.h"
+
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <random>
+#include <cstdio>
+
+namespace
+{
+	struct Result
+	{
+		double average = 0.0;
+		double min = 0.0;
+		double max = 0.0;
+	};
+
+	template<typename F>
+	Result measure(uint32_t iterations, F&& func)
+	{
+		std::vector<double> times;
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			Timer timer;
+			func();
+			times.push_back(timer.elapsedMs());
+		}
+
+		Result result;
+		for (double time : times)
+			result.average += time;
+		result.average /= std::max<size_t>(times.size(), 1);
+		result.min = *std::min_element(times.begin(), times.end());
+		result.max = *std::max_element(times.begin(), times.end());
+		return result;
+	}
+}
+
+void bench::modelLoad(const std::string& filename, uint32_t iterations)
+{
+	iterations = std::max(iterations, 1u);
+
+	//textures are loaded the same way in both paths, so only the geometry import is measured
+	ModelLoadOptions coldOptions;
+	coldOptions.useMeshCache = false;
+	coldOptions.loadTextures = false;
+
+	ModelLoadOptions warmOptions;
+	warmOptions.useMeshCache = true;
+	warmOptions.loadTextures = false;
+
+	size_t vertexCount = 0;
+	size_t indexBytes = 0;
+	bool shortIndices = false;
+	auto load = [&](const ModelLoadOptions& options)
+	{
+		Model model;
+		model.loadFromDisk(filename, options);
+		vertexCount = model.getVertexData().size();
+		indexBytes = model.getIndexStreamSize();
+		shortIndices = model.getIndexType() == vk::IndexType::eUint16;
+		model.destroy();
+	};
+
+	//make sure a valid cache exists before the warm runs
+	std::remove(MeshCache::getPath(filename).c_str());
+	load(warmOptions);
+
+	Result cold = measure(iterations, [&]() { load(coldOptions); });
+	Result warm = measure(iterations, [&]() { load(warmOptions); });
+
+	Log::info("--model load benchmark: {} ({} iterations)--", filename, iterations);
+	Log::info("gltf:       avg {:.2f} ms, min {:.2f} ms, max {:.2f} ms", cold.average, cold.min, cold.max);
+	Log::info("mesh cache: avg {:.2f} ms, min {:.2f} ms, max {:.2f} ms", warm.average, warm.min, warm.max);
+	Log::info("speedup:    {:.1f}x", cold.average / std::max(warm.average, 0.001));
+	Log::info("throughput: gltf {:.2f} M vertices/s, mesh cache {:.2f} M vertices/s", vertexCount / std::max(cold.average, 0.001) / 1000.0,
+		vertexCount / std::max(warm.average, 0.001) / 1000.0);
+	Log::info("indices:    {} bit, {:.2f} MB", shortIndices ? 16 : 32, indexBytes / (1024.0 * 1024.0));
+	Log::info("peak rss:   {:.1f} MB", utils::getPeakMemoryUsage() / (1024.0 * 1024.0));
+}
+
+void bench::textureLoad(const std::string& filename, uint32_t iterations)
+{
+	iterations = std::max(iterations, 1u);
+	uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	std::vector<Result> results;
+	for (uint32_t threads : threadCounts)
+	{
+		ModelLoadOptions options;
+		options.textureThreadCount = threads;
+
+		results.push_back(measure(iterations, [&]()
+		{
+			Model model;
+			model.loadFromDisk(filename, options);
+			model.destroy();
+		}));
+	}
+
+	Log::info("--texture load benchmark: {} ({} iterations)--", filename, iterations);
+	for (size_t i = 0; i < threadCounts.size(); i++)
+	{
+		Log::info("{:>2} threads: avg {:.2f} ms, min {:.2f} ms, speedup {:.2f}x",
+			threadCounts[i], results[i].average, results[i].min, results[0].average / std::max(results[i].average, 0.001));
+	}
+}
+
+void bench::mipFragmentTime(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	Application app;
+	app.waitForStreaming();
+
+	app.setTextureMaxLod(VK_LOD_CLAMP_NONE);
+	double withMips = app.measureGpuTime(frames);
+
+	app.setTextureMaxLod(0.0f);
+	double withoutMips = app.measureGpuTime(frames);
+
+	Log::info("--mip fragment benchmark ({} frames)--", frames);
+	Log::info("with mips:    {:.3f} ms", withMips);
+	Log::info("without mips: {:.3f} ms", withoutMips);
+	Log::info("speedup:      {:.2f}x", withoutMips / std::max(withMips, 0.001));
+}
+
+void bench::vertexFormat(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	//the vertices are uploaded again in every format
+	Application app(true);
+	app.waitForStreaming();
+
+	size_t drawnIndices = 0;
+	for (auto& primitive : app.getModel().getMesh())
+		drawnIndices += size_t(primitive.indexCount) * primitive.instanceCount;
+
+	Log::info("--vertex format benchmark ({} frames)--", frames);
+	for (VertexFormat format : { VertexFormat::eFloat, VertexFormat::eQuantized })
+	{
+		if (!app.setVertexFormat(format))
+		{
+			Log::error("error in bench::vertexFormat(): failed to switch the vertex format");
+			return;
+		}
+		double gpuTime = app.measureGpuTime(frames);
+
+		uint32_t stride = app.getModel().getVertexDescription().bindingDescription.stride;
+		double bufferMb = app.getModel().getVertexStreamSize() / (1024.0 * 1024.0);
+		//upper bound, every index fetches its vertex without hitting the post transform cache
+		double fetchedMb = drawnIndices * stride / (1024.0 * 1024.0);
+
+		Log::info("{:9}: stride {:2} bytes, vertex buffer {:.2f} MB, fetched {:.2f} MB per frame, gpu {:.3f} ms",
+			format == VertexFormat::eFloat ? "float" : "quantized", stride, bufferMb, fetchedMb, gpuTime);
+	}
+}
+
+void bench::clusterCulling(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	Application app;
+	app.waitForStreaming();
+
+	Log::info("--cluster culling benchmark ({} frames)--", frames);
+	app.setLodThreshold(0.0f);
+	for (float yaw : { 0.0f, 90.0f, 180.0f, 270.0f })
+	{
+		app.getCamera().getRotation() = { yaw, 0.0f };
+		app.getCamera().updateMatrices();
+
+		app.setClusterCulling(false);
+		double gpuTimeAll = app.measureGpuTime(frames);
+		FrameStats all = app.getFrameStats();
+
+		app.setClusterCulling(true);
+		double gpuTimeCulled = app.measureGpuTime(frames);
+		FrameStats culled = app.getFrameStats();
+
+		Log::info("yaw {:3.0f}: triangles {} -> {} ({:.1f}%), draws {} -> {}, meshlets {}/{}, gpu {:.3f} -> {:.3f} ms",
+			yaw, all.triangles, culled.triangles, 100.0 * culled.triangles / std::max<uint64_t>(all.triangles, 1),
+			all.drawCalls, culled.drawCalls, culled.clustersVisible, culled.clustersTested, gpuTimeAll, gpuTimeCulled);
+	}
+}
+
+void bench::lodSelection(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	Application app;
+	app.waitForStreaming();
+
+	//looking down the long side of the atrium, most geometry is far away
+	app.getCamera().getPosition() = { -9.0f, 1.0f, -0.5f };
+	app.getCamera().getRotation() = { 0.0f, 0.0f };
+	app.getCamera().updateMatrices();
+
+	Log::info("--lod benchmark ({} frames)--", frames);
+	for (float threshold : { 0.0f, 0.5f, 1.0f, 2.0f, 4.0f })
+	{
+		app.setLodThreshold(threshold);
+		double gpuTime = app.measureGpuTime(frames);
+		const FrameStats& stats = app.getFrameStats();
+
+		Log::info("threshold {:.1f} px: {} triangles, {} draws, {} simplified, gpu {:.3f} ms",
+			threshold, stats.triangles, stats.drawCalls, stats.simplifiedDraws, gpuTime);
+	}
+}
+
+void bench::bufferPlacement(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	//the geometry is uploaded again into every placement
+	Application app(true);
+	app.waitForStreaming();
+
+	//everything is drawn at full detail, so the pass is bound by vertex fetch as much as possible
+	app.setClusterCulling(false);
+	app.setLodThreshold(0.0f);
+
+	Log::info("--buffer placement benchmark ({} frames)--", frames);
+	for (BufferPlacement placement : { BufferPlacement::eDeviceLocal, BufferPlacement::eDeviceHostVisible, BufferPlacement::eHost })
+	{
+		if (!app.setGeometryPlacement(placement))
+		{
+			Log::error("error in bench::bufferPlacement(): failed to upload the geometry again");
+			return;
+		}
+		if (app.getGeometryPlacement() != placement)
+		{
+			Log::info("{:25}: not available, placed in {}", getName(placement), getName(app.getGeometryPlacement()));
+			continue;
+		}
+
+		double gpuTime = app.measureGpuTime(frames);
+		const FrameStats& stats = app.getFrameStats();
+		//upper bound, every index counts as a vertex shader invocation
+		double vertices = stats.triangles * 3.0;
+
+		Log::info("{:25}: {} vertices, gpu {:.3f} ms, {:.1f} M vertices/s", getName(placement), stats.triangles * 3, gpuTime,
+			vertices / std::max(gpuTime, 0.001) / 1000.0);
+	}
+}
+
+void bench::indirectDraws(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	Application app;
+	app.waitForStreaming();
+	if (!Renderer::getDevice().supportsMultiDrawIndirect())
+	{
+		Log::info("multi draw indirect not supported");
+		return;
+	}
+
+	Log::info("--indirect draw benchmark ({} frames)--", frames);
+	app.setLodThreshold(0.0f);
+	//meshlet culling splits primitives into many small draws, without it there is one draw per primitive
+	for (bool culling : { false, true })
+	{
+		app.setClusterCulling(culling);
+		for (bool indirect : { false, true })
+		{
+			app.setIndirectDraws(indirect);
+			double gpuTime = app.measureGpuTime(frames);
+
+			double recordTime = 0.0;
+			for (uint32_t i = 0; i < frames; i++)
+			{
+				app.doFrame();
+				recordTime += app.getLastRecordTime();
+			}
+			const FrameStats& stats = app.getFrameStats();
+
+			Log::info("culling {:3}, {:8}: {} draws in {} calls, cpu record {:.3f} ms, gpu {:.3f} ms", culling ? "on" : "off",
+				indirect ? "indirect" : "direct", stats.drawCalls, stats.recordedDrawCalls, recordTime / frames, gpuTime);
+		}
+	}
+}
+
+void bench::bindlessMaterials(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	Application app;
+	app.waitForStreaming();
+	if (!Renderer::getDevice().supportsBindless())
+	{
+		Log::info("descriptor indexing not supported");
+		return;
+	}
+
+	Log::info("--bindless material benchmark ({} frames)--", frames);
+	for (bool indirect : { false, true })
+	{
+		app.setIndirectDraws(indirect);
+		for (bool bindless : { false, true })
+		{
+			app.setBindlessMaterials(bindless);
+			//the other path's descriptors are written again in the first frame
+			app.waitForStreaming();
+			double gpuTime = app.measureGpuTime(frames);
+
+			double recordTime = 0.0;
+			for (uint32_t i = 0; i < frames; i++)
+			{
+				app.doFrame();
+				recordTime += app.getLastRecordTime();
+			}
+			const FrameStats& stats = app.getFrameStats();
+
+			Log::info("{:8}, {:8}: {} draws, {} calls, {} descriptor binds ({} saved by sorting), cpu record {:.3f} ms, gpu {:.3f} ms",
+				indirect ? "indirect" : "direct", bindless ? "bindless" : "per set", stats.drawCalls, stats.recordedDrawCalls, stats.descriptorBinds,
+				stats.bindsSaved, recordTime / frames, gpuTime);
+		}
+	}
+}
+
+void bench::frustumCulling(uint32_t iterations)
+{
+	iterations = std::max(iterations, 1u);
+
+	Camera camera;
+	camera.getPosition() = { 0.0f, 0.0f, 0.0f };
+	camera.getRotation() = { 0.0f, 0.0f };
+	camera.updateMatrices();
+	Frustum frustum = Frustum::fromMatrix(camera.getProjMatrix() * camera.getViewMatrix());
+
+	Log::info("--frustum culling benchmark ({} iterations)--", iterations);
+	for (uint32_t objectCount : { 10000u, 100000u, 1000000u })
+	{
+		//boxes scattered around the camera, about a quarter of them end up inside the frustum
+		std::mt19937 random(objectCount);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		std::uniform_real_distribution<float> size(0.1f, 10.0f);
+
+		PrimitiveCuller culler;
+		culler.create(objectCount);
+		std::vector<glm::vec3> centers(objectCount);
+		std::vector<glm::vec3> extents(objectCount);
+		std::vector<float> radii(objectCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			centers[i] = { position(random), position(random), position(random) };
+			extents[i] = { size(random), size(random), size(random) };
+			radii[i] = glm::length(extents[i]);
+			culler.setBounds(i, centers[i], extents[i], radii[i]);
+		}
+
+		Result simd = measure(iterations, [&]() { culler.update(frustum); });
+
+		//the same test one object at a time on an array of structures
+		uint32_t scalarVisible = 0;
+		Result scalar = measure(iterations, [&]()
+		{
+			scalarVisible = 0;
+			for (uint32_t i = 0; i < objectCount; i++)
+				scalarVisible += frustum.isSphereVisible(centers[i], radii[i]) && frustum.isBoxVisible(centers[i], extents[i]);
+		});
+
+		Log::info("{:>7} objects: {} visible, simd {:.3f} ms ({:.1f} M objects/s), scalar {:.3f} ms ({:.1f} M objects/s), speedup {:.2f}x",
+			objectCount, culler.getVisibleCount(), simd.average, objectCount / std::max(simd.average, 0.001) / 1000.0,
+			scalar.average, objectCount / std::max(scalar.average, 0.001) / 1000.0, scalar.average / std::max(simd.average, 0.001));
+		if (scalarVisible != culler.getVisibleCount())
+			Log::warn("scalar culling found {} visible objects", scalarVisible);
+	}
+}
+
+void bench::occlusionCulling(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	Application app;
+	app.waitForStreaming();
+	if (!Renderer::getDevice().supportsDrawIndirectCount() || !app.isBindless())
+	{
+		Log::info("draw indirect count or bindless materials not supported");
+		return;
+	}
+
+	//both sides draw every visible object at full detail, so only the culling differs
+	app.setClusterCulling(false);
+	app.setLodThreshold(0.0f);
+
+	Log::info("--occlusion culling benchmark ({} frames)--", frames);
+	for (float yaw : { 0.0f, 90.0f, 180.0f, 270.0f })
+	{
+		app.getCamera().getRotation() = { yaw, 0.0f };
+		app.getCamera().updateMatrices();
+
+		app.setOcclusionCulling(false);
+		double gpuTimeFrustum = app.measureGpuTime(frames);
+		FrameStats frustum = app.getFrameStats();
+
+		//measureGpuTime() renders the frames in flight first, so the counts read back belong to this viewpoint
+		app.setOcclusionCulling(true);
+		double gpuTimeOcclusion = app.measureGpuTime(frames);
+		FrameStats occlusion = app.getFrameStats();
+
+		Log::info("yaw {:3.0f}: triangles {} -> {} ({:.1f}%), draws {} -> {} ({} late), gpu {:.3f} -> {:.3f} ms",
+			yaw, frustum.triangles, occlusion.triangles, 100.0 * occlusion.triangles / std::max<uint64_t>(frustum.triangles, 1),
+			frustum.drawCalls, occlusion.drawCalls, occlusion.lateDraws, gpuTimeFrustum, gpuTimeOcclusion);
+	}
+}
+
+void bench::depthPrepass(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	Application app;
+	app.waitForStreaming();
+
+	Log::info("--depth pre-pass benchmark ({} frames)--", frames);
+	for (bool occlusion : { false, true })
+	{
+		app.setOcclusionCulling(occlusion);
+		if (occlusion && !app.isOcclusionCulling())
+		{
+			Log::info("occlusion culling not supported");
+			break;
+		}
+
+		for (float yaw : { 0.0f, 90.0f, 180.0f, 270.0f })
+		{
+			app.getCamera().getRotation() = { yaw, 0.0f };
+			app.getCamera().updateMatrices();
+
+			app.setDepthPrepass(false);
+			double gpuTimeSingle = app.measureGpuTime(frames);
+
+			app.setDepthPrepass(true);
+			double gpuTimePrepass = app.measureGpuTime(frames);
+			const FrameStats& stats = app.getFrameStats();
+
+			Log::info("{:9}, yaw {:3.0f}: {} triangles, gpu {:.3f} ms without, {:.3f} ms with pre-pass ({} pre-pass calls)",
+				occlusion ? "occlusion" : "frustum", yaw, stats.triangles, gpuTimeSingle, gpuTimePrepass, stats.prepassDrawCalls);
+		}
+	}
+}
+
+void bench::parallelRecording(uint32_t frames)
+{
+	frames = std::max(frames, 1u);
+
+	Application app;
+	app.waitForStreaming();
+
+	//meshlet culling at full detail gives the most draws, each one recorded with its own drawIndexed
+	app.setIndirectDraws(false);
+	app.setClusterCulling(true);
+	app.setLodThreshold(0.0f);
+
+	uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<uint32_t> threadCounts = { 0 };
+	for (uint32_t threads = 1; threads < hardwareThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(hardwareThreads);
+
+	Log::info("--parallel recording benchmark ({} frames)--", frames);
+	double serialTime = 0.0;
+	for (uint32_t threads : threadCounts)
+	{
+		app.setParallelRecording(threads > 0, threads);
+		app.measureGpuTime(Device::maxFramesInFlight);
+
+		double recordTime = 0.0;
+		for (uint32_t i = 0; i < frames; i++)
+		{
+			app.doFrame();
+			recordTime += app.getLastDrawRecordTime();
+		}
+		recordTime /= frames;
+		if (threads == 0)
+			serialTime = recordTime;
+		const FrameStats& stats = app.getFrameStats();
+
+		Log::info("{:2} threads: {} draws in {} secondary buffers, cpu record {:.3f} ms ({:.2f}x)", threads, stats.drawCalls,
+			stats.secondaryBuffers, recordTime, serialTime / std::max(recordTime, 0.0001));
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+//benchmarks are run from the command line, see main.cpp
+namespace bench
+{
+	void modelLoad(const std::string& filename, uint32_t iterations);
+	void textureLoad(const std::string& filename, uint32_t iterations);
+	/// gpu time of the main pass with the full mip chain and with sampling clamped to mip 0
+	void mipFragmentTime(uint32_t frames);
+	/// vertex buffer size, fetched bytes and gpu time of the main pass for every vertex format
+	void vertexFormat(uint32_t frames);
+	/// submitted triangles and gpu time with and without meshlet culling from a few viewpoints
+	void clusterCulling(uint32_t frames);
+	/// submitted triangles and gpu time for a range of lod error thresholds
+	void lodSelection(uint32_t frames);
+	/// gpu time and vertex throughput of the main pass with the geometry in each buffer placement
+	void bufferPlacement(uint32_t frames);
+	/// cpu recording time, recorded draw calls and gpu time with one drawIndexed per draw and with multi draw indirect
+	void indirectDraws(uint32_t frames);
+	/// descriptor binds, cpu recording time and gpu time with a descriptor set per material and with bindless materials
+	void bindlessMaterials(uint32_t frames);
+	/// throughput of the simd primitive culler and of a scalar loop for 10k to 1m random boxes
+	void frustumCulling(uint32_t iterations);
+	/// drawn triangles, draws and gpu time with cpu frustum culling and with gpu occlusion culling from a few viewpoints
+	void occlusionCulling(uint32_t frames);
+	/// gpu time with and without the depth pre-pass from a few viewpoints, for the cpu draw list and for occlusion culling
+	void depthPrepass(uint32_t frames);
+	/// cpu time recording the direct draws on the main thread and on 1 to n worker threads
+	void parallelRecording(uint32_t frames);
+}
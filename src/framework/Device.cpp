@@ -1,8 +1,11 @@
 #include "Device.h"
 
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 #include "utils/Log.h"
+#include "debug/MemoryStats.h"
 
 #define VMA_IMPLEMENTATION
 #include "vma/vk_mem_alloc.h"
@@ -21,10 +24,24 @@ void Device::create(const std::vector<const char*> validationLayers)
 
 void Device::destroy()
 {
+	MemoryStats::get().destroy();
 	vmaDestroyAllocator(m_allocator);
 	handle.destroy();
 }
 
+void Device::setDebugName(vk::ObjectType type, uint64_t object, const char* name)
+{
+	if (!m_setObjectName || object == 0)
+		return;
+
+	VkDebugUtilsObjectNameInfoEXT nameInfo = {};
+	nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+	nameInfo.objectType = static_cast<VkObjectType>(type);
+	nameInfo.objectHandle = object;
+	nameInfo.pObjectName = name;
+	m_setObjectName(handle, &nameInfo);
+}
+
 vk::Format Device::findDepthFormat()
 {
 	return findSupportedFormat({ vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint },
@@ -70,7 +87,7 @@ void Device::pickPhysicalDevice()
 
 	if (!m_gpu)
 	{
-		Log::critical("failed to find suitable gpu");
+		Log::critical("failed to find suitable gpu, one with timeline semaphores, anisotropic filtering, a swapchain and complete queue families is required");
 		return;
 	}
 }
@@ -80,7 +97,7 @@ void Device::createLogicalDevice(const std::vector<const char*> validationLayers
 	QueueFamilyIndices indices = findQueueFamilies(m_gpu);
 	std::vector<float> priorities = { 1.f };
 	std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value(), indices.transferFamily.value() };
 
 	for (uint32_t queueFamily : uniqueQueueFamilies)
 	{
@@ -91,20 +108,84 @@ void Device::createLogicalDevice(const std::vector<const char*> validationLayers
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	vk::PhysicalDeviceFeatures supported = m_gpu.getFeatures();
 	vk::PhysicalDeviceFeatures features;
 	features.samplerAnisotropy = VK_TRUE;
+	features.multiDrawIndirect = supported.multiDrawIndirect;
+	features.drawIndirectFirstInstance = supported.drawIndirectFirstInstance;
+	m_multiDrawIndirect = supported.multiDrawIndirect && supported.drawIndirectFirstInstance;
+	if (!m_multiDrawIndirect)
+		Log::info("multi draw indirect not supported, primitives are drawn one call at a time");
+
+	//pickPhysicalDevice() only accepts gpus with timeline semaphores
+	auto supportedChain = m_gpu.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+	auto& supported12 = supportedChain.get<vk::PhysicalDeviceVulkan12Features>();
+	vk::PhysicalDeviceVulkan12Features features12;
+	features12.timelineSemaphore = supported12.timelineSemaphore;
+
+	//descriptor indexing for one texture array shared by every material
+	m_drawIndirectCount = m_multiDrawIndirect && supported12.drawIndirectCount;
+	features12.drawIndirectCount = m_drawIndirectCount;
+	if (!m_drawIndirectCount)
+		Log::info("draw indirect count not supported, gpu occlusion culling is disabled");
+
+	m_bindless = supported12.descriptorIndexing && supported12.runtimeDescriptorArray && supported12.descriptorBindingPartiallyBound
+		&& supported12.shaderSampledImageArrayNonUniformIndexing && supported12.descriptorBindingSampledImageUpdateAfterBind
+		&& supported12.descriptorBindingUpdateUnusedWhilePending;
+	if (m_bindless)
+	{
+		features12.descriptorIndexing = VK_TRUE;
+		features12.runtimeDescriptorArray = VK_TRUE;
+		features12.descriptorBindingPartiallyBound = VK_TRUE;
+		features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+
+		auto propertiesChain = m_gpu.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+		auto& properties12 = propertiesChain.get<vk::PhysicalDeviceVulkan12Properties>();
+		m_maxBindlessTextures = std::min(properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+			properties12.maxPerStageDescriptorUpdateAfterBindSampledImages);
+	}
+	else
+	{
+		Log::info("descriptor indexing not supported, materials are bound one descriptor set at a time");
+	}
 
 	vk::DeviceCreateInfo createInfo;
+	createInfo.pNext = &features12;
 	createInfo.setQueueCreateInfos(queueCreateInfos);
 	createInfo.pEnabledFeatures = &features;
 	createInfo.setPEnabledLayerNames(validationLayers);
-	createInfo.setPEnabledExtensionNames(m_extensions);
+
+	std::vector<const char*> extensions = m_extensions;
+	auto availableExtensions = m_gpu.enumerateDeviceExtensionProperties();
+	for (const char* extension : m_optionalExtensions)
+	{
+		bool available = std::any_of(availableExtensions.begin(), availableExtensions.end(),
+			[extension](const vk::ExtensionProperties& properties) { return strcmp(properties.extensionName, extension) == 0; });
+		if (available)
+			extensions.push_back(extension);
+		else
+			Log::info("optional device extension {} not supported", extension);
+	}
+	m_memoryBudget = std::find_if(extensions.begin(), extensions.end(),
+		[](const char* extension) { return strcmp(extension, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0; }) != extensions.end();
+	createInfo.setPEnabledExtensionNames(extensions);
 
 	handle = m_gpu.createDevice(createInfo);
 
+	//only available when the instance enabled debug utils
+	m_setObjectName = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(vkGetDeviceProcAddr(handle, "vkSetDebugUtilsObjectNameEXT"));
+
 	//after logical device is created we can get the vkQueue objects
 	m_graphicsQueue = handle.getQueue(indices.graphicsFamily.value(), 0);
 	m_presentQueue = handle.getQueue(indices.presentFamily.value(), 0);
+	m_transferQueue = handle.getQueue(indices.transferFamily.value(), 0);
+
+	if (indices.transferFamily != indices.graphicsFamily)
+		Log::info("using dedicated transfer queue family {}", indices.transferFamily.value());
+	else
+		Log::info("no dedicated transfer queue family, uploads go through the graphics queue");
 }
 
 bool Device::isDeviceSuitable(vk::PhysicalDevice device)
@@ -113,7 +194,8 @@ bool Device::isDeviceSuitable(vk::PhysicalDevice device)
 	return indices.isComplete() 
 		&& checkExtensionSupport(device) 
 		&& querySwapchainSupport(device)
-		&& anisotropySupported(device);
+		&& anisotropySupported(device)
+		&& timelineSemaphoreSupported(device);
 }
 
 bool Device::checkExtensionSupport(vk::PhysicalDevice device)
@@ -139,26 +221,42 @@ bool Device::anisotropySupported(vk::PhysicalDevice device)
 	return device.getFeatures().samplerAnisotropy;
 }
 
+bool Device::timelineSemaphoreSupported(vk::PhysicalDevice device)
+{
+	auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+	if (features.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore)
+		return true;
+
+	Log::info("{} doesn't support timeline semaphores, it is skipped", device.getProperties().deviceName.data());
+	return false;
+}
+
 QueueFamilyIndices Device::findQueueFamilies(vk::PhysicalDevice device)
 {
 	QueueFamilyIndices indices;
 	auto queueFamilies = device.getQueueFamilyProperties();
 
-	int i = 0;
+	uint32_t i = 0;
 	for (const auto& queueFamily : queueFamilies)
 	{
-		if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
+		if (!indices.graphicsFamily && queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
 			indices.graphicsFamily = i;
 
-		if (device.getSurfaceSupportKHR(i, m_surface))
+		if (!indices.presentFamily && device.getSurfaceSupportKHR(i, m_surface))
 			indices.presentFamily = i;
 
+		//a transfer only family maps to the copy engine on discrete gpus
+		bool transferOnly = (queueFamily.queueFlags & vk::QueueFlagBits::eTransfer)
+			&& !(queueFamily.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+		if (!indices.transferFamily && transferOnly)
+			indices.transferFamily = i;
 
-		if (indices.isComplete())
-			break;
 		i++;
 	}
 
+	if (!indices.transferFamily)
+		indices.transferFamily = indices.graphicsFamily;
+
 	return indices;
 }
 
@@ -168,5 +266,34 @@ void Device::createAllocator()
 	allocatorInfo.physicalDevice = m_gpu;
 	allocatorInfo.device = handle;
 	allocatorInfo.instance = m_instance;
+	allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+	if (m_memoryBudget)
+		allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 	vmaCreateAllocator(&allocatorInfo, &m_allocator);
+
+	//buffers pick their placement from these, see Buffer::create()
+	vk::PhysicalDeviceMemoryProperties properties = m_gpu.getMemoryProperties();
+	bool anyDeviceLocal = false;
+	m_unifiedMemory = true;
+	for (uint32_t i = 0; i < properties.memoryTypeCount; i++)
+	{
+		vk::MemoryPropertyFlags flags = properties.memoryTypes[i].propertyFlags;
+		if (!(flags & vk::MemoryPropertyFlagBits::eDeviceLocal))
+			continue;
+
+		anyDeviceLocal = true;
+		if (!(flags & vk::MemoryPropertyFlagBits::eHostVisible))
+		{
+			m_unifiedMemory = false;
+			continue;
+		}
+
+		m_hostVisibleDeviceMemory = std::max(m_hostVisibleDeviceMemory, properties.memoryHeaps[properties.memoryTypes[i].heapIndex].size);
+	}
+	m_unifiedMemory = m_unifiedMemory && anyDeviceLocal;
+
+	Log::info("host visible device memory: {} MB{}", m_hostVisibleDeviceMemory / (1024 * 1024), m_unifiedMemory ? ", unified memory" : "");
+
+	MemoryStats::get().create(*this);
+	MemoryStats::get().update();
 }
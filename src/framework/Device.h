@@ -25,12 +25,30 @@ public:
 	void destroy();
 
 	QueueFamilyIndices findQueueFamilies() { return findQueueFamilies(m_gpu); }
+	/// largest heap with a device local memory type the cpu can map, 0 if there is none.
+	/// without resizable bar this is the 256 MB bar window, with it most of vram
+	vk::DeviceSize getHostVisibleDeviceMemory() const { return m_hostVisibleDeviceMemory; }
+	/// every device local memory type is host visible, as on integrated gpus
+	bool isUnifiedMemory() const { return m_unifiedMemory; }
+	/// VK_EXT_memory_budget is enabled, heap budgets come from the driver instead of being estimated
+	bool hasMemoryBudget() const { return m_memoryBudget; }
+	/// multiDrawIndirect and drawIndirectFirstInstance are enabled, one indirect call can issue many instanced draws
+	bool supportsMultiDrawIndirect() const { return m_multiDrawIndirect; }
+	/// drawIndexedIndirectCount, the gpu decides how many of the indirect commands are drawn
+	bool supportsDrawIndirectCount() const { return m_drawIndirectCount; }
+	/// descriptor indexing with partially bound, update after bind texture arrays indexed non uniformly
+	bool supportsBindless() const { return m_bindless; }
+	/// size limit of an update after bind texture array in one shader stage
+	uint32_t getMaxBindlessTextures() const { return m_maxBindlessTextures; }
+	/// names the object for validation messages and graphics debuggers, does nothing without debug utils
+	void setDebugName(vk::ObjectType type, uint64_t object, const char* name);
 	vk::Format findDepthFormat();
 
 	static constexpr uint32_t maxFramesInFlight = 2;
 	vk::Device handle;
 	vk::Queue m_graphicsQueue;
 	vk::Queue m_presentQueue;
+	vk::Queue m_transferQueue;
 private:
 	void pickPhysicalDevice();
 	void createLogicalDevice(const std::vector<const char*> validationLayers);
@@ -39,6 +57,8 @@ private:
 	bool checkExtensionSupport(vk::PhysicalDevice device);
 	bool querySwapchainSupport(vk::PhysicalDevice device);
 	bool anisotropySupported(vk::PhysicalDevice device);
+	/// the upload context hands batches to the graphics queue through a timeline semaphore
+	bool timelineSemaphoreSupported(vk::PhysicalDevice device);
 
 	QueueFamilyIndices findQueueFamilies(vk::PhysicalDevice device);
 	vk::Format findSupportedFormat(const std::vector<vk::Format>& candidates, vk::ImageTiling tiling, vk::FormatFeatureFlagBits features);
@@ -49,11 +69,24 @@ private:
 	VkSurfaceKHR& m_surface;
 	vk::PhysicalDevice m_gpu;
 	VmaAllocator m_allocator;
+	vk::DeviceSize m_hostVisibleDeviceMemory = 0;
+	bool m_unifiedMemory = false;
+	bool m_memoryBudget = false;
+	bool m_multiDrawIndirect = false;
+	bool m_drawIndirectCount = false;
+	bool m_bindless = false;
+	uint32_t m_maxBindlessTextures = 0;
+	PFN_vkSetDebugUtilsObjectNameEXT m_setObjectName = nullptr;
 
 	std::vector<const char*> m_extensions =
 	{
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 	};
+	//enabled when the gpu supports them
+	std::vector<const char*> m_optionalExtensions =
+	{
+		VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+	};
 };
 
 //constexpr uint32_t HelloTriangle::maxFramesInFlight = 2;
\ No newline at end of file
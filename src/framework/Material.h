@@ -2,6 +2,8 @@
 
 #include "framework/image/Texture.h"
 
+#include <glm/vec4.hpp>
+
 struct Material
 {
 	Texture* albedo = nullptr;
@@ -9,4 +11,12 @@ struct Material
 	Texture* metallicRoughness = nullptr;
 	Texture* occlusion = nullptr;
 	Texture* emissive = nullptr;
+
+	//indices into the model's textures, bindless materials reference their textures with them
+	uint32_t albedoIndex = 0;
+	uint32_t normalIndex = 0;
+	uint32_t metallicRoughnessIndex = 0;
+	glm::vec4 baseColorFactor = glm::vec4(1.0f);
+	float metallicFactor = 1.0f;
+	float roughnessFactor = 1.0f;
 };
\ No newline at end of file
@@ -29,6 +29,7 @@ void Renderer::initVulkan()
     createSurface();
     m_device.create(m_validationLayers);
     createSyncObjects();
+    m_uploadContext.create(m_device, uploadStagingSize);
 }
 
 void Renderer::initGlfw()
@@ -125,6 +126,8 @@ void Renderer::createSyncObjects()
 
 void Renderer::cleanup()
 {
+    m_uploadContext.destroy();
+
     for (int i = 0; i < Device::maxFramesInFlight; i++)
     {
         m_device.handle.destroySemaphore(m_imageAvailableSemaphores[i]);
@@ -154,6 +157,7 @@ Renderer::~Renderer()
 vk::CommandBuffer& Renderer::prepareFrameImpl()
 {
     m_device.handle.waitForFences(1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+    MemoryStats::get().update();
 
     auto result = m_device.handle.acquireNextImageKHR(m_swapchain.handle, UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame]);
     m_fbIndex = result.value;
@@ -170,6 +174,9 @@ vk::CommandBuffer& Renderer::prepareFrameImpl()
     vk::CommandBufferBeginInfo beginInfo;
     m_commandBuffers[m_currentFrame].begin(beginInfo);
 
+    //take ownership of everything the transfer queue finished since the last frame
+    m_frameUploadWait = m_uploadContext.recordAcquires(m_commandBuffers[m_currentFrame]);
+
     vk::Viewport viewport;
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -195,6 +202,21 @@ void Renderer::endFrameImpl()
     std::vector<vk::Semaphore> waitSemaphores = { m_imageAvailableSemaphores[m_currentFrame] };
     std::vector<vk::Semaphore> signalSemaphores = { m_renderFinishedSemaphores[m_currentFrame] };
     std::vector<vk::PipelineStageFlags> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+    std::vector<uint64_t> waitValues = { 0 };
+    if (m_frameUploadWait != 0)
+    {
+        waitSemaphores.push_back(m_uploadContext.getTimeline());
+        waitStages.push_back(vk::PipelineStageFlagBits::eAllCommands);
+        waitValues.push_back(m_frameUploadWait);
+    }
+
+    //binary semaphores ignore their values
+    std::vector<uint64_t> signalValues = { 0 };
+    vk::TimelineSemaphoreSubmitInfo timelineInfo;
+    timelineInfo.setWaitSemaphoreValues(waitValues);
+    timelineInfo.setSignalSemaphoreValues(signalValues);
+
+    submitInfo.pNext = &timelineInfo;
     submitInfo.setWaitSemaphores(waitSemaphores);
     submitInfo.setSignalSemaphores(signalSemaphores);
     submitInfo.setWaitDstStageMask(waitStages);
@@ -248,6 +270,7 @@ void Renderer::createDepthImageImpl()
 {
     auto extent = m_swapchain.getExtent();
     auto depthFormat = m_device.findDepthFormat();
+    m_depthImage.setName("depth");
     m_depthImage.create(extent.width, extent.height, depthFormat, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled);
     m_depthImage.createView(depthFormat, vk::ImageAspectFlagBits::eDepth);
     m_depthImage.transitionLayout(depthFormat, vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
@@ -350,6 +373,11 @@ VmaAllocator Renderer::getAllocator()
     return get().m_device.getAllocator();
 }
 
+UploadContext& Renderer::getUploadContext()
+{
+    return get().m_uploadContext;
+}
+
 GLFWwindow* Renderer::getWindow()
 {
     return get().m_window;
@@ -5,11 +5,13 @@
 
 #include "Device.h"
 #include "debug/DebugMessenger.h"
+#include "debug/MemoryStats.h"
 #include "swapchain/Swapchain.h"
 #include "rendering/RenderPass.h"
 #include "rendering/Pipeline.h"
 #include "image/Framebuffer.h"
 #include "image/Texture.h"
+#include "UploadContext.h"
 
 #include "utils/Singleton.h"
 
@@ -34,6 +36,7 @@ public:
 	static vk::SurfaceKHR getSurface();
 	static vk::PhysicalDevice getGpu();
 	static VmaAllocator getAllocator();
+	static UploadContext& getUploadContext();
 	static GLFWwindow* getWindow();
 
 	static Image& getDepthImage();
@@ -87,6 +90,10 @@ private:
 
 	vk::CommandPool m_commandPool;
 	std::vector<vk::CommandBuffer> m_commandBuffers;
+
+	static constexpr vk::DeviceSize uploadStagingSize = 64 * 1024 * 1024;
+	UploadContext m_uploadContext;
+	uint64_t m_frameUploadWait = 0;
 	
 	std::vector<vk::Semaphore> m_imageAvailableSemaphores;
 	std::vector<vk::Semaphore> m_renderFinishedSemaphores;
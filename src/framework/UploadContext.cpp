@@ -0,0 +1,432 @@
+#include "UploadContext.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "utils/Log.h"
+#include "Device.h"
+#include "debug/MemoryStats.h"
+
+namespace
+{
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+void UploadContext::create(Device& device, vk::DeviceSize stagingCapacity)
+{
+	m_device = &device;
+
+	QueueFamilyIndices indices = m_device->findQueueFamilies();
+	m_graphicsFamily = indices.graphicsFamily.value();
+	m_transferFamily = indices.transferFamily.value();
+
+	vk::CommandPoolCreateInfo poolInfo;
+	poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+	poolInfo.queueFamilyIndex = m_transferFamily;
+	m_commandPool = m_device->handle.createCommandPool(poolInfo);
+
+	vk::SemaphoreTypeCreateInfo typeInfo;
+	typeInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+	typeInfo.initialValue = 0;
+
+	vk::SemaphoreCreateInfo semaphoreInfo;
+	semaphoreInfo.pNext = &typeInfo;
+	m_timeline = m_device->handle.createSemaphore(semaphoreInfo);
+
+	//persistently mapped staging ring
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = stagingCapacity;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+	VmaAllocationInfo info = {};
+	if (vmaCreateBuffer(m_device->getAllocator(), &bufferInfo, &allocInfo, &m_ringBuffer, &m_ringAllocation, &info) != VK_SUCCESS)
+	{
+		Log::critical("error in UploadContext::create(): failed to create staging ring");
+		return;
+	}
+
+	MemoryStats::get().track(m_ringAllocation, MemoryCategory::eStaging, "staging ring", vk::ObjectType::eBuffer, reinterpret_cast<uint64_t>(m_ringBuffer));
+	m_ringData = static_cast<uint8_t*>(info.pMappedData);
+	m_capacity = stagingCapacity;
+}
+
+void UploadContext::destroy()
+{
+	if (m_recording)
+		submit();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		waitForTicket(m_nextTicket - 1);
+		retire();
+
+		for (auto& entry : m_dedicatedEntries)
+		{
+			MemoryStats::get().untrack(entry.allocation);
+			vmaDestroyBuffer(m_device->getAllocator(), entry.buffer, entry.allocation);
+		}
+		m_dedicatedEntries.clear();
+		m_ringEntries.clear();
+	}
+
+	MemoryStats::get().untrack(m_ringAllocation);
+	vmaDestroyBuffer(m_device->getAllocator(), m_ringBuffer, m_ringAllocation);
+	m_ringBuffer = VK_NULL_HANDLE;
+	m_acquires.clear();
+
+	m_device->handle.destroySemaphore(m_timeline);
+
+	//frees every command buffer allocated from it
+	m_freeCommandBuffers.clear();
+	m_device->handle.destroyCommandPool(m_commandPool);
+}
+
+StagingAllocation UploadContext::allocateStaging(vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	retire();
+
+	StagingAllocation allocation;
+	allocation.size = size;
+	allocation.id = m_nextAllocationId++;
+
+	while (size <= m_capacity)
+	{
+		//restart at the beginning of the ring whenever it drains
+		if (m_ringEntries.empty())
+			m_head = m_tail = alignUp(m_head, m_capacity);
+
+		uint64_t position = alignUp(m_head, alignment);
+		uint64_t offset = position % m_capacity;
+
+		//allocations never wrap around the end of the ring
+		if (offset + size > m_capacity)
+			position += m_capacity - offset;
+
+		if (position + size - m_tail <= m_capacity)
+		{
+			m_ringEntries.push_back({ allocation.id, m_head, position + size, 0, false });
+			m_head = position + size;
+
+			allocation.buffer = m_ringBuffer;
+			allocation.offset = position % m_capacity;
+			allocation.data = m_ringData + allocation.offset;
+			return allocation;
+		}
+
+		//only worth waiting if the oldest allocation has been handed to a batch that is already submitted
+		if (m_ringEntries.empty())
+			break;
+
+		const RingEntry& oldest = m_ringEntries.front();
+		if (!oldest.released || oldest.ticket >= m_nextTicket)
+			break;
+
+		waitForTicket(oldest.ticket);
+		retire();
+	}
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+	DedicatedEntry entry = { allocation.id, VK_NULL_HANDLE, VK_NULL_HANDLE, 0, false };
+	VmaAllocationInfo info = {};
+	if (vmaCreateBuffer(m_device->getAllocator(), &bufferInfo, &allocInfo, &entry.buffer, &entry.allocation, &info) != VK_SUCCESS)
+	{
+		Log::error("error in UploadContext::allocateStaging(): failed to create staging buffer of {} bytes", size);
+		return {};
+	}
+
+	MemoryStats::get().track(entry.allocation, MemoryCategory::eStaging, "dedicated staging", vk::ObjectType::eBuffer, reinterpret_cast<uint64_t>(entry.buffer));
+	m_dedicatedEntries.push_back(entry);
+	allocation.buffer = entry.buffer;
+	allocation.offset = 0;
+	allocation.data = info.pMappedData;
+	return allocation;
+}
+
+void UploadContext::releaseStaging(const StagingAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_recording)
+		m_recordedSize += allocation.size;
+
+	for (auto& entry : m_ringEntries)
+	{
+		if (entry.id == allocation.id)
+		{
+			entry.ticket = m_nextTicket;
+			entry.released = true;
+			return;
+		}
+	}
+
+	for (auto& entry : m_dedicatedEntries)
+	{
+		if (entry.id == allocation.id)
+		{
+			entry.ticket = m_nextTicket;
+			entry.released = true;
+			return;
+		}
+	}
+}
+
+vk::CommandBuffer UploadContext::getCommandBuffer()
+{
+	if (m_recording)
+		return m_recordingBuffer;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_freeCommandBuffers.empty())
+	{
+		vk::CommandBufferAllocateInfo allocInfo;
+		allocInfo.level = vk::CommandBufferLevel::ePrimary;
+		allocInfo.commandPool = m_commandPool;
+		allocInfo.commandBufferCount = 1;
+		m_freeCommandBuffers.push_back(m_device->handle.allocateCommandBuffers(allocInfo)[0]);
+	}
+
+	m_recordingBuffer = m_freeCommandBuffers.back();
+	m_freeCommandBuffers.pop_back();
+
+	vk::CommandBufferBeginInfo beginInfo;
+	beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+	m_recordingBuffer.reset();
+	m_recordingBuffer.begin(beginInfo);
+
+	m_recording = true;
+	m_recordedSize = 0;
+	return m_recordingBuffer;
+}
+
+void UploadContext::uploadBuffer(vk::Buffer dst, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size,
+	vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess)
+{
+	StagingAllocation staging = allocateStaging(size);
+	if (!staging.isValid())
+		return;
+
+	memcpy(staging.data, data, size);
+	copyStaging(staging, dst, dstOffset, dstStage, dstAccess);
+}
+
+void UploadContext::copyStaging(const StagingAllocation& staging, vk::Buffer dst, vk::DeviceSize dstOffset,
+	vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess)
+{
+	vk::DeviceSize size = staging.size;
+
+	vk::BufferCopy region;
+	region.srcOffset = staging.offset;
+	region.dstOffset = dstOffset;
+	region.size = size;
+
+	auto cmd = getCommandBuffer();
+	cmd.copyBuffer(staging.buffer, dst, region);
+	releaseStaging(staging);
+
+	vk::BufferMemoryBarrier barrier;
+	barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	barrier.buffer = dst;
+	barrier.offset = dstOffset;
+	barrier.size = size;
+
+	Acquire& acquire = getRecordingAcquire();
+	if (m_transferFamily == m_graphicsFamily)
+	{
+		//same queue, a plain barrier orders the copy before every later submission
+		barrier.dstAccessMask = dstAccess;
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStage, {}, {}, barrier, {});
+		return;
+	}
+
+	barrier.srcQueueFamilyIndex = m_transferFamily;
+	barrier.dstQueueFamilyIndex = m_graphicsFamily;
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, barrier, {});
+
+	barrier.srcAccessMask = {};
+	barrier.dstAccessMask = dstAccess;
+	acquire.dstStage |= dstStage;
+	acquire.bufferBarriers.push_back(barrier);
+}
+
+void UploadContext::releaseImage(vk::Image image, const vk::ImageSubresourceRange& range, vk::ImageLayout newLayout,
+	vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess)
+{
+	vk::ImageMemoryBarrier barrier;
+	barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+	barrier.newLayout = newLayout;
+	barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	barrier.image = image;
+	barrier.subresourceRange = range;
+
+	auto cmd = getCommandBuffer();
+	Acquire& acquire = getRecordingAcquire();
+	if (m_transferFamily == m_graphicsFamily)
+	{
+		barrier.dstAccessMask = dstAccess;
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStage, {}, {}, {}, barrier);
+		return;
+	}
+
+	//release and acquire both perform the same layout transition
+	barrier.srcQueueFamilyIndex = m_transferFamily;
+	barrier.dstQueueFamilyIndex = m_graphicsFamily;
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, barrier);
+
+	barrier.srcAccessMask = {};
+	barrier.dstAccessMask = dstAccess;
+	acquire.dstStage |= dstStage;
+	acquire.imageBarriers.push_back(barrier);
+}
+
+void UploadContext::recordAfterAcquire(std::function<void(vk::CommandBuffer)> func)
+{
+	getRecordingAcquire().commands.push_back(std::move(func));
+}
+
+UploadTicket UploadContext::submit()
+{
+	if (!m_recording)
+		getCommandBuffer();
+
+	m_recordingBuffer.end();
+
+	uint64_t signalValue = m_nextTicket;
+	vk::TimelineSemaphoreSubmitInfo timelineInfo;
+	timelineInfo.signalSemaphoreValueCount = 1;
+	timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+	vk::SubmitInfo submitInfo;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_recordingBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &m_timeline;
+	m_device->m_transferQueue.submit(submitInfo);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	UploadTicket ticket = m_nextTicket++;
+	m_batches.push_back({ ticket, m_recordingBuffer });
+	m_recording = false;
+	m_recordedSize = 0;
+	return ticket;
+}
+
+bool UploadContext::isComplete(UploadTicket ticket)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	retire();
+	return ticket <= m_completedTicket;
+}
+
+void UploadContext::wait(UploadTicket ticket)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	waitForTicket(ticket);
+	retire();
+}
+
+uint64_t UploadContext::recordAcquires(vk::CommandBuffer cmd)
+{
+	UploadTicket completed;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		retire();
+		completed = m_completedTicket;
+	}
+
+	uint64_t waitValue = 0;
+	while (!m_acquires.empty() && m_acquires.front().ticket <= completed)
+	{
+		Acquire& acquire = m_acquires.front();
+		if (!acquire.imageBarriers.empty() || !acquire.bufferBarriers.empty())
+		{
+			cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, acquire.dstStage, {}, {}, acquire.bufferBarriers, acquire.imageBarriers);
+			waitValue = acquire.ticket;
+		}
+
+		for (auto& command : acquire.commands)
+			command(cmd);
+		m_acquires.pop_front();
+	}
+
+	m_acquiredTicket = m_acquires.empty() ? completed : std::min(completed, m_acquires.front().ticket - 1);
+	return waitValue;
+}
+
+void UploadContext::discardAcquires(vk::Buffer buffer)
+{
+	for (auto& acquire : m_acquires)
+	{
+		auto targets = [buffer](const vk::BufferMemoryBarrier& barrier) { return barrier.buffer == buffer; };
+		acquire.bufferBarriers.erase(std::remove_if(acquire.bufferBarriers.begin(), acquire.bufferBarriers.end(), targets), acquire.bufferBarriers.end());
+	}
+}
+
+void UploadContext::discardAcquires(vk::Image image)
+{
+	for (auto& acquire : m_acquires)
+	{
+		auto targets = [image](const vk::ImageMemoryBarrier& barrier) { return barrier.image == image; };
+		acquire.imageBarriers.erase(std::remove_if(acquire.imageBarriers.begin(), acquire.imageBarriers.end(), targets), acquire.imageBarriers.end());
+	}
+}
+
+UploadContext::Acquire& UploadContext::getRecordingAcquire()
+{
+	if (m_acquires.empty() || m_acquires.back().ticket != m_nextTicket)
+		m_acquires.push_back({ m_nextTicket, {}, {}, {}, {} });
+	return m_acquires.back();
+}
+
+void UploadContext::waitForTicket(UploadTicket ticket)
+{
+	//nothing to wait on for batches that haven't been submitted
+	if (ticket == 0 || ticket >= m_nextTicket)
+		return;
+
+	vk::SemaphoreWaitInfo waitInfo;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_timeline;
+	waitInfo.pValues = &ticket;
+	m_device->handle.waitSemaphores(waitInfo, UINT64_MAX);
+}
+
+void UploadContext::retire()
+{
+	m_completedTicket = m_device->handle.getSemaphoreCounterValue(m_timeline);
+	while (!m_batches.empty() && m_batches.front().ticket <= m_completedTicket)
+	{
+		m_freeCommandBuffers.push_back(m_batches.front().commandBuffer);
+		m_batches.pop_front();
+	}
+
+	while (!m_ringEntries.empty() && m_ringEntries.front().released && m_ringEntries.front().ticket <= m_completedTicket)
+		m_ringEntries.pop_front();
+	m_tail = m_ringEntries.empty() ? m_head : m_ringEntries.front().begin;
+
+	auto retired = [this](const DedicatedEntry& entry)
+	{
+		if (!entry.released || entry.ticket > m_completedTicket)
+			return false;
+		MemoryStats::get().untrack(entry.allocation);
+		vmaDestroyBuffer(m_device->getAllocator(), entry.buffer, entry.allocation);
+		return true;
+	};
+	m_dedicatedEntries.erase(std::remove_if(m_dedicatedEntries.begin(), m_dedicatedEntries.end(), retired), m_dedicatedEntries.end());
+}
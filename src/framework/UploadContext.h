@@ -0,0 +1,150 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "utils/NonCopyable.h"
+
+class Device;
+
+using UploadTicket = uint64_t;
+
+struct StagingAllocation
+{
+	vk::Buffer buffer;
+	vk::DeviceSize offset = 0;
+	vk::DeviceSize size = 0;
+	void* data = nullptr;
+	uint64_t id = 0;
+
+	bool isValid() const { return data != nullptr; }
+};
+
+/// records buffer and image uploads into one command buffer per batch and submits them to the transfer queue,
+/// staging memory comes from a persistently mapped ring that is recycled as batches complete
+///
+/// batch n signals the value n on a timeline semaphore. when the transfer queue belongs to its own family,
+/// uploaded resources are released to the graphics family and the matching acquire barriers are recorded
+/// into the first frame that starts after the batch has completed, so frames never wait on uploads
+class UploadContext : public NonCopyable
+{
+public:
+	UploadContext() = default;
+	~UploadContext() = default;
+
+	void create(Device& device, vk::DeviceSize stagingCapacity);
+	void destroy();
+
+	/// thread safe, falls back to a dedicated buffer when the ring is full
+	StagingAllocation allocateStaging(vk::DeviceSize size, vk::DeviceSize alignment = 16);
+	/// call once every copy reading from the allocation has been recorded, the memory is reused after the current batch completes
+	void releaseStaging(const StagingAllocation& allocation);
+
+	/// command buffer of the batch that is currently being recorded, it executes on the transfer queue
+	vk::CommandBuffer getCommandBuffer();
+	UploadTicket getRecordingTicket() const { return m_nextTicket; }
+
+	/// copies data into dst and hands dst over to the graphics queue for the given stages
+	void uploadBuffer(vk::Buffer dst, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size,
+		vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
+	/// like uploadBuffer for data the caller already wrote into the staging allocation, releases it
+	void copyStaging(const StagingAllocation& staging, vk::Buffer dst, vk::DeviceSize dstOffset,
+		vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
+	/// transitions an image written by this batch from transfer dst to newLayout and hands it over to the graphics queue
+	void releaseImage(vk::Image image, const vk::ImageSubresourceRange& range, vk::ImageLayout newLayout,
+		vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
+
+	/// records func into the frame that acquires the current batch, right after its acquire barriers.
+	/// for work the transfer queue can't do, such as blits
+	void recordAfterAcquire(std::function<void(vk::CommandBuffer)> func);
+
+	UploadTicket submit();
+	bool isComplete(UploadTicket ticket);
+	void wait(UploadTicket ticket);
+	void flush() { wait(submit()); }
+
+	/// true once the resources of the batch can be used by commands recorded on the graphics queue
+	bool isAvailable(UploadTicket ticket) const { return ticket <= m_acquiredTicket; }
+	/// records the acquire barriers of every completed batch, returns the timeline value the frame has to wait on (0 for none)
+	uint64_t recordAcquires(vk::CommandBuffer cmd);
+	/// forgets the pending acquire barriers of a buffer, call before destroying it
+	void discardAcquires(vk::Buffer buffer);
+	void discardAcquires(vk::Image image);
+	vk::Semaphore getTimeline() const { return m_timeline; }
+
+	vk::DeviceSize getStagingCapacity() const { return m_capacity; }
+	vk::DeviceSize getRecordedSize() const { return m_recordedSize; }
+private:
+	struct Batch
+	{
+		UploadTicket ticket;
+		vk::CommandBuffer commandBuffer;
+	};
+
+	struct Acquire
+	{
+		UploadTicket ticket;
+		vk::PipelineStageFlags dstStage;
+		std::vector<vk::ImageMemoryBarrier> imageBarriers;
+		std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+		std::vector<std::function<void(vk::CommandBuffer)>> commands;
+	};
+
+	struct RingEntry
+	{
+		uint64_t id;
+		uint64_t begin;
+		uint64_t end;
+		UploadTicket ticket;
+		bool released;
+	};
+
+	struct DedicatedEntry
+	{
+		uint64_t id;
+		VkBuffer buffer;
+		VmaAllocation allocation;
+		UploadTicket ticket;
+		bool released;
+	};
+
+	Acquire& getRecordingAcquire();
+	void retire();
+	void waitForTicket(UploadTicket ticket);
+private:
+	Device* m_device = nullptr;
+	uint32_t m_transferFamily = 0;
+	uint32_t m_graphicsFamily = 0;
+
+	vk::CommandPool m_commandPool;
+	std::vector<vk::CommandBuffer> m_freeCommandBuffers;
+	std::deque<Batch> m_batches;
+	std::deque<Acquire> m_acquires;
+
+	vk::Semaphore m_timeline;
+	vk::CommandBuffer m_recordingBuffer;
+	bool m_recording = false;
+	vk::DeviceSize m_recordedSize = 0;
+
+	UploadTicket m_nextTicket = 1;
+	UploadTicket m_completedTicket = 0;
+	UploadTicket m_acquiredTicket = 0;
+
+	//ring positions grow monotonically, the physical offset is position % capacity
+	VkBuffer m_ringBuffer = VK_NULL_HANDLE;
+	VmaAllocation m_ringAllocation = VK_NULL_HANDLE;
+	uint8_t* m_ringData = nullptr;
+	vk::DeviceSize m_capacity = 0;
+	uint64_t m_head = 0;
+	uint64_t m_tail = 0;
+	std::deque<RingEntry> m_ringEntries;
+	std::vector<DedicatedEntry> m_dedicatedEntries;
+	uint64_t m_nextAllocationId = 1;
+
+	std::mutex m_mutex;
+};
@@ -3,28 +3,238 @@
 #include "../utils/Log.h"
 #include "../Renderer.h"
 
-void Buffer::create(uint32_t size)
+namespace
 {
+	//without resizable bar only this much vram is mappable, it is left to the small dynamic buffers
+	constexpr vk::DeviceSize barWindowSize = 256 * 1024 * 1024;
+
+	BufferPlacement choosePlacement(BufferIntent intent)
+	{
+		Device& device = Renderer::getDevice();
+		switch (intent)
+		{
+		case BufferIntent::eStatic:
+			if (device.isUnifiedMemory() || device.getHostVisibleDeviceMemory() > barWindowSize)
+				return BufferPlacement::eDeviceHostVisible;
+			return BufferPlacement::eDeviceLocal;
+		case BufferIntent::eDynamic:
+			return device.getHostVisibleDeviceMemory() > 0 ? BufferPlacement::eDeviceHostVisible : BufferPlacement::eHost;
+		default:
+			return BufferPlacement::eHost;
+		}
+	}
+
+	VmaAllocationCreateInfo getAllocationInfo(BufferIntent intent, BufferPlacement placement)
+	{
+		//host visible memory stays mapped for the lifetime of the buffer, map() only hands out the pointer
+		VmaAllocationCreateInfo allocInfo = {};
+		allocInfo.flags = placement == BufferPlacement::eDeviceLocal ? 0 : VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		switch (placement)
+		{
+		case BufferPlacement::eDeviceLocal:
+			allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+			break;
+		case BufferPlacement::eDeviceHostVisible:
+			allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			allocInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			break;
+		default:
+		{
+			allocInfo.usage = intent == BufferIntent::eReadback ? VMA_MEMORY_USAGE_GPU_TO_CPU : VMA_MEMORY_USAGE_CPU_ONLY;
+
+			//vma would put a dynamic buffer into the bar window, system memory has to be asked for explicitly
+			if (Renderer::getDevice().isUnifiedMemory())
+				break;
+
+			vk::PhysicalDeviceMemoryProperties properties = Renderer::getGpu().getMemoryProperties();
+			for (uint32_t i = 0; i < properties.memoryTypeCount; i++)
+			{
+				if (!(properties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal))
+					allocInfo.memoryTypeBits |= 1u << i;
+			}
+			break;
+		}
+		}
+		return allocInfo;
+	}
+
+	MemoryCategory deriveCategory(VkBufferUsageFlags usage, BufferIntent intent)
+	{
+		if (intent == BufferIntent::eStaging)
+			return MemoryCategory::eStaging;
+		if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+			return MemoryCategory::eGeometry;
+		if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+			return MemoryCategory::eUniform;
+		return MemoryCategory::eOther;
+	}
+
+	BufferPlacement getActualPlacement(VmaAllocation allocation)
+	{
+		VmaAllocationInfo info = {};
+		vmaGetAllocationInfo(Renderer::getAllocator(), allocation, &info);
+
+		VkMemoryPropertyFlags flags = 0;
+		vmaGetMemoryTypeProperties(Renderer::getAllocator(), info.memoryType, &flags);
+		if (!(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+			return BufferPlacement::eHost;
+		return flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ? BufferPlacement::eDeviceHostVisible : BufferPlacement::eDeviceLocal;
+	}
+}
+
+void Buffer::create(vk::DeviceSize size, BufferIntent intent, BufferPlacement placement)
+{
+	BufferPlacement requested = placement == BufferPlacement::eAuto ? choosePlacement(intent) : placement;
+
 	VkBufferCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	createInfo.size = size;
 	createInfo.usage = m_usage;
+	if (requested == BufferPlacement::eDeviceLocal || intent == BufferIntent::eReadback)
+		createInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	if (intent == BufferIntent::eStaging)
+		createInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
-	VmaAllocationCreateInfo allocInfo = {};
-	allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+	VmaAllocationCreateInfo allocInfo = getAllocationInfo(intent, requested);
 
 	VkBuffer vmaHandle = {};
-	VkResult success = vmaCreateBuffer(Renderer::getAllocator(), &createInfo, &allocInfo, &vmaHandle, &m_allocation, nullptr);
+	VmaAllocationInfo info = {};
+	VkResult success = vmaCreateBuffer(Renderer::getAllocator(), &createInfo, &allocInfo, &vmaHandle, &m_allocation, &info);
+
+	//the bar window can run out, the buffer still works from the slower placement
+	if (success != VK_SUCCESS && requested == BufferPlacement::eDeviceHostVisible)
+	{
+		Log::warn("no host visible device memory left for a buffer of {} bytes", size);
+		requested = intent == BufferIntent::eStatic ? BufferPlacement::eDeviceLocal : BufferPlacement::eHost;
+		if (requested == BufferPlacement::eDeviceLocal)
+			createInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+		allocInfo = getAllocationInfo(intent, requested);
+		success = vmaCreateBuffer(Renderer::getAllocator(), &createInfo, &allocInfo, &vmaHandle, &m_allocation, &info);
+	}
+
 	if (success != VK_SUCCESS)
 	{
 		Log::critical("error in Buffer::create(): failed to create buffer");
+		return;
 	}
 
 	handle = vmaHandle;
 	m_size = size;
+	m_intent = intent;
+	m_placement = getActualPlacement(m_allocation);
+	m_mappedData = info.pMappedData;
+
+	if (m_category == MemoryCategory::eOther)
+		m_category = deriveCategory(createInfo.usage, intent);
+	MemoryStats::get().track(m_allocation, m_category, m_name, vk::ObjectType::eBuffer, reinterpret_cast<uint64_t>(vmaHandle));
+
+	//a device local request can land in host visible memory on unified memory, it is written directly then
+	Log::trace("buffer of {} bytes: {} intent, {} requested, placed in {}", size, getName(intent), getName(requested), getName(m_placement));
 }
 
 void Buffer::destroy()
 {
+	MemoryStats::get().untrack(m_allocation);
 	vmaDestroyBuffer(Renderer::getAllocator(), handle, m_allocation);
 }
+
+void* Buffer::map(vk::DeviceSize offset, vk::DeviceSize size)
+{
+	m_mappedOffset = offset;
+	m_mappedSize = size == VK_WHOLE_SIZE ? m_size - offset : size;
+
+	if (m_placement == BufferPlacement::eDeviceLocal)
+	{
+		m_staging = Renderer::getUploadContext().allocateStaging(m_mappedSize);
+		if (!m_staging.isValid())
+			Log::critical("error in Buffer::map(): failed to allocate staging memory");
+		return m_staging.data;
+	}
+
+	if (m_mappedData)
+		return static_cast<uint8_t*>(m_mappedData) + offset;
+
+	void* mappedData = nullptr;
+	if (vmaMapMemory(Renderer::getAllocator(), m_allocation, &mappedData) != VK_SUCCESS)
+	{
+		Log::critical("error in Buffer::map(): failed to map buffer memory");
+		return nullptr;
+	}
+	return static_cast<uint8_t*>(mappedData) + offset;
+}
+
+void Buffer::unmap()
+{
+	if (m_placement == BufferPlacement::eDeviceLocal)
+	{
+		if (!m_staging.isValid())
+			return;
+
+		vk::PipelineStageFlags stages;
+		vk::AccessFlags access;
+		if (m_usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+		{
+			stages |= vk::PipelineStageFlagBits::eVertexInput;
+			access |= vk::AccessFlagBits::eVertexAttributeRead;
+		}
+		if (m_usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+		{
+			stages |= vk::PipelineStageFlagBits::eVertexInput;
+			access |= vk::AccessFlagBits::eIndexRead;
+		}
+		if (m_usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+		{
+			stages |= vk::PipelineStageFlagBits::eDrawIndirect;
+			access |= vk::AccessFlagBits::eIndirectCommandRead;
+		}
+		if (m_usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+		{
+			stages |= vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
+			access |= vk::AccessFlagBits::eUniformRead;
+		}
+		if (m_usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+		{
+			stages |= vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
+			access |= vk::AccessFlagBits::eShaderRead;
+		}
+
+		Renderer::getUploadContext().copyStaging(m_staging, handle, m_mappedOffset, stages, access);
+		m_staging = {};
+		return;
+	}
+
+	//no-op on coherent memory
+	vmaFlushAllocation(Renderer::getAllocator(), m_allocation, m_mappedOffset, m_mappedSize);
+	if (!m_mappedData)
+		vmaUnmapMemory(Renderer::getAllocator(), m_allocation);
+}
+
+void Buffer::invalidate()
+{
+	vmaInvalidateAllocation(Renderer::getAllocator(), m_allocation, 0, VK_WHOLE_SIZE);
+}
+
+const char* getName(BufferIntent intent)
+{
+	switch (intent)
+	{
+	case BufferIntent::eStatic: return "static";
+	case BufferIntent::eDynamic: return "dynamic";
+	case BufferIntent::eReadback: return "readback";
+	case BufferIntent::eStaging: return "staging";
+	}
+	return "unknown";
+}
+
+const char* getName(BufferPlacement placement)
+{
+	switch (placement)
+	{
+	case BufferPlacement::eAuto: return "auto";
+	case BufferPlacement::eDeviceLocal: return "device local";
+	case BufferPlacement::eDeviceHostVisible: return "device local host visible";
+	case BufferPlacement::eHost: return "host";
+	}
+	return "unknown";
+}
\ No newline at end of file
@@ -3,21 +3,81 @@
 #include <vulkan/vulkan.hpp>
 #include <vma/vk_mem_alloc.h>
 
+#include "../UploadContext.h"
+#include "../debug/MemoryStats.h"
+
+#include <string>
+
+/// how the owner uses the buffer, create() derives the memory placement from it
+enum class BufferIntent
+{
+	/// written once or rarely, read by the gpu every frame
+	eStatic,
+	/// rewritten by the cpu every frame
+	eDynamic,
+	/// written by the gpu, read by the cpu
+	eReadback,
+	/// source of transfers
+	eStaging,
+};
+
+enum class BufferPlacement
+{
+	/// chosen from the intent and the memory types of the device
+	eAuto,
+	/// only the gpu can access it, written through a staging copy
+	eDeviceLocal,
+	/// device local and mapped directly, the bar window or resizable bar
+	eDeviceHostVisible,
+	/// system memory, the gpu reads it over the bus
+	eHost,
+};
+
 class Buffer
 {
 public:
 	Buffer() = default;
 	virtual ~Buffer() = default;
 
-	void create(uint32_t size);
+	/// placement overrides the choice made from the intent, benchmarks use it to compare strategies
+	void create(vk::DeviceSize size, BufferIntent intent = BufferIntent::eDynamic, BufferPlacement placement = BufferPlacement::eAuto);
 	void destroy();
 
-	uint32_t getSize() { return m_size; }
+	vk::DeviceSize getSize() const { return m_size; }
+	/// usage on top of the one of the buffer type, call before create()
+	void addUsage(VkBufferUsageFlags usage) { m_usage |= usage; }
+	/// memory accounting and debug name, call before create(). without a category it is derived from the usage
+	void setCategory(MemoryCategory category) { m_category = category; }
+	void setName(const std::string& name) { m_name = name; }
+	MemoryCategory getCategory() const { return m_category; }
+	BufferIntent getIntent() const { return m_intent; }
+	/// placement of the memory the buffer actually got, never eAuto
+	BufferPlacement getPlacement() const { return m_placement; }
+
+	/// host pointer to size bytes at offset, lets the owner write data in place instead of copying it in.
+	/// host visible buffers are mapped persistently, unmap() only flushes. device local buffers return staging memory that unmap() copies into the buffer on the transfer queue,
+	/// the data is available to frames that start after the upload batch completed
+	void* map(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+	void unmap();
+	/// makes gpu writes visible to the mapping of a readback buffer, no-op on coherent memory
+	void invalidate();
 
 	vk::Buffer handle;
 protected:
-	VmaAllocation m_allocation;
+	VmaAllocation m_allocation = VK_NULL_HANDLE;
 	virtual void setUsage() = 0;
 	VkBufferUsageFlags m_usage = 0;
-	uint32_t m_size = 0;
-};
\ No newline at end of file
+	vk::DeviceSize m_size = 0;
+	BufferIntent m_intent = BufferIntent::eDynamic;
+	BufferPlacement m_placement = BufferPlacement::eHost;
+	MemoryCategory m_category = MemoryCategory::eOther;
+	std::string m_name;
+	StagingAllocation m_staging;
+	//persistent mapping of host visible buffers
+	void* m_mappedData = nullptr;
+	vk::DeviceSize m_mappedOffset = 0;
+	vk::DeviceSize m_mappedSize = 0;
+};
+
+const char* getName(BufferIntent intent);
+const char* getName(BufferPlacement placement);
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "FrameAllocator.h"
+
+#include "../utils/Log.h"
+#include "../Renderer.h"
+
+void FrameAllocator::create(vk::DeviceSize frameCapacity)
+{
+	//dynamic offsets have to be multiples of these
+	vk::PhysicalDeviceLimits limits = Renderer::getGpu().getProperties().limits;
+	m_alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+	m_frameCapacity = (frameCapacity + m_alignment - 1) / m_alignment * m_alignment;
+
+	setName("frame allocator");
+	Buffer::create(m_frameCapacity * Device::maxFramesInFlight, BufferIntent::eDynamic);
+	m_data = static_cast<uint8_t*>(map());
+	m_frameStart = 0;
+	m_head = 0;
+}
+
+void FrameAllocator::beginFrame(uint32_t frameIndex)
+{
+	m_frameStart = frameIndex * m_frameCapacity;
+	m_head = 0;
+}
+
+void FrameAllocator::flush()
+{
+	if (m_head > 0)
+		vmaFlushAllocation(Renderer::getAllocator(), m_allocation, m_frameStart, m_head);
+}
+
+FrameAllocation FrameAllocator::allocate(vk::DeviceSize size)
+{
+	vk::DeviceSize offset = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+	if (offset + size > m_frameCapacity)
+	{
+		Log::error("error in FrameAllocator::allocate(): {} bytes don't fit, {} of {} bytes used this frame", size, m_head, m_frameCapacity);
+		return {};
+	}
+
+	m_head = offset + size;
+	return { m_data + m_frameStart + offset, static_cast<uint32_t>(m_frameStart + offset) };
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Buffer.h"
+
+#include "../utils/DataView.h"
+#include "../rendering/Descriptor.h"
+
+#include <algorithm>
+#include <cstring>
+
+/// memory handed out by FrameAllocator, offset is the dynamic offset to bind it with
+struct FrameAllocation
+{
+	void* data = nullptr;
+	uint32_t offset = 0;
+
+	bool isValid() const { return data != nullptr; }
+};
+
+/// a fixed size window into the frame allocator, written to a dynamic uniform or storage binding.
+/// the dynamic offset passed to bindDescriptorSets() moves the window to an allocation
+class FrameDescriptor : public Descriptor
+{
+public:
+	FrameDescriptor(vk::Buffer buffer, vk::DeviceSize range, vk::DescriptorType type)
+		:m_buffer(buffer), m_range(range), m_type(type) {}
+
+	std::optional<vk::DescriptorBufferInfo> getDescriptorBufferInfo() const
+	{
+		return vk::DescriptorBufferInfo(m_buffer, 0, m_range);
+	}
+
+	std::optional<vk::DescriptorImageInfo> getDescriptorImageInfo() const
+	{
+		return {};
+	}
+
+	vk::DescriptorType getDescriptorType() const
+	{
+		return m_type;
+	}
+private:
+	vk::Buffer m_buffer;
+	vk::DeviceSize m_range;
+	vk::DescriptorType m_type;
+};
+
+/// linear allocator for data that is written every frame, such as uniforms, per draw constants and indirect draw commands.
+/// one persistently mapped buffer is split into a slice per frame in flight, beginFrame() resets the slice
+/// of a frame once its fence has signaled. allocations are aligned for uniform and storage buffer offsets
+class FrameAllocator : public Buffer
+{
+public:
+	/// returned by push() when the frame's slice is full, binding any other offset would read another allocation's data
+	static constexpr uint32_t invalidOffset = ~0u;
+
+	FrameAllocator() { setUsage(); }
+	~FrameAllocator() = default;
+
+	void create(vk::DeviceSize frameCapacity);
+
+	/// call after Renderer::prepareFrame() waited for the frame's fence
+	void beginFrame(uint32_t frameIndex);
+	/// makes the frame's writes visible to the gpu, call before the frame is submitted
+	void flush();
+
+	/// returns an invalid allocation when the frame's slice is full
+	FrameAllocation allocate(vk::DeviceSize size);
+
+	/// returns the dynamic offset of the copy or invalidOffset
+	template<typename T>
+	uint32_t push(const T& data)
+	{
+		FrameAllocation allocation = allocate(sizeof(T));
+		if (!allocation.isValid())
+			return invalidOffset;
+
+		memcpy(allocation.data, &data, sizeof(T));
+		return allocation.offset;
+	}
+
+	/// range bytes are reserved, so a descriptor with that range stays inside the buffer at the returned offset
+	template<typename T>
+	uint32_t push(DataView<T> data, vk::DeviceSize range)
+	{
+		FrameAllocation allocation = allocate(std::max<vk::DeviceSize>(range, data.sizeBytes()));
+		if (!allocation.isValid())
+			return invalidOffset;
+
+		memcpy(allocation.data, data.data(), data.sizeBytes());
+		return allocation.offset;
+	}
+
+	FrameDescriptor getDescriptor(vk::DescriptorType type, vk::DeviceSize range) const { return FrameDescriptor(handle, range, type); }
+	vk::DeviceSize getUsedSize() const { return m_head; }
+	vk::DeviceSize getFrameCapacity() const { return m_frameCapacity; }
+protected:
+	void setUsage() { m_usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT; }
+private:
+	uint8_t* m_data = nullptr;
+	vk::DeviceSize m_frameCapacity = 0;
+	vk::DeviceSize m_alignment = 256;
+	vk::DeviceSize m_frameStart = 0;
+	vk::DeviceSize m_head = 0;
+};
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "GeometryPool.h"
+
+#include "../utils/Log.h"
+#include "../Renderer.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+	void createArena(Buffer& buffer, const char* name, vk::DeviceSize capacity, BufferPlacement placement)
+	{
+		//compaction copies between arenas
+		buffer.addUsage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		buffer.setName(name);
+		buffer.create(std::max<vk::DeviceSize>(capacity, 4), BufferIntent::eStatic, placement);
+	}
+}
+
+void GeometryPool::create(vk::DeviceSize vertexCapacity, vk::DeviceSize indexCapacity, BufferPlacement placement)
+{
+	m_placement = placement;
+	createArena(m_vertexBuffer, "geometry pool vertices", vertexCapacity, placement);
+	createArena(m_indexBuffer, "geometry pool indices", indexCapacity, placement);
+	m_vertexArena.create(m_vertexBuffer.getSize());
+	m_indexArena.create(m_indexBuffer.getSize());
+	m_ranges.clear();
+	m_freeHandles.clear();
+}
+
+void GeometryPool::destroy()
+{
+	//uploads that were never acquired must not record barriers on the destroyed arenas
+	Renderer::getUploadContext().discardAcquires(m_vertexBuffer.handle);
+	Renderer::getUploadContext().discardAcquires(m_indexBuffer.handle);
+	m_vertexBuffer.destroy();
+	m_indexBuffer.destroy();
+	m_ranges.clear();
+	m_freeHandles.clear();
+}
+
+GeometryHandle GeometryPool::allocate(vk::DeviceSize vertexBytes, uint32_t vertexStride, vk::DeviceSize indexBytes, uint32_t indexSize)
+{
+	Range range = { 0, vertexBytes, vertexStride, 0, indexBytes, indexSize, true };
+	if (!tryAllocate(range))
+	{
+		//compaction is enough if the free space is only fragmented, otherwise the arenas grow
+		vk::DeviceSize vertexNeeded = m_vertexArena.getUsedSize() + vertexBytes + vertexStride;
+		vk::DeviceSize indexNeeded = m_indexArena.getUsedSize() + indexBytes + indexSize;
+		if (vertexNeeded <= m_vertexArena.getCapacity() && indexNeeded <= m_indexArena.getCapacity())
+			rebuild(m_vertexArena.getCapacity(), m_indexArena.getCapacity());
+		else
+			rebuild(std::max(m_vertexArena.getCapacity() * 2, vertexNeeded), std::max(m_indexArena.getCapacity() * 2, indexNeeded));
+
+		if (!tryAllocate(range))
+		{
+			Log::error("error in GeometryPool::allocate(): no space for {} vertex and {} index bytes", vertexBytes, indexBytes);
+			return invalidHandle;
+		}
+	}
+
+	if (!m_freeHandles.empty())
+	{
+		GeometryHandle handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+		m_ranges[handle] = range;
+		return handle;
+	}
+
+	m_ranges.push_back(range);
+	return static_cast<GeometryHandle>(m_ranges.size() - 1);
+}
+
+void GeometryPool::free(GeometryHandle handle)
+{
+	if (handle >= m_ranges.size() || !m_ranges[handle].used)
+		return;
+
+	Range& range = m_ranges[handle];
+	m_vertexArena.free(range.vertexOffset);
+	m_indexArena.free(range.indexOffset);
+	range.used = false;
+	m_freeHandles.push_back(handle);
+}
+
+void GeometryPool::compact()
+{
+	if (m_vertexArena.getFreeRangeCount() <= 1 && m_indexArena.getFreeRangeCount() <= 1)
+		return;
+
+	rebuild(m_vertexArena.getCapacity(), m_indexArena.getCapacity());
+}
+
+void* GeometryPool::mapVertices(GeometryHandle handle)
+{
+	return m_vertexBuffer.map(m_ranges[handle].vertexOffset, m_ranges[handle].vertexBytes);
+}
+
+void* GeometryPool::mapIndices(GeometryHandle handle)
+{
+	return m_indexBuffer.map(m_ranges[handle].indexOffset, m_ranges[handle].indexBytes);
+}
+
+int32_t GeometryPool::getBaseVertex(GeometryHandle handle) const
+{
+	return static_cast<int32_t>(m_ranges[handle].vertexOffset / m_ranges[handle].vertexStride);
+}
+
+uint32_t GeometryPool::getFirstIndex(GeometryHandle handle) const
+{
+	return static_cast<uint32_t>(m_ranges[handle].indexOffset / m_ranges[handle].indexSize);
+}
+
+void GeometryPool::bind(vk::CommandBuffer commandBuffer, vk::IndexType indexType) const
+{
+	vk::DeviceSize offset = 0;
+	commandBuffer.bindVertexBuffers(0, 1, &m_vertexBuffer.handle, &offset);
+	commandBuffer.bindIndexBuffer(m_indexBuffer.handle, 0, indexType);
+}
+
+bool GeometryPool::tryAllocate(Range& range)
+{
+	//an empty range still gets an offset, so free() has something to release
+	range.vertexOffset = m_vertexArena.allocate(std::max<vk::DeviceSize>(range.vertexBytes, range.vertexStride), range.vertexStride);
+	if (range.vertexOffset == RangeAllocator::invalidOffset)
+		return false;
+
+	range.indexOffset = m_indexArena.allocate(std::max<vk::DeviceSize>(range.indexBytes, range.indexSize), range.indexSize);
+	if (range.indexOffset == RangeAllocator::invalidOffset)
+	{
+		m_vertexArena.free(range.vertexOffset);
+		return false;
+	}
+
+	return true;
+}
+
+void GeometryPool::rebuild(vk::DeviceSize vertexCapacity, vk::DeviceSize indexCapacity)
+{
+	//staging copies may still write the old arenas and frames in flight may still read them
+	Renderer::getUploadContext().flush();
+	Renderer::getDevice().handle.waitIdle();
+
+	VertexBuffer vertexBuffer;
+	IndexBuffer indexBuffer;
+	createArena(vertexBuffer, "geometry pool vertices", vertexCapacity, m_placement);
+	createArena(indexBuffer, "geometry pool indices", indexCapacity, m_placement);
+	m_vertexArena.create(vertexBuffer.getSize());
+	m_indexArena.create(indexBuffer.getSize());
+
+	//ranges keep their order, so the packed arenas look as if the freed models had never been loaded
+	std::vector<GeometryHandle> order(m_ranges.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [this](GeometryHandle a, GeometryHandle b) { return m_ranges[a].vertexOffset < m_ranges[b].vertexOffset; });
+
+	std::vector<vk::BufferCopy> vertexCopies;
+	std::vector<vk::BufferCopy> indexCopies;
+	for (GeometryHandle handle : order)
+	{
+		Range& range = m_ranges[handle];
+		if (!range.used)
+			continue;
+
+		Range moved = range;
+		if (!tryAllocate(moved))
+		{
+			Log::error("error in GeometryPool::rebuild(): range {} does not fit into the new arenas", handle);
+			range.used = false;
+			m_freeHandles.push_back(handle);
+			continue;
+		}
+		if (range.vertexBytes > 0)
+			vertexCopies.emplace_back(range.vertexOffset, moved.vertexOffset, range.vertexBytes);
+		if (range.indexBytes > 0)
+			indexCopies.emplace_back(range.indexOffset, moved.indexOffset, range.indexBytes);
+		range = moved;
+	}
+
+	//the uploads were flushed but with a transfer family the graphics queue doesn't own their ranges yet,
+	//so their acquires are recorded here instead of into the next frame
+	auto commandBuffer = Renderer::beginSingleTimeCommand();
+	Renderer::getUploadContext().recordAcquires(commandBuffer);
+	vk::MemoryBarrier acquired(vk::AccessFlagBits::eMemoryWrite, vk::AccessFlagBits::eTransferRead);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {}, acquired, {}, {});
+	if (!vertexCopies.empty())
+		commandBuffer.copyBuffer(m_vertexBuffer.handle, vertexBuffer.handle, vertexCopies);
+	if (!indexCopies.empty())
+		commandBuffer.copyBuffer(m_indexBuffer.handle, indexBuffer.handle, indexCopies);
+	Renderer::endSingleTimeCommand(commandBuffer);
+
+	Log::info("geometry pool rebuilt: vertices {:.1f}/{:.1f} MB, indices {:.1f}/{:.1f} MB", m_vertexArena.getUsedSize() / (1024.0 * 1024.0),
+		vertexCapacity / (1024.0 * 1024.0), m_indexArena.getUsedSize() / (1024.0 * 1024.0), indexCapacity / (1024.0 * 1024.0));
+
+	Renderer::getUploadContext().discardAcquires(m_vertexBuffer.handle);
+	Renderer::getUploadContext().discardAcquires(m_indexBuffer.handle);
+	m_vertexBuffer.destroy();
+	m_indexBuffer.destroy();
+	m_vertexBuffer = vertexBuffer;
+	m_indexBuffer = indexBuffer;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "RangeAllocator.h"
+
+#include <vector>
+
+using GeometryHandle = uint32_t;
+
+/// one vertex and one index arena shared by every model. models get a range of each, draws bind the arenas once
+/// and address their geometry with getBaseVertex() and getFirstIndex(). the arenas grow and compact on demand,
+/// which moves ranges, so offsets have to be queried again after allocate(), free() or compact()
+class GeometryPool
+{
+public:
+	static constexpr GeometryHandle invalidHandle = ~0u;
+
+	void create(vk::DeviceSize vertexCapacity, vk::DeviceSize indexCapacity, BufferPlacement placement = BufferPlacement::eAuto);
+	void destroy();
+
+	/// vertexBytes is a multiple of vertexStride, indexBytes one of indexSize
+	GeometryHandle allocate(vk::DeviceSize vertexBytes, uint32_t vertexStride, vk::DeviceSize indexBytes, uint32_t indexSize);
+	void free(GeometryHandle handle);
+	/// moves every range to the front of its arena, waits for the gpu
+	void compact();
+
+	/// write access to the ranges of the handle, see Buffer::map()
+	void* mapVertices(GeometryHandle handle);
+	void unmapVertices() { m_vertexBuffer.unmap(); }
+	void* mapIndices(GeometryHandle handle);
+	void unmapIndices() { m_indexBuffer.unmap(); }
+
+	/// add to the vertexOffset and firstIndex of draws from the handle's geometry
+	int32_t getBaseVertex(GeometryHandle handle) const;
+	uint32_t getFirstIndex(GeometryHandle handle) const;
+
+	/// index ranges of both widths share the arena, the type is chosen per bind
+	void bind(vk::CommandBuffer commandBuffer, vk::IndexType indexType) const;
+
+	BufferPlacement getPlacement() const { return m_vertexBuffer.getPlacement(); }
+	const RangeAllocator& getVertexArena() const { return m_vertexArena; }
+	const RangeAllocator& getIndexArena() const { return m_indexArena; }
+private:
+	struct Range
+	{
+		vk::DeviceSize vertexOffset;
+		vk::DeviceSize vertexBytes;
+		uint32_t vertexStride;
+		vk::DeviceSize indexOffset;
+		vk::DeviceSize indexBytes;
+		uint32_t indexSize;
+		bool used;
+	};
+
+	bool tryAllocate(Range& range);
+	/// copies every range into new arenas of the given capacity, packed in their current order
+	void rebuild(vk::DeviceSize vertexCapacity, vk::DeviceSize indexCapacity);
+private:
+	VertexBuffer m_vertexBuffer;
+	IndexBuffer m_indexBuffer;
+	RangeAllocator m_vertexArena;
+	RangeAllocator m_indexArena;
+	BufferPlacement m_placement = BufferPlacement::eAuto;
+
+	std::vector<Range> m_ranges;
+	std::vector<GeometryHandle> m_freeHandles;
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Buffer.h"
+#include "../utils/DataView.h"
 
 class IndexBuffer : public Buffer
 {
@@ -9,8 +10,12 @@ public:
 	~IndexBuffer() = default;
 
 	uint32_t getIndexCount() { return m_indexCount; }
-	void mapMemory(const std::vector<uint32_t>& indices);
+	vk::IndexType getIndexType() const { return m_indexType; }
+	void mapMemory(DataView<uint32_t> indices);
+	/// for indices written through map()
+	void setIndexType(vk::IndexType indexType, uint32_t indexCount) { m_indexType = indexType; m_indexCount = indexCount; }
 protected:
 	void setUsage() { m_usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT; }
 	uint32_t m_indexCount = 0;
+	vk::IndexType m_indexType = vk::IndexType::eUint32;
 };
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "RangeAllocator.h"
+
+void RangeAllocator::create(uint64_t capacity)
+{
+	m_capacity = capacity;
+	m_usedSize = 0;
+	m_free.clear();
+	m_freeBySize.clear();
+	m_allocations.clear();
+
+	if (capacity > 0)
+		insertFree(0, capacity);
+}
+
+uint64_t RangeAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || alignment == 0)
+		return invalidOffset;
+
+	//smallest free range that still fits once the start is aligned
+	for (auto it = m_freeBySize.lower_bound(size); it != m_freeBySize.end(); ++it)
+	{
+		uint64_t begin = it->second;
+		uint64_t end = begin + it->first;
+		uint64_t offset = (begin + alignment - 1) / alignment * alignment;
+		if (offset + size > end)
+			continue;
+
+		eraseFree(m_free.find(begin));
+
+		//the padding in front stays part of the allocation, a remainder behind goes back to the free list
+		if (offset + size < end)
+			insertFree(offset + size, end);
+
+		m_allocations[offset] = { begin, offset + size };
+		m_usedSize += offset + size - begin;
+		return offset;
+	}
+
+	return invalidOffset;
+}
+
+void RangeAllocator::free(uint64_t offset)
+{
+	auto allocation = m_allocations.find(offset);
+	if (allocation == m_allocations.end())
+		return;
+
+	uint64_t begin = allocation->second.begin;
+	uint64_t end = allocation->second.end;
+	m_usedSize -= end - begin;
+	m_allocations.erase(allocation);
+
+	//merge with the free ranges on both sides
+	auto next = m_free.lower_bound(begin);
+	if (next != m_free.end() && next->first == end)
+	{
+		end = next->second;
+		next = std::next(next);
+		eraseFree(std::prev(next));
+	}
+
+	if (next != m_free.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->second == begin)
+		{
+			begin = previous->first;
+			eraseFree(previous);
+		}
+	}
+
+	insertFree(begin, end);
+}
+
+void RangeAllocator::insertFree(uint64_t begin, uint64_t end)
+{
+	m_free[begin] = end;
+	m_freeBySize.emplace(end - begin, begin);
+}
+
+void RangeAllocator::eraseFree(std::map<uint64_t, uint64_t>::iterator range)
+{
+	auto sizes = m_freeBySize.equal_range(range->second - range->first);
+	for (auto it = sizes.first; it != sizes.second; ++it)
+	{
+		if (it->second == range->first)
+		{
+			m_freeBySize.erase(it);
+			break;
+		}
+	}
+
+	m_free.erase(range);
+}
\ No newline at end of file
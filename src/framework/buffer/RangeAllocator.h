@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+
+/// best fit free list over [0, capacity). freed ranges are merged with their free neighbours,
+/// so the list only holds as many entries as there are holes between live allocations
+class RangeAllocator
+{
+public:
+	static constexpr uint64_t invalidOffset = ~0ull;
+
+	void create(uint64_t capacity);
+
+	/// alignment does not have to be a power of two, vertex ranges are aligned to their stride.
+	/// returns invalidOffset if no free range is large enough
+	uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+	/// offset is a value returned by allocate()
+	void free(uint64_t offset);
+
+	uint64_t getCapacity() const { return m_capacity; }
+	uint64_t getUsedSize() const { return m_usedSize; }
+	uint64_t getLargestFreeRange() const { return m_freeBySize.empty() ? 0 : m_freeBySize.rbegin()->first; }
+	size_t getFreeRangeCount() const { return m_free.size(); }
+	size_t getAllocationCount() const { return m_allocations.size(); }
+private:
+	struct Allocation
+	{
+		//start of the range including the alignment padding
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	void insertFree(uint64_t begin, uint64_t end);
+	void eraseFree(std::map<uint64_t, uint64_t>::iterator range);
+private:
+	uint64_t m_capacity = 0;
+	uint64_t m_usedSize = 0;
+	//begin -> end
+	std::map<uint64_t, uint64_t> m_free;
+	//size -> begin, for the best fit search
+	std::multimap<uint64_t, uint64_t> m_freeBySize;
+	//aligned offset -> range
+	std::map<uint64_t, Allocation> m_allocations;
+};
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Buffer.h"
+
+#include "../utils/DataView.h"
+#include "../rendering/Descriptor.h"
 #include "../Renderer.h"
 
-class StorageBuffer : public Buffer
+class StorageBuffer : public Buffer, public Descriptor
 {
 public:
 	StorageBuffer() { setUsage(); }
@@ -12,10 +15,39 @@ public:
 	template<typename T>
 	void mapMemory(const T& data)
 	{
-		void* mappedData;
-		vmaMapMemory(Renderer::getAllocator(), m_allocation, &mappedData);
-		memcpy(mappedData, &data, sizeof(T));
-		vmaUnmapMemory(Renderer::getAllocator(), m_allocation);
+		memcpy(map(), &data, sizeof(T));
+		unmap();
+	}
+
+	template<typename T>
+	void mapMemory(DataView<T> data)
+	{
+		memcpy(map(), data.data(), data.sizeBytes());
+		unmap();
+	}
+
+	std::optional<vk::DescriptorBufferInfo> getDescriptorBufferInfo() const
+	{
+		vk::DescriptorBufferInfo info;
+		info.buffer = handle;
+		info.offset = 0;
+		info.range = m_size;
+		return info;
+	}
+
+	std::optional<vk::DescriptorImageInfo> getDescriptorImageInfo() const
+	{
+		return {};
+	}
+
+	vk::DescriptorType getDescriptorType() const
+	{
+		return vk::DescriptorType::eStorageBuffer;
+	}
+
+	std::string toString() const
+	{
+		return "storage buffer";
 	}
 protected:
 	void setUsage() { m_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT; }
@@ -15,10 +15,8 @@ public:
 	template<typename T>
 	void mapMemory(const T& data)
 	{
-		void* mappedData;
-		vmaMapMemory(Renderer::getAllocator(), m_allocation, &mappedData);
-		memcpy(mappedData, &data, sizeof(T));
-		vmaUnmapMemory(Renderer::getAllocator(), m_allocation);
+		memcpy(map(), &data, sizeof(T));
+		unmap();
 	}
 
 	std::optional<vk::DescriptorBufferInfo> getDescriptorBufferInfo() const
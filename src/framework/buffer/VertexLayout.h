@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+
+#include <type_traits>
+
+#include "../utils/VulkanStructs.h"
+
+//storage types for normalized and half precision attributes, plain glm types are 32 bit floats
+struct Unorm16x4
+{
+	uint16_t x, y, z, w;
+};
+
+struct Snorm16x2
+{
+	int16_t x, y;
+};
+
+struct Half2
+{
+	uint16_t x, y;
+};
+
+template<typename T>
+struct VertexAttributeFormat;
+
+template<> struct VertexAttributeFormat<float> { static constexpr vk::Format value = vk::Format::eR32Sfloat; };
+template<> struct VertexAttributeFormat<glm::vec2> { static constexpr vk::Format value = vk::Format::eR32G32Sfloat; };
+template<> struct VertexAttributeFormat<glm::vec3> { static constexpr vk::Format value = vk::Format::eR32G32B32Sfloat; };
+template<> struct VertexAttributeFormat<glm::vec4> { static constexpr vk::Format value = vk::Format::eR32G32B32A32Sfloat; };
+template<> struct VertexAttributeFormat<Unorm16x4> { static constexpr vk::Format value = vk::Format::eR16G16B16A16Unorm; };
+template<> struct VertexAttributeFormat<Snorm16x2> { static constexpr vk::Format value = vk::Format::eR16G16Snorm; };
+template<> struct VertexAttributeFormat<Half2> { static constexpr vk::Format value = vk::Format::eR16G16Sfloat; };
+
+/// builds the binding and attribute descriptions of T from its members,
+/// locations follow the argument order and formats come from the member types
+template<typename T, typename... Members>
+VertexDescription makeVertexDescription(Members T::*... members)
+{
+	VertexDescription description;
+	description.bindingDescription = vk::VertexInputBindingDescription(0, sizeof(T), vk::VertexInputRate::eVertex);
+
+	T vertex = {};
+	uint32_t location = 0;
+	auto addAttribute = [&](auto member)
+	{
+		using Member = std::remove_reference_t<decltype(vertex.*member)>;
+		auto offset = reinterpret_cast<const char*>(&(vertex.*member)) - reinterpret_cast<const char*>(&vertex);
+		description.attributeDescriptions.emplace_back(location++, 0, VertexAttributeFormat<Member>::value, static_cast<uint32_t>(offset));
+	};
+	(addAttribute(members), ...);
+
+	return description;
+}
@@ -0,0 +1,160 @@
+#include "ClusterCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLUSTER_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+void ClusterCuller::create(DataView<Meshlet> meshlets, DataView<Primitive> primitives, DataView<uint32_t> instances)
+{
+	m_meshlets.clear();
+	m_nodes.clear();
+	m_slots.assign(meshlets.size(), invalidSlot);
+	for (auto& primitive : primitives)
+	{
+		if (primitive.instanceCount != 1)
+			continue;
+
+		for (uint32_t i = primitive.firstMeshlet; i < primitive.firstMeshlet + primitive.meshletCount; i++)
+		{
+			m_slots[i] = static_cast<uint32_t>(m_meshlets.size());
+			m_meshlets.push_back(meshlets[i]);
+			m_nodes.push_back(instances[primitive.firstInstance]);
+		}
+	}
+
+	size_t padded = (m_meshlets.size() + 3) & ~size_t(3);
+	for (auto* values : { &m_centerX, &m_centerY, &m_centerZ, &m_radius, &m_apexX, &m_apexY, &m_apexZ, &m_axisX, &m_axisY, &m_axisZ, &m_cutoff })
+		values->assign(padded, 0.0f);
+
+	m_visible.assign(padded, 0);
+	m_boundsVersion = 0;
+}
+
+void ClusterCuller::updateBounds(const SceneGraph& sceneGraph)
+{
+	if (sceneGraph.getVersion() == m_boundsVersion)
+		return;
+
+	for (size_t i = 0; i < m_meshlets.size(); i++)
+	{
+		if (sceneGraph.getNodeVersion(m_nodes[i]) <= m_boundsVersion)
+			continue;
+
+		auto& meshlet = m_meshlets[i];
+		const glm::mat4& world = sceneGraph.getWorldMatrix(m_nodes[i]);
+
+		glm::vec3 center = world * glm::vec4(meshlet.center, 1.0f);
+		glm::vec3 apex = world * glm::vec4(meshlet.coneApex, 1.0f);
+		glm::vec3 axis = glm::mat3(world) * meshlet.coneAxis;
+		float axisLength = glm::length(axis);
+
+		m_centerX[i] = center.x;
+		m_centerY[i] = center.y;
+		m_centerZ[i] = center.z;
+		m_radius[i] = meshlet.radius * utils::getMaxScale(world);
+		m_apexX[i] = apex.x;
+		m_apexY[i] = apex.y;
+		m_apexZ[i] = apex.z;
+
+		//non uniform scale changes the cone angle, such meshlets are not cone culled
+		float minScale = std::sqrt(std::min({ glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+			glm::dot(glm::vec3(world[1]), glm::vec3(world[1])), glm::dot(glm::vec3(world[2]), glm::vec3(world[2])) }));
+		bool uniformScale = minScale > utils::getMaxScale(world) * 0.99f;
+
+		glm::vec3 worldAxis = uniformScale && axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f);
+		m_axisX[i] = worldAxis.x;
+		m_axisY[i] = worldAxis.y;
+		m_axisZ[i] = worldAxis.z;
+		m_cutoff[i] = uniformScale ? meshlet.coneCutoff : 1.0f;
+	}
+
+	m_boundsVersion = sceneGraph.getVersion();
+}
+
+void ClusterCuller::appendVisible(const Primitive& primitive, uint32_t firstInstance, std::vector<DrawRange>& draws) const
+{
+	bool extend = false;
+	for (uint32_t meshlet = primitive.firstMeshlet; meshlet < primitive.firstMeshlet + primitive.meshletCount; meshlet++)
+	{
+		uint32_t i = m_slots[meshlet];
+		if (i == invalidSlot || !m_visible[i])
+		{
+			extend = false;
+			continue;
+		}
+
+		if (extend)
+		{
+			draws.back().indexCount += m_meshlets[i].indexCount;
+			continue;
+		}
+
+		draws.push_back({ m_meshlets[i].firstIndex, m_meshlets[i].indexCount, primitive.firstVertex, primitive.materialIndex, firstInstance, 1 });
+		extend = true;
+	}
+}
+
+void ClusterCuller::update(const Frustum& frustum, const glm::vec3& cameraPosition)
+{
+	//visible = inside all planes and not (dot(apex - camera, axis) > cutoff * |apex - camera|)
+	size_t count = m_meshlets.size();
+	size_t i = 0;
+	m_visibleCount = 0;
+
+#ifdef CLUSTER_CULLER_SSE2
+	const __m128 cameraX = _mm_set1_ps(cameraPosition.x);
+	const __m128 cameraY = _mm_set1_ps(cameraPosition.y);
+	const __m128 cameraZ = _mm_set1_ps(cameraPosition.z);
+
+	for (; i < m_centerX.size(); i += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(&m_centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&m_centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&m_centerZ[i]);
+		__m128 radius = _mm_loadu_ps(&m_radius[i]);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+		__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (auto& plane : frustum.planes)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		__m128 toApexX = _mm_sub_ps(_mm_loadu_ps(&m_apexX[i]), cameraX);
+		__m128 toApexY = _mm_sub_ps(_mm_loadu_ps(&m_apexY[i]), cameraY);
+		__m128 toApexZ = _mm_sub_ps(_mm_loadu_ps(&m_apexZ[i]), cameraZ);
+		__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toApexX, toApexX), _mm_mul_ps(toApexY, toApexY)), _mm_mul_ps(toApexZ, toApexZ)));
+		__m128 axisDot = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(toApexX, _mm_loadu_ps(&m_axisX[i])),
+			_mm_mul_ps(toApexY, _mm_loadu_ps(&m_axisY[i]))),
+			_mm_mul_ps(toApexZ, _mm_loadu_ps(&m_axisZ[i])));
+		__m128 backFacing = _mm_cmpgt_ps(axisDot, _mm_mul_ps(_mm_loadu_ps(&m_cutoff[i]), distance));
+		visible = _mm_andnot_ps(backFacing, visible);
+
+		int mask = _mm_movemask_ps(visible);
+		for (size_t j = 0; j < 4; j++)
+			m_visible[i + j] = (mask >> j) & 1;
+	}
+
+	for (size_t j = 0; j < count; j++)
+		m_visibleCount += m_visible[j];
+#else
+	for (; i < count; i++)
+	{
+		glm::vec3 center(m_centerX[i], m_centerY[i], m_centerZ[i]);
+		glm::vec3 axis(m_axisX[i], m_axisY[i], m_axisZ[i]);
+		glm::vec3 toApex = glm::vec3(m_apexX[i], m_apexY[i], m_apexZ[i]) - cameraPosition;
+
+		bool backFacing = glm::dot(toApex, axis) > m_cutoff[i] * glm::length(toApex);
+		m_visible[i] = frustum.isSphereVisible(center, m_radius[i]) && !backFacing;
+		m_visibleCount += m_visible[i];
+	}
+#endif
+}
\ No newline at end of file
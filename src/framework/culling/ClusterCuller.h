@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Frustum.h"
+#include "framework/model/Meshlet.h"
+#include "framework/model/Primitive.h"
+#include "framework/scene/SceneGraph.h"
+#include "framework/utils/DataView.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/// a drawIndexed call produced by culling
+struct DrawRange
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	//indices are relative to the primitive's first vertex
+	uint32_t vertexOffset;
+	uint32_t materialIndex;
+	//range of the frame's instance buffer, shader.vert reads the node of every instance from it with gl_InstanceIndex
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+};
+
+/// rejects meshlets outside the frustum or facing away from the camera, 4 at a time with sse.
+/// world space bounds are cached and only recomputed for meshlets whose scene graph node moved.
+/// only primitives with a single instance are culled per meshlet, instanced ones are culled per instance by the caller
+class ClusterCuller
+{
+public:
+	/// instances holds the scene graph node of every instance, see Model::getInstances()
+	void create(DataView<Meshlet> meshlets, DataView<Primitive> primitives, DataView<uint32_t> instances);
+
+	/// call after SceneGraph::update()
+	void updateBounds(const SceneGraph& sceneGraph);
+	/// tests every meshlet, frustum and cameraPosition are in world space
+	void update(const Frustum& frustum, const glm::vec3& cameraPosition);
+	/// visible meshlets of the primitive that are next to each other in the index buffer are merged into one draw
+	void appendVisible(const Primitive& primitive, uint32_t firstInstance, std::vector<DrawRange>& draws) const;
+
+	uint32_t getTestedCount() const { return static_cast<uint32_t>(m_meshlets.size()); }
+	uint32_t getVisibleCount() const { return m_visibleCount; }
+private:
+	//bounds in the space of the meshlet's node
+	std::vector<Meshlet> m_meshlets;
+	std::vector<uint32_t> m_nodes;
+	//culler slot of every meshlet of the model, invalidSlot for meshlets of instanced primitives
+	std::vector<uint32_t> m_slots;
+	static constexpr uint32_t invalidSlot = ~0u;
+	uint64_t m_boundsVersion = 0;
+
+	//structure of arrays, padded to a multiple of 4
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_radius;
+	std::vector<float> m_apexX;
+	std::vector<float> m_apexY;
+	std::vector<float> m_apexZ;
+	std::vector<float> m_axisX;
+	std::vector<float> m_axisY;
+	std::vector<float> m_axisZ;
+	std::vector<float> m_cutoff;
+
+	std::vector<uint8_t> m_visible;
+	uint32_t m_visibleCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "DepthPyramid.h"
+
+#include "framework/Renderer.h"
+#include "framework/utils/Utils.h"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr vk::Format pyramidFormat = vk::Format::eR32Sfloat;
+	constexpr uint32_t groupSize = 8;
+
+	vk::ImageAspectFlags getDepthAspect()
+	{
+		//a combined depth stencil image changes the layout of both aspects together
+		vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eDepth;
+		if (utils::hasStencilComponent(Renderer::getDevice().findDepthFormat()))
+			aspect |= vk::ImageAspectFlagBits::eStencil;
+		return aspect;
+	}
+}
+
+void DepthPyramid::create()
+{
+	m_depthExtent = Renderer::getSwapchainExtent();
+	m_width = std::max(m_depthExtent.width / 2, 1u);
+	m_height = std::max(m_depthExtent.height / 2, 1u);
+	uint32_t levelCount = 1;
+	while ((std::max(m_width, m_height) >> levelCount) > 0)
+		levelCount++;
+
+	m_image.setName("depth pyramid");
+	m_image.create(m_width, m_height, pyramidFormat, vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled, levelCount);
+	m_image.createView(pyramidFormat, vk::ImageAspectFlagBits::eColor);
+
+	m_levelViews.resize(levelCount);
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		vk::ImageViewCreateInfo createInfo;
+		createInfo.image = m_image.getHandle();
+		createInfo.viewType = vk::ImageViewType::e2D;
+		createInfo.format = pyramidFormat;
+		createInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1);
+		m_levelViews[level] = Renderer::getDeviceHandle().createImageView(createInfo);
+	}
+
+	m_sampler.create(vk::Filter::eNearest, vk::SamplerAddressMode::eClampToEdge);
+
+	m_descriptorSet.addBinding(vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eCompute, 0);
+	m_descriptorSet.addBinding(vk::DescriptorType::eStorageImage, vk::ShaderStageFlagBits::eCompute, 1);
+	m_descriptorSet.addPoolSize(vk::DescriptorType::eCombinedImageSampler, levelCount);
+	m_descriptorSet.addPoolSize(vk::DescriptorType::eStorageImage, levelCount);
+	m_descriptorSet.create();
+
+	Image& depth = Renderer::getDepthImage();
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		ImageDescriptor source = level == 0
+			? ImageDescriptor(depth.getView(), vk::ImageLayout::eDepthStencilReadOnlyOptimal, vk::DescriptorType::eCombinedImageSampler, m_sampler.handle)
+			: ImageDescriptor(m_levelViews[level - 1], vk::ImageLayout::eGeneral, vk::DescriptorType::eCombinedImageSampler, m_sampler.handle);
+		m_descriptorSet.writeDescriptor(source, 0, level);
+		m_descriptorSet.writeDescriptor(ImageDescriptor(m_levelViews[level], vk::ImageLayout::eGeneral, vk::DescriptorType::eStorageImage), 1, level);
+	}
+
+	m_pipeline.addDescriptorLayout(m_descriptorSet.getLayout());
+	m_pipeline.setPushConstantSize(sizeof(PushConstants));
+	m_pipeline.create("res/shaders/depth_pyramid.spv");
+}
+
+void DepthPyramid::destroy()
+{
+	m_pipeline.destroy();
+	m_pipeline = ComputePipeline();
+	//bindings are added again by the next create()
+	m_descriptorSet.destroy();
+	m_descriptorSet = DescriptorSet();
+	m_sampler.destroy();
+
+	for (auto view : m_levelViews)
+		Renderer::getDeviceHandle().destroyImageView(view);
+	m_levelViews.clear();
+	m_image.destroy();
+}
+
+bool DepthPyramid::isOutdated() const
+{
+	return Renderer::getSwapchainExtent() != m_depthExtent;
+}
+
+void DepthPyramid::build(vk::CommandBuffer cmd)
+{
+	vk::ImageSubresourceRange depthRange(getDepthAspect(), 0, 1, 0, 1);
+
+	//the depth of the finished pass is read by the first level
+	vk::ImageMemoryBarrier depthBarrier;
+	depthBarrier.oldLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+	depthBarrier.newLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+	depthBarrier.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+	depthBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+	depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depthBarrier.image = Renderer::getDepthImage().getHandle();
+	depthBarrier.subresourceRange = depthRange;
+
+	//the previous content is overwritten, earlier frames only have to be done reading it
+	vk::ImageMemoryBarrier pyramidBarrier;
+	pyramidBarrier.oldLayout = m_image.getCurrentLayout();
+	pyramidBarrier.newLayout = vk::ImageLayout::eGeneral;
+	pyramidBarrier.srcAccessMask = vk::AccessFlagBits::eNone;
+	pyramidBarrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+	pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.image = m_image.getHandle();
+	pyramidBarrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, getLevelCount(), 0, 1);
+	m_image.setCurrentLayout(vk::ImageLayout::eGeneral);
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, { depthBarrier, pyramidBarrier });
+
+	cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline.handle);
+
+	uint32_t sourceWidth = m_depthExtent.width;
+	uint32_t sourceHeight = m_depthExtent.height;
+	for (uint32_t level = 0; level < getLevelCount(); level++)
+	{
+		PushConstants constants;
+		constants.sourceWidth = sourceWidth;
+		constants.sourceHeight = sourceHeight;
+		constants.destinationWidth = std::max(m_width >> level, 1u);
+		constants.destinationHeight = std::max(m_height >> level, 1u);
+
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipeline.getLayout(), 0, { m_descriptorSet[level] }, {});
+		cmd.pushConstants(m_pipeline.getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushConstants), &constants);
+		cmd.dispatch((constants.destinationWidth + groupSize - 1) / groupSize, (constants.destinationHeight + groupSize - 1) / groupSize, 1);
+
+		//the next level reads this one, the culling shader reads all of them
+		vk::MemoryBarrier levelBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, { levelBarrier }, {}, {});
+
+		sourceWidth = constants.destinationWidth;
+		sourceHeight = constants.destinationHeight;
+	}
+
+	//the late pass tests and writes depth again
+	depthBarrier.oldLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+	depthBarrier.newLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+	depthBarrier.srcAccessMask = vk::AccessFlagBits::eNone;
+	depthBarrier.dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+		{}, {}, {}, { depthBarrier });
+}
+
+ImageDescriptor DepthPyramid::getDescriptor() const
+{
+	return ImageDescriptor(m_image.getView(), vk::ImageLayout::eGeneral, vk::DescriptorType::eCombinedImageSampler, m_sampler.handle);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "framework/image/Image.h"
+#include "framework/image/Sampler.h"
+#include "framework/image/ImageDescriptor.h"
+#include "framework/rendering/ComputePipeline.h"
+#include "framework/rendering/DescriptorSet.h"
+
+#include <vector>
+
+/// hierarchical depth buffer, every texel holds the farthest depth of the texels it covers in the level above.
+/// level 0 is half the size of the depth image, odd sizes are reduced conservatively. the image stays in general layout
+class DepthPyramid
+{
+public:
+	/// sized for the current swapchain extent
+	void create();
+	void destroy();
+
+	/// reduces the depth image into every level, recorded outside of a render pass after the depth has been written.
+	/// the depth image is a depth attachment again afterwards
+	void build(vk::CommandBuffer cmd);
+	/// the swapchain was resized since create()
+	bool isOutdated() const;
+	/// false if the reduction shader couldn't be loaded
+	bool isValid() const { return static_cast<bool>(m_pipeline.handle); }
+
+	/// every level for texelFetch, nearest filtering
+	ImageDescriptor getDescriptor() const;
+	uint32_t getWidth() const { return m_width; }
+	uint32_t getHeight() const { return m_height; }
+	uint32_t getLevelCount() const { return static_cast<uint32_t>(m_levelViews.size()); }
+private:
+	struct PushConstants
+	{
+		uint32_t sourceWidth;
+		uint32_t sourceHeight;
+		uint32_t destinationWidth;
+		uint32_t destinationHeight;
+	};
+
+	Image m_image;
+	std::vector<vk::ImageView> m_levelViews;
+	Sampler m_sampler;
+	ComputePipeline m_pipeline;
+	//one set per level, it reads the level above or the depth image
+	DescriptorSet m_descriptorSet;
+	vk::Extent2D m_depthExtent;
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+};
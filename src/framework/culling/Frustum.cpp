@@ -0,0 +1,44 @@
+#include "Frustum.h"
+
+Frustum Frustum::fromMatrix(const glm::mat4& matrix)
+{
+	//gribb/hartmann, glm is column major so the rows are gathered by hand
+	glm::mat4 m = glm::transpose(matrix);
+
+	Frustum frustum;
+	frustum.planes[0] = m[3] + m[0]; //left
+	frustum.planes[1] = m[3] - m[0]; //right
+	frustum.planes[2] = m[3] + m[1]; //bottom
+	frustum.planes[3] = m[3] - m[1]; //top
+	frustum.planes[4] = m[3] + m[2]; //near, conservative for a [0, 1] depth range
+	frustum.planes[5] = m[3] - m[2]; //far
+
+	for (auto& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	return frustum;
+}
+
+bool Frustum::isSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (auto& plane : planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	}
+
+	return true;
+}
+
+bool Frustum::isBoxVisible(const glm::vec3& center, const glm::vec3& extent) const
+{
+	for (auto& plane : planes)
+	{
+		//projected half size of the box onto the plane normal
+		float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/// planes point inwards, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all of them
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	/// extracts the planes in the space the matrix transforms from, e.g. proj * view * model gives model space planes
+	static Frustum fromMatrix(const glm::mat4& matrix);
+
+	bool isSphereVisible(const glm::vec3& center, float radius) const;
+	/// extent is half the size of the axis aligned box
+	bool isBoxVisible(const glm::vec3& center, const glm::vec3& extent) const;
+};
\ No newline at end of file
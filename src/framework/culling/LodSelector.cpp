@@ -0,0 +1,34 @@
+#include "LodSelector.h"
+
+#include "../scene/SceneGraph.h"
+
+#include <algorithm>
+#include <cmath>
+
+void LodSelector::update(const glm::mat4& projection, float viewportHeight, const glm::vec3& cameraPosition)
+{
+	//pixels covered by one unit at distance one, proj[1][1] is 1 / tan(fov / 2) and negated for vulkan
+	m_projectionScale = std::abs(projection[1][1]) * viewportHeight * 0.5f;
+	m_cameraPosition = cameraPosition;
+}
+
+uint32_t LodSelector::select(const Primitive& primitive, DataView<MeshLod> lods, const glm::mat4& world) const
+{
+	if (m_threshold <= 0.0f || primitive.lodCount <= 1)
+		return 0;
+
+	//closest point of the bounding sphere, the camera inside it always gets full detail
+	float scale = utils::getMaxScale(world);
+	glm::vec3 center = world * glm::vec4(primitive.center, 1.0f);
+	float distance = glm::length(center - m_cameraPosition) - primitive.radius * scale;
+	if (distance <= 0.0f)
+		return 0;
+
+	for (uint32_t lod = primitive.lodCount - 1; lod > 0; lod--)
+	{
+		if (lods[primitive.firstLod + lod].error * scale * m_projectionScale / distance <= m_threshold)
+			return lod;
+	}
+
+	return 0;
+}
\ No newline at end of file
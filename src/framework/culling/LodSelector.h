@@ -0,0 +1,24 @@
+#pragma once
+
+#include "framework/model/Primitive.h"
+#include "framework/utils/DataView.h"
+
+#include <glm/glm.hpp>
+
+/// picks the coarsest lod whose simplification error projects to at most threshold pixels
+class LodSelector
+{
+public:
+	/// 0 always selects the original geometry
+	void setThreshold(float pixels) { m_threshold = pixels; }
+	float getThreshold() const { return m_threshold; }
+
+	/// cameraPosition is in world space
+	void update(const glm::mat4& projection, float viewportHeight, const glm::vec3& cameraPosition);
+	/// world is the matrix of the primitive's node
+	uint32_t select(const Primitive& primitive, DataView<MeshLod> lods, const glm::mat4& world) const;
+private:
+	float m_threshold = 1.0f;
+	float m_projectionScale = 1.0f;
+	glm::vec3 m_cameraPosition = glm::vec3(0.0f);
+};
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "OcclusionCuller.h"
+
+#include "Frustum.h"
+#include "framework/Renderer.h"
+#include "framework/utils/Log.h"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr uint32_t countsSize = 4 * sizeof(uint32_t);
+	constexpr uint32_t commandStride = sizeof(vk::DrawIndexedIndirectCommand);
+}
+
+void OcclusionCuller::create(uint32_t objectCount, FrameAllocator& frameAllocator)
+{
+	m_objectCount = std::max(objectCount, 1u);
+	m_frameAllocator = &frameAllocator;
+
+	m_commands.setName("occlusion commands");
+	m_commands.addUsage(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+	m_commands.create(2 * m_objectCount * commandStride, BufferIntent::eStatic, BufferPlacement::eDeviceLocal);
+
+	m_counts.setName("occlusion counts");
+	m_counts.addUsage(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	m_counts.create(countsSize, BufferIntent::eStatic, BufferPlacement::eDeviceLocal);
+
+	m_visibility.setName("occlusion visibility");
+	m_visibility.create(m_objectCount * sizeof(uint32_t), BufferIntent::eStatic, BufferPlacement::eDeviceLocal);
+	m_visibilityCleared = false;
+
+	m_readbacks.resize(Device::maxFramesInFlight);
+	for (auto& readback : m_readbacks)
+	{
+		readback.setName("occlusion counts readback");
+		readback.create(countsSize, BufferIntent::eReadback);
+	}
+	m_readbackWritten.assign(Device::maxFramesInFlight, false);
+
+	m_depthPyramid.create();
+
+	//the objects and the view move to the frame allocator with dynamic offsets
+	m_descriptorSet.addBinding(vk::DescriptorType::eUniformBufferDynamic, vk::ShaderStageFlagBits::eCompute, 0);
+	m_descriptorSet.addBinding(vk::DescriptorType::eStorageBufferDynamic, vk::ShaderStageFlagBits::eCompute, 1);
+	m_descriptorSet.addBinding(vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute, 2);
+	m_descriptorSet.addBinding(vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute, 3);
+	m_descriptorSet.addBinding(vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute, 4);
+	m_descriptorSet.addBinding(vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eCompute, 5);
+	m_descriptorSet.addPoolSize(vk::DescriptorType::eUniformBufferDynamic, 1);
+	m_descriptorSet.addPoolSize(vk::DescriptorType::eStorageBufferDynamic, 1);
+	m_descriptorSet.addPoolSize(vk::DescriptorType::eStorageBuffer, 3);
+	m_descriptorSet.addPoolSize(vk::DescriptorType::eCombinedImageSampler, 1);
+	m_descriptorSet.setSetCount(1);
+	m_descriptorSet.create();
+
+	m_descriptorSet.writeDescriptor(frameAllocator.getDescriptor(vk::DescriptorType::eUniformBufferDynamic, sizeof(ShaderCullData)), 0, 0);
+	m_descriptorSet.writeDescriptor(frameAllocator.getDescriptor(vk::DescriptorType::eStorageBufferDynamic, m_objectCount * sizeof(ShaderCullObject)), 1, 0);
+	m_descriptorSet.writeDescriptor(m_commands, 2, 0);
+	m_descriptorSet.writeDescriptor(m_counts, 3, 0);
+	m_descriptorSet.writeDescriptor(m_visibility, 4, 0);
+	writePyramidDescriptor();
+
+	m_pipeline.addDescriptorLayout(m_descriptorSet.getLayout());
+	m_pipeline.setPushConstantSize(sizeof(uint32_t));
+	m_pipeline.create("res/shaders/occlusion_cull.spv");
+}
+
+void OcclusionCuller::destroy()
+{
+	m_pipeline.destroy();
+	m_descriptorSet.destroy();
+	m_depthPyramid.destroy();
+
+	m_commands.destroy();
+	m_counts.destroy();
+	m_visibility.destroy();
+	for (auto& readback : m_readbacks)
+		readback.destroy();
+}
+
+void OcclusionCuller::writePyramidDescriptor()
+{
+	m_descriptorSet.writeDescriptor(m_depthPyramid.getDescriptor(), 5, 0);
+}
+
+bool OcclusionCuller::update(DataView<ShaderCullObject> objects, const glm::mat4& view, const glm::mat4& proj)
+{
+	if (objects.size() > m_objectCount)
+		Log::error("error in OcclusionCuller::update(): {} objects exceed the {} the culler was created for", objects.size(), m_objectCount);
+
+	Frustum frustum = Frustum::fromMatrix(proj * view);
+	glm::vec3 cameraPosition = glm::inverse(view)[3];
+
+	ShaderCullData data;
+	data.view = view;
+	for (int i = 0; i < 6; i++)
+		data.planes[i] = frustum.planes[i];
+	data.projection = { proj[0][0], proj[1][1], proj[2][2], proj[3][2] };
+	//spheres closer than the near plane can't be projected, they are always visible
+	data.nearDistance = std::max(-(glm::dot(glm::vec3(frustum.planes[4]), cameraPosition) + frustum.planes[4].w), 0.0f);
+	data.objectCount = std::min(static_cast<uint32_t>(objects.size()), m_objectCount);
+	data.lateCommandOffset = m_objectCount;
+	data.pyramidWidth = m_depthPyramid.getWidth();
+	data.pyramidHeight = m_depthPyramid.getHeight();
+
+	m_cullDataOffset = m_frameAllocator->push(data);
+	m_objectOffset = m_frameAllocator->push(objects, m_objectCount * sizeof(ShaderCullObject));
+	return m_cullDataOffset != FrameAllocator::invalidOffset && m_objectOffset != FrameAllocator::invalidOffset;
+}
+
+void OcclusionCuller::beginFrame(vk::CommandBuffer cmd)
+{
+	//the swapchain was recreated after waiting for the device, nothing uses the old pyramid anymore
+	if (m_depthPyramid.isOutdated())
+	{
+		Renderer::getDevice().handle.waitIdle();
+		m_depthPyramid.destroy();
+		m_depthPyramid.create();
+		writePyramidDescriptor();
+	}
+
+	//earlier frames draw from and write to the same buffers
+	vk::MemoryBarrier previousFrame(vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite,
+		vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+		vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, {}, { previousFrame }, {}, {});
+
+	cmd.fillBuffer(m_counts.handle, 0, VK_WHOLE_SIZE, 0);
+	if (!m_visibilityCleared)
+	{
+		cmd.fillBuffer(m_visibility.handle, 0, VK_WHOLE_SIZE, 0);
+		m_visibilityCleared = true;
+	}
+
+	vk::MemoryBarrier cleared(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, { cleared }, {}, {});
+}
+
+void OcclusionCuller::cull(vk::CommandBuffer cmd, OcclusionPhase phase)
+{
+	uint32_t phaseIndex = static_cast<uint32_t>(phase);
+
+	cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline.handle);
+	cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipeline.getLayout(), 0, { m_descriptorSet[0] }, { m_cullDataOffset, m_objectOffset });
+	cmd.pushConstants(m_pipeline.getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t), &phaseIndex);
+	cmd.dispatch((m_objectCount + groupSize - 1) / groupSize, 1, 1);
+
+	vk::MemoryBarrier written(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eTransferRead);
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eTransfer,
+		{}, { written }, {}, {});
+
+	if (phase != OcclusionPhase::eLate)
+		return;
+
+	//the counts are final after the late phase, the cpu reads them once the frame's fence signaled
+	uint32_t frameIndex = Renderer::getCurrentFrameIndex();
+	cmd.copyBuffer(m_counts.handle, m_readbacks[frameIndex].handle, vk::BufferCopy(0, 0, countsSize));
+	m_readbackWritten[frameIndex] = true;
+
+	vk::MemoryBarrier copied(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, { copied }, {}, {});
+}
+
+void OcclusionCuller::draw(vk::CommandBuffer cmd, OcclusionPhase phase)
+{
+	uint32_t phaseIndex = static_cast<uint32_t>(phase);
+	cmd.drawIndexedIndirectCount(m_commands.handle, phaseIndex * m_objectCount * commandStride,
+		m_counts.handle, phaseIndex * sizeof(uint32_t), m_objectCount, commandStride);
+}
+
+OcclusionCounts OcclusionCuller::getCounts(uint32_t frameIndex)
+{
+	OcclusionCounts counts;
+	if (!m_readbackWritten[frameIndex])
+		return counts;
+
+	auto& readback = m_readbacks[frameIndex];
+	readback.invalidate();
+	auto* values = static_cast<const uint32_t*>(readback.map());
+	counts.earlyDraws = values[0];
+	counts.lateDraws = values[1];
+	counts.triangles = values[2];
+	readback.unmap();
+	return counts;
+}
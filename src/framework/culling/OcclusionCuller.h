@@ -0,0 +1,84 @@
+#pragma once
+
+#include "DepthPyramid.h"
+#include "framework/buffer/FrameAllocator.h"
+#include "framework/buffer/StorageBuffer.h"
+#include "framework/rendering/ComputePipeline.h"
+#include "framework/rendering/DescriptorSet.h"
+#include "framework/utils/DataView.h"
+#include "ShaderMatrixInfo.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+enum class OcclusionPhase : uint32_t
+{
+	/// objects that were visible last frame, their depth builds the pyramid
+	eEarly,
+	/// every other object in the frustum, tested against the pyramid
+	eLate,
+};
+
+/// draws of a frame counted on the gpu
+struct OcclusionCounts
+{
+	uint32_t earlyDraws = 0;
+	uint32_t lateDraws = 0;
+	uint32_t triangles = 0;
+};
+
+/// two phase occlusion culling on the gpu. the early phase draws what was visible last frame, its depth is reduced into a DepthPyramid
+/// and the late phase draws the objects that turned out visible against it. every object is one draw of one instance,
+/// the commands and their count are written by a compute shader and drawn with drawIndexedIndirectCount
+class OcclusionCuller
+{
+public:
+	/// needs Device::supportsDrawIndirectCount()
+	void create(uint32_t objectCount, FrameAllocator& frameAllocator);
+	void destroy();
+
+	/// writes the objects and the view into the frame allocator, call before FrameAllocator::flush().
+	/// returns false if they didn't fit, cull() must not be recorded then
+	bool update(DataView<ShaderCullObject> objects, const glm::mat4& view, const glm::mat4& proj);
+	/// clears the counts of the frame, recorded outside of a render pass before the early phase
+	void beginFrame(vk::CommandBuffer cmd);
+	/// writes the commands of a phase, recorded outside of a render pass. the late phase needs buildPyramid() first
+	void cull(vk::CommandBuffer cmd, OcclusionPhase phase);
+	/// draws the commands of a phase with the bound graphics pipeline, geometry and descriptors
+	void draw(vk::CommandBuffer cmd, OcclusionPhase phase);
+	/// reduces the depth of the early phase, recorded outside of a render pass
+	void buildPyramid(vk::CommandBuffer cmd) { m_depthPyramid.build(cmd); }
+	/// every object is treated as not visible last frame, e.g. after the camera jumped
+	void resetVisibility() { m_visibilityCleared = false; }
+
+	/// false before create() or if one of the compute shaders couldn't be loaded, nothing may be recorded then
+	bool isValid() const { return m_pipeline.handle && m_depthPyramid.isValid(); }
+
+	/// counts of the last frame recorded with frameIndex, call once its fence has signaled
+	OcclusionCounts getCounts(uint32_t frameIndex);
+	uint32_t getObjectCount() const { return m_objectCount; }
+private:
+	void writePyramidDescriptor();
+private:
+	static constexpr uint32_t groupSize = 64;
+
+	uint32_t m_objectCount = 0;
+	FrameAllocator* m_frameAllocator = nullptr;
+	uint32_t m_cullDataOffset = 0;
+	uint32_t m_objectOffset = 0;
+
+	//room for the commands of both phases, the late ones start at m_objectCount
+	StorageBuffer m_commands;
+	//early draws, late draws, triangles
+	StorageBuffer m_counts;
+	//1 for the objects drawn last frame, written by the late phase
+	StorageBuffer m_visibility;
+	bool m_visibilityCleared = false;
+	//m_counts copied at the end of every frame in flight
+	std::vector<StorageBuffer> m_readbacks;
+	std::vector<bool> m_readbackWritten;
+
+	DepthPyramid m_depthPyramid;
+	ComputePipeline m_pipeline;
+	DescriptorSet m_descriptorSet;
+};
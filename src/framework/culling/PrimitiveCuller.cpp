@@ -0,0 +1,195 @@
+#include "PrimitiveCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+#define PRIMITIVE_CULLER_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PRIMITIVE_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+void PrimitiveCuller::create(DataView<Primitive> primitives, DataView<uint32_t> instances)
+{
+	m_localBounds.clear();
+	m_nodes.clear();
+	m_primitives.clear();
+	m_firstObjects.clear();
+	for (uint32_t primitive = 0; primitive < primitives.size(); primitive++)
+	{
+		auto& bounds = primitives[primitive];
+		m_firstObjects.push_back(static_cast<uint32_t>(m_nodes.size()));
+		for (uint32_t i = bounds.firstInstance; i < bounds.firstInstance + bounds.instanceCount; i++)
+		{
+			m_localBounds.push_back({ bounds.center, (bounds.boundsMax - bounds.boundsMin) * 0.5f, bounds.radius });
+			m_nodes.push_back(instances[i]);
+			m_primitives.push_back(primitive);
+		}
+	}
+
+	resize(static_cast<uint32_t>(m_nodes.size()));
+}
+
+void PrimitiveCuller::create(uint32_t objectCount)
+{
+	m_localBounds.clear();
+	m_nodes.clear();
+	m_primitives.clear();
+	m_firstObjects.clear();
+	resize(objectCount);
+}
+
+void PrimitiveCuller::resize(uint32_t objectCount)
+{
+	m_objectCount = objectCount;
+
+	size_t padded = (size_t(objectCount) + 7) & ~size_t(7);
+	for (auto* values : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_radius })
+		values->assign(padded, 0.0f);
+
+	m_visible.assign(padded, 0);
+	m_visibleObjects.clear();
+	m_visiblePrimitives.clear();
+	m_boundsVersion = 0;
+}
+
+void PrimitiveCuller::setBounds(uint32_t object, const glm::vec3& center, const glm::vec3& extent, float radius)
+{
+	m_centerX[object] = center.x;
+	m_centerY[object] = center.y;
+	m_centerZ[object] = center.z;
+	m_extentX[object] = extent.x;
+	m_extentY[object] = extent.y;
+	m_extentZ[object] = extent.z;
+	m_radius[object] = radius;
+}
+
+void PrimitiveCuller::updateBounds(const SceneGraph& sceneGraph)
+{
+	if (sceneGraph.getVersion() == m_boundsVersion)
+		return;
+
+	for (uint32_t i = 0; i < m_nodes.size(); i++)
+	{
+		if (sceneGraph.getNodeVersion(m_nodes[i]) <= m_boundsVersion)
+			continue;
+
+		auto& bounds = m_localBounds[i];
+		const glm::mat4& world = sceneGraph.getWorldMatrix(m_nodes[i]);
+
+		//the box that encloses the transformed box, each world axis gathers the extent of every rotated model axis
+		glm::mat3 absolute(glm::abs(glm::vec3(world[0])), glm::abs(glm::vec3(world[1])), glm::abs(glm::vec3(world[2])));
+		setBounds(i, world * glm::vec4(bounds.center, 1.0f), absolute * bounds.extent, bounds.radius * utils::getMaxScale(world));
+	}
+
+	m_boundsVersion = sceneGraph.getVersion();
+}
+
+void PrimitiveCuller::update(const Frustum& frustum)
+{
+	//visible = for every plane dot(plane.xyz, center) + plane.w >= -min(box radius, sphere radius),
+	//where the box radius is the extent projected onto the plane normal. either bound being outside culls the object
+	m_visibleObjects.clear();
+	size_t i = 0;
+
+#if defined(PRIMITIVE_CULLER_AVX)
+	for (; i < m_centerX.size(); i += 8)
+	{
+		__m256 centerX = _mm256_loadu_ps(&m_centerX[i]);
+		__m256 centerY = _mm256_loadu_ps(&m_centerY[i]);
+		__m256 centerZ = _mm256_loadu_ps(&m_centerZ[i]);
+		__m256 extentX = _mm256_loadu_ps(&m_extentX[i]);
+		__m256 extentY = _mm256_loadu_ps(&m_extentY[i]);
+		__m256 extentZ = _mm256_loadu_ps(&m_extentZ[i]);
+		__m256 radius = _mm256_loadu_ps(&m_radius[i]);
+
+		__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (auto& plane : frustum.planes)
+		{
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(plane.x)), _mm256_mul_ps(centerY, _mm256_set1_ps(plane.y))),
+				_mm256_add_ps(_mm256_mul_ps(centerZ, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+			__m256 boxRadius = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(std::abs(plane.x))), _mm256_mul_ps(extentY, _mm256_set1_ps(std::abs(plane.y)))),
+				_mm256_mul_ps(extentZ, _mm256_set1_ps(std::abs(plane.z))));
+			__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_min_ps(boxRadius, radius));
+			visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+		}
+
+		appendVisible(i, _mm256_movemask_ps(visible), 8);
+	}
+#elif defined(PRIMITIVE_CULLER_SSE2)
+	for (; i < m_centerX.size(); i += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(&m_centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&m_centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&m_centerZ[i]);
+		__m128 extentX = _mm_loadu_ps(&m_extentX[i]);
+		__m128 extentY = _mm_loadu_ps(&m_extentY[i]);
+		__m128 extentZ = _mm_loadu_ps(&m_extentZ[i]);
+		__m128 radius = _mm_loadu_ps(&m_radius[i]);
+
+		__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (auto& plane : frustum.planes)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+			__m128 boxRadius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(std::abs(plane.x))), _mm_mul_ps(extentY, _mm_set1_ps(std::abs(plane.y)))),
+				_mm_mul_ps(extentZ, _mm_set1_ps(std::abs(plane.z))));
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_min_ps(boxRadius, radius));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		appendVisible(i, _mm_movemask_ps(visible), 4);
+	}
+#else
+	for (; i < m_objectCount; i++)
+	{
+		glm::vec3 center(m_centerX[i], m_centerY[i], m_centerZ[i]);
+		glm::vec3 extent(m_extentX[i], m_extentY[i], m_extentZ[i]);
+		appendVisible(i, frustum.isSphereVisible(center, m_radius[i]) && frustum.isBoxVisible(center, extent), 1);
+	}
+#endif
+
+	gatherPrimitives();
+}
+
+void PrimitiveCuller::setAllVisible()
+{
+	std::fill(m_visible.begin(), m_visible.end(), 1);
+	m_visibleObjects.resize(m_objectCount);
+	for (uint32_t i = 0; i < m_objectCount; i++)
+		m_visibleObjects[i] = i;
+
+	gatherPrimitives();
+}
+
+void PrimitiveCuller::appendVisible(size_t first, int mask, size_t count)
+{
+	for (size_t j = 0; j < count; j++)
+	{
+		bool visible = (mask >> j) & 1;
+		m_visible[first + j] = visible;
+		//padding behind the last object is never reported
+		if (visible && first + j < m_objectCount)
+			m_visibleObjects.push_back(static_cast<uint32_t>(first + j));
+	}
+}
+
+void PrimitiveCuller::gatherPrimitives()
+{
+	m_visiblePrimitives.clear();
+	if (m_primitives.empty())
+		return;
+
+	for (uint32_t object : m_visibleObjects)
+	{
+		uint32_t primitive = m_primitives[object];
+		if (m_visiblePrimitives.empty() || m_visiblePrimitives.back() != primitive)
+			m_visiblePrimitives.push_back(primitive);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Frustum.h"
+#include "framework/model/Primitive.h"
+#include "framework/scene/SceneGraph.h"
+#include "framework/utils/DataView.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/// tests the bounding box and sphere of every primitive instance against the frustum, 8 at a time with avx or 4 with sse.
+/// world space bounds are cached and only recomputed for instances whose scene graph node moved.
+/// an object is one instance of one primitive, the objects of a primitive are consecutive
+class PrimitiveCuller
+{
+public:
+	/// instances holds the scene graph node of every instance, see Model::getInstances()
+	void create(DataView<Primitive> primitives, DataView<uint32_t> instances);
+	/// objects without a model, their bounds are set with setBounds()
+	void create(uint32_t objectCount);
+
+	/// world space bounds of an object, the sphere shares the center of the box
+	void setBounds(uint32_t object, const glm::vec3& center, const glm::vec3& extent, float radius);
+	/// call after SceneGraph::update()
+	void updateBounds(const SceneGraph& sceneGraph);
+	/// tests every object, the frustum is in world space
+	void update(const Frustum& frustum);
+	/// marks every object visible without testing
+	void setAllVisible();
+
+	uint32_t getFirstObject(uint32_t primitive) const { return m_firstObjects[primitive]; }
+	/// primitive and scene graph node of an object, only for culler with a model
+	uint32_t getPrimitive(uint32_t object) const { return m_primitives[object]; }
+	uint32_t getNode(uint32_t object) const { return m_nodes[object]; }
+	/// world space center and radius of the bounding sphere
+	glm::vec4 getSphere(uint32_t object) const { return { m_centerX[object], m_centerY[object], m_centerZ[object], m_radius[object] }; }
+	bool isVisible(uint32_t object) const { return m_visible[object] != 0; }
+	/// visible objects in ascending order
+	const std::vector<uint32_t>& getVisibleObjects() const { return m_visibleObjects; }
+	/// primitives with at least one visible instance in ascending order, empty for culler without a model
+	const std::vector<uint32_t>& getVisiblePrimitives() const { return m_visiblePrimitives; }
+
+	uint32_t getTestedCount() const { return m_objectCount; }
+	uint32_t getVisibleCount() const { return static_cast<uint32_t>(m_visibleObjects.size()); }
+private:
+	void resize(uint32_t objectCount);
+	/// stores the visibility of count objects starting at first, bit j of mask is the object first + j
+	void appendVisible(size_t first, int mask, size_t count);
+	void gatherPrimitives();
+private:
+	struct LocalBounds
+	{
+		glm::vec3 center;
+		glm::vec3 extent;
+		float radius;
+	};
+
+	uint32_t m_objectCount = 0;
+	//model space bounds, scene graph node and primitive of every object, empty without a model
+	std::vector<LocalBounds> m_localBounds;
+	std::vector<uint32_t> m_nodes;
+	std::vector<uint32_t> m_primitives;
+	std::vector<uint32_t> m_firstObjects;
+	uint64_t m_boundsVersion = 0;
+
+	//structure of arrays, padded to a multiple of 8
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_extentZ;
+	std::vector<float> m_radius;
+
+	std::vector<uint8_t> m_visible;
+	std::vector<uint32_t> m_visibleObjects;
+	std::vector<uint32_t> m_visiblePrimitives;
+};
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+/// counters of the last recorded frame
+struct FrameStats
+{
+	uint32_t drawCalls = 0;
+	/// draw commands recorded into the command buffer, one per material with multi draw indirect
+	uint32_t recordedDrawCalls = 0;
+	/// draw commands of the depth pre-pass, included in recordedDrawCalls
+	uint32_t prepassDrawCalls = 0;
+	/// secondary command buffers the draws were recorded into by worker threads, 0 when recorded on the main thread
+	uint32_t secondaryBuffers = 0;
+	/// bindDescriptorSets calls, one per material without bindless materials
+	uint32_t descriptorBinds = 0;
+	/// material binds skipped because the render queue put draws of the same material next to each other
+	uint32_t bindsSaved = 0;
+	uint64_t triangles = 0;
+	/// primitive instances tested against the frustum, 0 with frustum culling disabled
+	uint32_t objectsTested = 0;
+	uint32_t objectsVisible = 0;
+	uint32_t clustersTested = 0;
+	uint32_t clustersVisible = 0;
+	/// draws that use a simplified lod
+	uint32_t simplifiedDraws = 0;
+	/// instances drawn by all draws, more than drawCalls when meshes are instanced
+	uint32_t instances = 0;
+	/// objects the gpu occlusion culling drew after the depth pyramid, they weren't visible the frame before.
+	/// with occlusion culling the counts come from the gpu and lag behind by the frames in flight
+	uint32_t lateDraws = 0;
+};
\ No newline at end of file
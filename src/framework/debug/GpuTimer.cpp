@@ -0,0 +1,46 @@
+#include "GpuTimer.h"
+
+#include "../Device.h"
+
+void GpuTimer::create(Device& device)
+{
+	m_device = &device;
+	m_timestampPeriod = m_device->getGpu().getProperties().limits.timestampPeriod;
+	m_written.assign(Device::maxFramesInFlight, false);
+
+	vk::QueryPoolCreateInfo createInfo;
+	createInfo.queryType = vk::QueryType::eTimestamp;
+	createInfo.queryCount = Device::maxFramesInFlight * 2;
+	m_queryPool = m_device->handle.createQueryPool(createInfo);
+}
+
+void GpuTimer::destroy()
+{
+	m_device->handle.destroyQueryPool(m_queryPool);
+}
+
+void GpuTimer::begin(vk::CommandBuffer cmd, uint32_t frameIndex)
+{
+	cmd.resetQueryPool(m_queryPool, frameIndex * 2, 2);
+	cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_queryPool, frameIndex * 2);
+}
+
+void GpuTimer::end(vk::CommandBuffer cmd, uint32_t frameIndex)
+{
+	cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_queryPool, frameIndex * 2 + 1);
+	m_written[frameIndex] = true;
+}
+
+double GpuTimer::getElapsedMs(uint32_t frameIndex)
+{
+	if (!m_written[frameIndex])
+		return -1.0;
+
+	uint64_t timestamps[2] = {};
+	auto result = m_device->handle.getQueryPoolResults(m_queryPool, frameIndex * 2, 2, sizeof(timestamps), timestamps,
+		sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+	if (result != vk::Result::eSuccess)
+		return -1.0;
+
+	return static_cast<double>(timestamps[1] - timestamps[0]) * m_timestampPeriod / 1000000.0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+
+class Device;
+
+/// measures gpu time between begin() and end() with timestamp queries, one query pair per frame in flight
+class GpuTimer
+{
+public:
+	void create(Device& device);
+	void destroy();
+
+	/// must be recorded outside of a render pass
+	void begin(vk::CommandBuffer cmd, uint32_t frameIndex);
+	void end(vk::CommandBuffer cmd, uint32_t frameIndex);
+
+	/// result of the last begin/end pair recorded for frameIndex, call once that frame's fence has been waited on.
+	/// returns a negative value when nothing has been measured yet
+	double getElapsedMs(uint32_t frameIndex);
+private:
+	Device* m_device = nullptr;
+	vk::QueryPool m_queryPool;
+	double m_timestampPeriod = 1.0;
+	std::vector<bool> m_written;
+};
@@ -0,0 +1,231 @@
+#include "MemoryStats.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "../utils/Log.h"
+#include "../Device.h"
+
+namespace
+{
+	constexpr double megabyte = 1024.0 * 1024.0;
+
+	std::string escapeJson(const std::string& text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+}
+
+void MemoryStats::create(Device& device)
+{
+	m_device = &device;
+	m_frame = 0;
+}
+
+void MemoryStats::destroy()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& [allocation, entry] : m_allocations)
+		Log::warn("leaked {} allocation '{}' of {} bytes", getName(entry.category), entry.name, entry.size);
+
+	m_allocations.clear();
+	m_categories = {};
+	m_heaps.clear();
+	m_device = nullptr;
+}
+
+void MemoryStats::track(VmaAllocation allocation, MemoryCategory category, const std::string& name, vk::ObjectType type, uint64_t object)
+{
+	if (allocation == VK_NULL_HANDLE || !m_device)
+		return;
+
+	VmaAllocationInfo info = {};
+	vmaGetAllocationInfo(m_device->getAllocator(), allocation, &info);
+
+	std::string label = name.empty() ? getName(category) : name;
+	vmaSetAllocationName(m_device->getAllocator(), allocation, label.c_str());
+	m_device->setDebugName(type, object, label.c_str());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_allocations[allocation] = { category, info.size, label };
+
+	CategoryUsage& usage = m_categories[static_cast<size_t>(category)];
+	usage.bytes += info.size;
+	usage.peakBytes = std::max(usage.peakBytes, usage.bytes);
+	usage.allocations++;
+}
+
+void MemoryStats::untrack(VmaAllocation allocation)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto entry = m_allocations.find(allocation);
+	if (entry == m_allocations.end())
+		return;
+
+	CategoryUsage& usage = m_categories[static_cast<size_t>(entry->second.category)];
+	usage.bytes -= entry->second.size;
+	usage.allocations--;
+	m_allocations.erase(entry);
+}
+
+void MemoryStats::update()
+{
+	if (!m_device)
+		return;
+
+	VmaAllocator allocator = m_device->getAllocator();
+
+	//vma refreshes the driver's budget numbers when the frame index changes
+	vmaSetCurrentFrameIndex(allocator, ++m_frame);
+
+	const VkPhysicalDeviceMemoryProperties* properties = nullptr;
+	vmaGetMemoryProperties(allocator, &properties);
+
+	//without VK_EXT_memory_budget the budget is an estimate and usage only counts vma's own blocks
+	std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets = {};
+	vmaGetHeapBudgets(allocator, budgets.data());
+
+	m_heaps.resize(properties->memoryHeapCount);
+	for (uint32_t i = 0; i < properties->memoryHeapCount; i++)
+	{
+		HeapUsage& heap = m_heaps[i];
+		heap.size = properties->memoryHeaps[i].size;
+		heap.deviceLocal = properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		heap.budget = budgets[i].budget;
+		heap.usage = budgets[i].usage;
+		heap.blockBytes = budgets[i].statistics.blockBytes;
+		heap.allocationBytes = budgets[i].statistics.allocationBytes;
+		heap.blockCount = budgets[i].statistics.blockCount;
+		heap.allocationCount = budgets[i].statistics.allocationCount;
+
+		//only changes are logged, a heap can stay over budget for many frames
+		bool overBudget = heap.usage > heap.budget;
+		if (overBudget && !heap.overBudget)
+			Log::warn("memory heap {} is over budget: {:.1f} of {:.1f} MB", i, heap.usage / megabyte, heap.budget / megabyte);
+		else if (!overBudget && heap.overBudget)
+			Log::info("memory heap {} is back within budget: {:.1f} of {:.1f} MB", i, heap.usage / megabyte, heap.budget / megabyte);
+		heap.overBudget = overBudget;
+	}
+}
+
+CategoryUsage MemoryStats::getCategoryUsage(MemoryCategory category) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_categories[static_cast<size_t>(category)];
+}
+
+bool MemoryStats::writeJson(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file)
+	{
+		Log::error("error in MemoryStats::writeJson(): failed to open {}", path);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	file << "{\n\t\"frame\": " << m_frame << ",\n\t\"heaps\": [\n";
+	for (size_t i = 0; i < m_heaps.size(); i++)
+	{
+		const HeapUsage& heap = m_heaps[i];
+		file << "\t\t{ \"index\": " << i << ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false")
+			<< ", \"size\": " << heap.size << ", \"budget\": " << heap.budget << ", \"usage\": " << heap.usage
+			<< ", \"blockBytes\": " << heap.blockBytes << ", \"allocationBytes\": " << heap.allocationBytes
+			<< ", \"blockCount\": " << heap.blockCount << ", \"allocationCount\": " << heap.allocationCount << " }"
+			<< (i + 1 < m_heaps.size() ? ",\n" : "\n");
+	}
+
+	file << "\t],\n\t\"categories\": {\n";
+	for (size_t i = 0; i < m_categories.size(); i++)
+	{
+		const CategoryUsage& usage = m_categories[i];
+		file << "\t\t\"" << getName(static_cast<MemoryCategory>(i)) << "\": { \"bytes\": " << usage.bytes
+			<< ", \"peakBytes\": " << usage.peakBytes << ", \"allocations\": " << usage.allocations << " }"
+			<< (i + 1 < m_categories.size() ? ",\n" : "\n");
+	}
+
+	file << "\t},\n\t\"allocations\": [\n";
+	size_t written = 0;
+	for (const auto& [allocation, entry] : m_allocations)
+	{
+		file << "\t\t{ \"name\": \"" << escapeJson(entry.name) << "\", \"category\": \"" << getName(entry.category)
+			<< "\", \"size\": " << entry.size << " }" << (++written < m_allocations.size() ? ",\n" : "\n");
+	}
+	file << "\t]\n}\n";
+
+	return true;
+}
+
+bool MemoryStats::writeCsv(const std::string& path) const
+{
+	bool header = !std::ifstream(path).good();
+	std::ofstream file(path, std::ios::app);
+	if (!file)
+	{
+		Log::error("error in MemoryStats::writeCsv(): failed to open {}", path);
+		return false;
+	}
+
+	if (header)
+		file << "frame,kind,name,bytes,budget,usage,blockBytes,allocations\n";
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (size_t i = 0; i < m_heaps.size(); i++)
+	{
+		const HeapUsage& heap = m_heaps[i];
+		file << m_frame << ",heap," << i << "," << heap.allocationBytes << "," << heap.budget << "," << heap.usage << ","
+			<< heap.blockBytes << "," << heap.allocationCount << "\n";
+	}
+
+	for (size_t i = 0; i < m_categories.size(); i++)
+	{
+		const CategoryUsage& usage = m_categories[i];
+		file << m_frame << ",category," << getName(static_cast<MemoryCategory>(i)) << "," << usage.bytes << ",,,," << usage.allocations << "\n";
+	}
+
+	return true;
+}
+
+void MemoryStats::logSummary() const
+{
+	for (size_t i = 0; i < m_heaps.size(); i++)
+	{
+		const HeapUsage& heap = m_heaps[i];
+		Log::info("heap {}{}: {:.1f} of {:.1f} MB budget used, {:.1f} MB in {} blocks, {:.1f} MB free inside blocks", i,
+			heap.deviceLocal ? " (device local)" : "", heap.usage / megabyte, heap.budget / megabyte, heap.blockBytes / megabyte,
+			heap.blockCount, (heap.blockBytes - heap.allocationBytes) / megabyte);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (size_t i = 0; i < m_categories.size(); i++)
+	{
+		const CategoryUsage& usage = m_categories[i];
+		if (usage.peakBytes == 0)
+			continue;
+
+		Log::info("{}: {:.1f} MB in {} allocations, peak {:.1f} MB", getName(static_cast<MemoryCategory>(i)), usage.bytes / megabyte,
+			usage.allocations, usage.peakBytes / megabyte);
+	}
+}
+
+const char* getName(MemoryCategory category)
+{
+	switch (category)
+	{
+	case MemoryCategory::eTexture: return "texture";
+	case MemoryCategory::eGeometry: return "geometry";
+	case MemoryCategory::eUniform: return "uniform";
+	case MemoryCategory::eAttachment: return "attachment";
+	case MemoryCategory::eStaging: return "staging";
+	case MemoryCategory::eOther: return "other";
+	default: return "unknown";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../utils/Singleton.h"
+
+class Device;
+
+/// what an allocation is used for, memory is accounted per category
+enum class MemoryCategory
+{
+	eTexture,
+	eGeometry,
+	/// uniform and storage buffers read by shaders
+	eUniform,
+	/// depth buffers and other render targets
+	eAttachment,
+	eStaging,
+	eOther,
+	eCount,
+};
+
+const char* getName(MemoryCategory category);
+
+struct CategoryUsage
+{
+	uint64_t bytes = 0;
+	uint64_t peakBytes = 0;
+	uint32_t allocations = 0;
+};
+
+/// one memory heap as seen by vma and, with VK_EXT_memory_budget, by the driver
+struct HeapUsage
+{
+	uint64_t size = 0;
+	bool deviceLocal = false;
+	/// how much the process can use before allocations fail or memory is evicted
+	uint64_t budget = 0;
+	/// usage of the whole process, including memory not allocated through vma
+	uint64_t usage = 0;
+	/// bytes of the vk::DeviceMemory blocks vma allocated
+	uint64_t blockBytes = 0;
+	/// bytes of the blocks handed out to resources, the difference to blockBytes is free space inside blocks
+	uint64_t allocationBytes = 0;
+	uint32_t blockCount = 0;
+	uint32_t allocationCount = 0;
+	/// usage exceeded the budget at the last update
+	bool overBudget = false;
+};
+
+/// accounts every Buffer and Image allocation by category and queries the heap budgets once per frame.
+/// allocations that are still tracked when the allocator is destroyed are reported as leaks
+class MemoryStats : public Singleton<MemoryStats>
+{
+public:
+	/// called by the device once its allocator exists
+	void create(Device& device);
+	/// reports every allocation that is still tracked as a leak, call before the allocator is destroyed
+	void destroy();
+
+	/// thread safe. the name is given to the vma allocation and, with debug utils, to the vulkan object
+	void track(VmaAllocation allocation, MemoryCategory category, const std::string& name, vk::ObjectType type, uint64_t object);
+	void untrack(VmaAllocation allocation);
+
+	/// call once per frame after the frame's fence was waited on
+	void update();
+
+	const std::vector<HeapUsage>& getHeaps() const { return m_heaps; }
+	CategoryUsage getCategoryUsage(MemoryCategory category) const;
+	uint32_t getFrame() const { return m_frame; }
+
+	/// heaps, categories and every live allocation
+	bool writeJson(const std::string& path) const;
+	/// appends one row per heap and category, so repeated calls build a time series of a long run
+	bool writeCsv(const std::string& path) const;
+	void logSummary() const;
+private:
+	MemoryStats() = default;
+
+	struct Entry
+	{
+		MemoryCategory category;
+		uint64_t size;
+		std::string name;
+	};
+private:
+	Device* m_device = nullptr;
+	mutable std::mutex m_mutex;
+	std::unordered_map<VmaAllocation, Entry> m_allocations;
+	std::array<CategoryUsage, static_cast<size_t>(MemoryCategory::eCount)> m_categories;
+	std::vector<HeapUsage> m_heaps;
+	uint32_t m_frame = 0;
+
+	friend class Singleton<MemoryStats>;
+};
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "Image.h"
 
+#include <algorithm>
+
 #include "../utils/Log.h"
 #include "../utils/Utils.h"
 #include "../Renderer.h"
@@ -8,13 +10,13 @@ Image::~Image()
 {
 }
 
-void Image::create(uint32_t width, uint32_t height, vk::Format format, vk::Flags<vk::ImageUsageFlagBits> usage)
+void Image::create(uint32_t width, uint32_t height, vk::Format format, vk::Flags<vk::ImageUsageFlagBits> usage, uint32_t mipLevels)
 {
 	VkImageCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	createInfo.imageType = VK_IMAGE_TYPE_2D;
 	createInfo.extent = VkExtent3D{ width, height, 1 };
-	createInfo.mipLevels = 1;
+	createInfo.mipLevels = mipLevels;
 	createInfo.arrayLayers = 1;
 	createInfo.format = static_cast<VkFormat>(format);
 	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -31,10 +33,18 @@ void Image::create(uint32_t width, uint32_t height, vk::Format format, vk::Flags
 	if (vmaCreateImage(Renderer::getAllocator(), &createInfo, &allocInfo, &vmaHandle, &m_allocation, nullptr) != VK_SUCCESS)
 		Log::error("error in Image::create(): failed to create image");
 
+	auto attachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment;
+	m_category = (usage & attachmentUsage) ? MemoryCategory::eAttachment : MemoryCategory::eTexture;
+	MemoryStats::get().track(m_allocation, m_category, m_name, vk::ObjectType::eImage, reinterpret_cast<uint64_t>(vmaHandle));
+
 	m_handle = vmaHandle;
+	m_width = width;
+	m_height = height;
+	m_mipLevels = mipLevels;
+	m_mipLayouts.assign(mipLevels, vk::ImageLayout::eUndefined);
 }
 
-void Image::createView(vk::Format format, vk::ImageAspectFlagBits aspectFlags)
+void Image::createView(vk::Format format, vk::ImageAspectFlagBits aspectFlags, vk::ComponentMapping components)
 {
 	if (!m_handle)
 	{
@@ -46,13 +56,10 @@ void Image::createView(vk::Format format, vk::ImageAspectFlagBits aspectFlags)
 	createInfo.image = m_handle;
 	createInfo.viewType = vk::ImageViewType::e2D;
 	createInfo.format = format;
-	createInfo.components.r = vk::ComponentSwizzle::eIdentity;
-	createInfo.components.g = vk::ComponentSwizzle::eIdentity;
-	createInfo.components.b = vk::ComponentSwizzle::eIdentity;
-	createInfo.components.a = vk::ComponentSwizzle::eIdentity;
+	createInfo.components = components;
 	createInfo.subresourceRange.aspectMask = aspectFlags;
 	createInfo.subresourceRange.baseMipLevel = 0;
-	createInfo.subresourceRange.levelCount = 1;
+	createInfo.subresourceRange.levelCount = m_mipLevels;
 	createInfo.subresourceRange.baseArrayLayer = 0;
 	createInfo.subresourceRange.layerCount = 1;
 
@@ -62,6 +69,16 @@ void Image::createView(vk::Format format, vk::ImageAspectFlagBits aspectFlags)
 void Image::transitionLayout(vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
 {
 	auto cmd = Renderer::beginSingleTimeCommand();
+	transitionLayout(cmd, format, oldLayout, newLayout);
+	Renderer::endSingleTimeCommand(cmd);
+}
+
+void Image::transitionLayout(vk::CommandBuffer cmd, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+	uint32_t baseMip, uint32_t mipCount)
+{
+	if (mipCount == 0)
+		mipCount = m_mipLevels - baseMip;
+
 	vk::ImageMemoryBarrier barrier;
 	barrier.oldLayout = oldLayout;
 	barrier.newLayout = newLayout;
@@ -69,8 +86,8 @@ void Image::transitionLayout(vk::Format format, vk::ImageLayout oldLayout, vk::I
 	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	barrier.image = m_handle;
 	barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseMipLevel = baseMip;
+	barrier.subresourceRange.levelCount = mipCount;
 	barrier.subresourceRange.baseArrayLayer = 0;
 	barrier.subresourceRange.layerCount = 1;
 
@@ -101,6 +118,22 @@ void Image::transitionLayout(vk::Format format, vk::ImageLayout oldLayout, vk::I
 		sourceStage = vk::PipelineStageFlagBits::eTransfer;
 		destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
 	}
+	else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eTransferSrcOptimal)
+	{
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+		sourceStage = vk::PipelineStageFlagBits::eTransfer;
+		destinationStage = vk::PipelineStageFlagBits::eTransfer;
+	}
+	else if (oldLayout == vk::ImageLayout::eTransferSrcOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal)
+	{
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+		sourceStage = vk::PipelineStageFlagBits::eTransfer;
+		destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
+	}
 	else if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal)
 	{
 		barrier.srcAccessMask = vk::AccessFlagBits::eNone;
@@ -127,8 +160,41 @@ void Image::transitionLayout(vk::Format format, vk::ImageLayout oldLayout, vk::I
 	vk::DependencyFlagBits dependencyFlags = static_cast<vk::DependencyFlagBits>(0);
 	cmd.pipelineBarrier(sourceStage, destinationStage, dependencyFlags, {}, {}, barriers);
 
-	Renderer::endSingleTimeCommand(cmd);
-	m_currentLayout = newLayout;
+	for (uint32_t mip = baseMip; mip < baseMip + mipCount; mip++)
+		m_mipLayouts[mip] = newLayout;
+}
+
+void Image::generateMips(vk::CommandBuffer cmd, vk::Format format)
+{
+	int32_t width = static_cast<int32_t>(m_width);
+	int32_t height = static_cast<int32_t>(m_height);
+
+	//each mip is read from the one above it, which is moved to transfer src first
+	for (uint32_t mip = 1; mip < m_mipLevels; mip++)
+	{
+		transitionLayout(cmd, format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal, mip - 1, 1);
+
+		vk::ImageBlit blit;
+		blit.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mip - 1, 0, 1);
+		blit.srcOffsets[1] = vk::Offset3D(width, height, 1);
+
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		blit.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mip, 0, 1);
+		blit.dstOffsets[1] = vk::Offset3D(width, height, 1);
+
+		cmd.blitImage(m_handle, vk::ImageLayout::eTransferSrcOptimal, m_handle, vk::ImageLayout::eTransferDstOptimal, blit, vk::Filter::eLinear);
+		transitionLayout(cmd, format, vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, mip - 1, 1);
+	}
+
+	transitionLayout(cmd, format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, m_mipLevels - 1, 1);
+}
+
+bool Image::supportsBlitMips(vk::Format format)
+{
+	auto features = Renderer::getGpu().getFormatProperties(format).optimalTilingFeatures;
+	auto required = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+	return (features & required) == required;
 }
 
 void Image::destroy()
@@ -136,7 +202,10 @@ void Image::destroy()
 	Renderer::getDeviceHandle().destroyImageView(m_view);
 
 	if (m_allocation != VK_NULL_HANDLE)
+	{
+		MemoryStats::get().untrack(m_allocation);
 		vmaDestroyImage(Renderer::getAllocator(), m_handle, m_allocation);
+	}
 	else
 		Renderer::getDeviceHandle().destroyImage(m_handle);
 }
@@ -3,6 +3,11 @@
 #include <vulkan/vulkan.hpp>
 #include <vma/vk_mem_alloc.h>
 
+#include <string>
+#include <vector>
+
+#include "../debug/MemoryStats.h"
+
 //only image supported is 2d image
 class Image
 {
@@ -12,15 +17,33 @@ public:
 
 	vk::Image getHandle() const { return m_handle; }
 	vk::ImageView getView() const { return m_view; }
-	vk::ImageLayout getCurrentLayout() const { return m_currentLayout; }
+	/// derived from the usage, attachments are everything that can be rendered to
+	MemoryCategory getCategory() const { return m_category; }
+	/// layout of the first mip
+	vk::ImageLayout getCurrentLayout() const { return m_mipLayouts[0]; }
+	vk::ImageLayout getLayout(uint32_t mip) const { return m_mipLayouts[mip]; }
+	uint32_t getMipLevels() const { return m_mipLevels; }
 
 	void setHandle(vk::Image handle) { m_handle = handle; }
 	void setView(vk::ImageView view) { m_view = view; }
+	/// for layout changes recorded outside of transitionLayout, applies to every mip
+	void setCurrentLayout(vk::ImageLayout layout) { m_mipLayouts.assign(m_mipLevels, layout); }
+	/// debug name used by memory accounting, call before create()
+	void setName(const std::string& name) { m_name = name; }
 
-	void create(uint32_t width, uint32_t height, vk::Format format, vk::Flags<vk::ImageUsageFlagBits> usage);
-	void createView(vk::Format format, vk::ImageAspectFlagBits aspectFlags);
+	void create(uint32_t width, uint32_t height, vk::Format format, vk::Flags<vk::ImageUsageFlagBits> usage, uint32_t mipLevels = 1);
+	void createView(vk::Format format, vk::ImageAspectFlagBits aspectFlags, vk::ComponentMapping components = {});
 
 	void transitionLayout(vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
+	/// records the barrier into cmd instead of submitting it, mipCount of 0 covers every mip from baseMip on
+	void transitionLayout(vk::CommandBuffer cmd, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+		uint32_t baseMip = 0, uint32_t mipCount = 0);
+
+	/// fills mips 1..n with linear blits from mip 0, needs a graphics queue and every mip in transfer dst layout.
+	/// leaves the whole image in shader read only layout
+	void generateMips(vk::CommandBuffer cmd, vk::Format format);
+	/// whether generateMips can be used with the format
+	static bool supportsBlitMips(vk::Format format);
 
 	void destroy();
 
@@ -30,9 +53,12 @@ private:
 	vk::Device m_device;
 	vk::Image m_handle;
 	vk::ImageView m_view;
-	VmaAllocation m_allocation;
-	vk::ImageLayout m_currentLayout = vk::ImageLayout::eUndefined;
+	VmaAllocation m_allocation = VK_NULL_HANDLE;
+	MemoryCategory m_category = MemoryCategory::eTexture;
+	std::string m_name;
+	std::vector<vk::ImageLayout> m_mipLayouts = { vk::ImageLayout::eUndefined };
 
-	uint32_t m_width;
-	uint32_t m_height;
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+	uint32_t m_mipLevels = 1;
 };
\ No newline at end of file
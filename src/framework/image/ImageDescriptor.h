@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../rendering/Descriptor.h"
+
+/// an image view written to a descriptor without a Texture, e.g. storage images or views of single mips
+class ImageDescriptor : public Descriptor
+{
+public:
+	ImageDescriptor(vk::ImageView view, vk::ImageLayout layout, vk::DescriptorType type, vk::Sampler sampler = {})
+		:m_view(view), m_layout(layout), m_type(type), m_sampler(sampler) {}
+
+	std::optional<vk::DescriptorBufferInfo> getDescriptorBufferInfo() const
+	{
+		return {};
+	}
+
+	std::optional<vk::DescriptorImageInfo> getDescriptorImageInfo() const
+	{
+		return vk::DescriptorImageInfo(m_sampler, m_view, m_layout);
+	}
+
+	vk::DescriptorType getDescriptorType() const
+	{
+		return m_type;
+	}
+private:
+	vk::ImageView m_view;
+	vk::ImageLayout m_layout;
+	vk::DescriptorType m_type;
+	vk::Sampler m_sampler;
+};
@@ -0,0 +1,87 @@
+#include "Ktx2.h"
+
+#include <cstring>
+
+#include "../utils/Log.h"
+
+bool Ktx2File::parse(const uint8_t* data, size_t size)
+{
+	if (size < sizeof(ktx2::Header))
+	{
+		Log::error("error in Ktx2File::parse(): file is too small");
+		return false;
+	}
+
+	memcpy(&m_header, data, sizeof(ktx2::Header));
+	if (memcmp(m_header.identifier, ktx2::identifier, sizeof(ktx2::identifier)) != 0)
+	{
+		Log::error("error in Ktx2File::parse(): not a ktx2 file");
+		return false;
+	}
+
+	if (m_header.supercompressionScheme != 0 || m_header.pixelDepth > 1 || m_header.layerCount > 1 || m_header.faceCount != 1)
+	{
+		Log::error("error in Ktx2File::parse(): only uncompressed single 2d images are supported");
+		return false;
+	}
+
+	//a level count of 0 asks the loader to generate mips, which isn't supported for block compressed data
+	uint32_t levelCount = m_header.levelCount;
+	if (levelCount == 0 || sizeof(ktx2::Header) + levelCount * sizeof(ktx2::LevelIndex) > size)
+	{
+		Log::error("error in Ktx2File::parse(): invalid level count {}", levelCount);
+		return false;
+	}
+
+	m_levels.resize(levelCount);
+	memcpy(m_levels.data(), data + sizeof(ktx2::Header), levelCount * sizeof(ktx2::LevelIndex));
+	for (auto& level : m_levels)
+	{
+		if (level.byteOffset + level.byteLength > size)
+		{
+			Log::error("error in Ktx2File::parse(): level data out of bounds");
+			return false;
+		}
+	}
+
+	if (static_cast<uint64_t>(m_header.kvdByteOffset) + m_header.kvdByteLength > size)
+	{
+		Log::error("error in Ktx2File::parse(): key/value data out of bounds");
+		return false;
+	}
+
+	m_data = data;
+	m_size = size;
+	return true;
+}
+
+std::string Ktx2File::getValue(const std::string& key) const
+{
+	const uint8_t* it = m_data + m_header.kvdByteOffset;
+	const uint8_t* end = it + m_header.kvdByteLength;
+
+	//each entry is a length, a nul terminated key, the value and padding to 4 bytes
+	while (it + sizeof(uint32_t) <= end)
+	{
+		uint32_t length;
+		memcpy(&length, it, sizeof(uint32_t));
+		it += sizeof(uint32_t);
+		if (length > static_cast<size_t>(end - it))
+			break;
+
+		const char* entry = reinterpret_cast<const char*>(it);
+		size_t keyLength = strnlen(entry, length);
+		if (keyLength < length && key.compare(0, std::string::npos, entry, keyLength) == 0)
+		{
+			std::string value(entry + keyLength + 1, length - keyLength - 1);
+			//values are usually nul terminated strings
+			if (!value.empty() && value.back() == '\0')
+				value.pop_back();
+			return value;
+		}
+
+		it += (length + 3) & ~3u;
+	}
+
+	return {};
+}
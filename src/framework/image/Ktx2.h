@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//minimal ktx2 container support, single 2d image with a mip chain and no supercompression
+namespace ktx2
+{
+	constexpr uint8_t identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	struct Header
+	{
+		uint8_t identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+	static_assert(sizeof(Header) == 80, "ktx2 header has to match the file layout");
+
+	struct LevelIndex
+	{
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+}
+
+/// view over a ktx2 file in memory, the memory has to outlive it
+class Ktx2File
+{
+public:
+	bool parse(const uint8_t* data, size_t size);
+
+	uint32_t getVkFormat() const { return m_header.vkFormat; }
+	uint32_t getWidth() const { return m_header.pixelWidth; }
+	uint32_t getHeight() const { return m_header.pixelHeight; }
+	uint32_t getLevelCount() const { return static_cast<uint32_t>(m_levels.size()); }
+
+	const uint8_t* getLevelData(uint32_t level) const { return m_data + m_levels[level].byteOffset; }
+	size_t getLevelSize(uint32_t level) const { return static_cast<size_t>(m_levels[level].byteLength); }
+
+	/// value of a key/value entry, empty if the key isn't present
+	std::string getValue(const std::string& key) const;
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+	ktx2::Header m_header = {};
+	std::vector<ktx2::LevelIndex> m_levels;
+};
@@ -0,0 +1,163 @@
+#include "MipChain.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_CHAIN_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	struct SrgbTables
+	{
+		std::array<float, 256> toLinear;
+		//indexed by linear value * 4095
+		std::array<uint8_t, 4096> toSrgb;
+
+		SrgbTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;
+				toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (int i = 0; i < 4096; i++)
+			{
+				float l = i / 4095.0f;
+				float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				toSrgb[i] = static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+			}
+		}
+	};
+
+	const SrgbTables& getSrgbTables()
+	{
+		static SrgbTables tables;
+		return tables;
+	}
+
+	void downsampleRowLinear(const uint8_t* row0, const uint8_t* row1, uint32_t srcWidth, uint8_t* dst, uint32_t dstWidth)
+	{
+		uint32_t x = 0;
+
+#ifdef MIP_CHAIN_SSE2
+		//two output texels per iteration, needs both source texel pairs inside the row
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i bias = _mm_set1_epi16(2);
+		for (; x + 2 <= dstWidth && x * 2 + 4 <= srcWidth; x += 2)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+
+			//vertical sums, 16 bits per channel
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+			//horizontal sums land in the low 4 lanes
+			lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+			hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+			__m128i sum = _mm_unpacklo_epi64(lo, hi);
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, bias), 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(sum, zero));
+		}
+#endif
+
+		for (; x < dstWidth; x++)
+		{
+			uint32_t x0 = x * 2;
+			uint32_t x1 = std::min(x0 + 1, srcWidth - 1);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				uint32_t sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+				dst[x * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+
+	void downsampleRowSrgb(const uint8_t* row0, const uint8_t* row1, uint32_t srcWidth, uint8_t* dst, uint32_t dstWidth)
+	{
+		const SrgbTables& tables = getSrgbTables();
+		for (uint32_t x = 0; x < dstWidth; x++)
+		{
+			uint32_t x0 = x * 2;
+			uint32_t x1 = std::min(x0 + 1, srcWidth - 1);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				float sum = tables.toLinear[row0[x0 * 4 + c]] + tables.toLinear[row0[x1 * 4 + c]]
+					+ tables.toLinear[row1[x0 * 4 + c]] + tables.toLinear[row1[x1 * 4 + c]];
+				dst[x * 4 + c] = tables.toSrgb[static_cast<uint32_t>(sum * 0.25f * 4095.0f + 0.5f)];
+			}
+
+			//alpha is always linear
+			uint32_t alpha = row0[x0 * 4 + 3] + row0[x1 * 4 + 3] + row1[x0 * 4 + 3] + row1[x1 * 4 + 3];
+			dst[x * 4 + 3] = static_cast<uint8_t>((alpha + 2) / 4);
+		}
+	}
+}
+
+uint32_t utils::getMipLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+	uint32_t size = std::max(width, height);
+	while (size > 1)
+	{
+		size /= 2;
+		levels++;
+	}
+	return levels;
+}
+
+size_t utils::getMipChainSize(uint32_t width, uint32_t height, uint32_t levelCount)
+{
+	return getMipOffset(width, height, levelCount);
+}
+
+size_t utils::getMipOffset(uint32_t width, uint32_t height, uint32_t level)
+{
+	size_t offset = 0;
+	for (uint32_t i = 0; i < level; i++)
+	{
+		offset += static_cast<size_t>(width) * height * 4;
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+	return offset;
+}
+
+void utils::downsampleRgba8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, bool srgb)
+{
+	uint32_t dstWidth = std::max(srcWidth / 2, 1u);
+	uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+	size_t srcPitch = static_cast<size_t>(srcWidth) * 4;
+
+	for (uint32_t y = 0; y < dstHeight; y++)
+	{
+		const uint8_t* row0 = src + y * 2 * srcPitch;
+		const uint8_t* row1 = src + std::min(y * 2 + 1, srcHeight - 1) * srcPitch;
+		uint8_t* dstRow = dst + static_cast<size_t>(y) * dstWidth * 4;
+
+		if (srgb)
+			downsampleRowSrgb(row0, row1, srcWidth, dstRow, dstWidth);
+		else
+			downsampleRowLinear(row0, row1, srcWidth, dstRow, dstWidth);
+	}
+}
+
+void utils::generateMipChain(uint8_t* chain, uint32_t width, uint32_t height, uint32_t levelCount, bool srgb)
+{
+	uint8_t* src = chain;
+	for (uint32_t level = 1; level < levelCount; level++)
+	{
+		uint8_t* dst = src + static_cast<size_t>(width) * height * 4;
+		downsampleRgba8(src, width, height, dst, srgb);
+
+		src = dst;
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//cpu side mip generation for tightly packed rgba8 images
+namespace utils
+{
+	uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+	/// bytes needed for levels [0, levelCount) stored back to back
+	size_t getMipChainSize(uint32_t width, uint32_t height, uint32_t levelCount);
+	size_t getMipOffset(uint32_t width, uint32_t height, uint32_t level);
+
+	/// 2x2 box filter from src into dst, odd edges repeat the last texel.
+	/// srgb data is filtered in linear space
+	void downsampleRgba8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, bool srgb);
+	/// fills levels 1..levelCount-1 of a chain whose level 0 is already written
+	void generateMipChain(uint8_t* chain, uint32_t width, uint32_t height, uint32_t levelCount, bool srgb);
+}
@@ -7,8 +7,11 @@ Sampler::~Sampler()
     destroy();
 }
 
-void Sampler::create(vk::Filter filter, vk::SamplerAddressMode addressMode)
+void Sampler::create(vk::Filter filter, vk::SamplerAddressMode addressMode, float maxLod)
 {
+    m_filter = filter;
+    m_addressMode = addressMode;
+
     vk::SamplerCreateInfo samplerInfo;
     samplerInfo.magFilter = filter;
     samplerInfo.minFilter = filter;
@@ -24,11 +27,17 @@ void Sampler::create(vk::Filter filter, vk::SamplerAddressMode addressMode)
     samplerInfo.mipmapMode = vk::SamplerMipmapMode::eLinear;
     samplerInfo.mipLodBias = 0.0f;
     samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = 0.0f;
+    samplerInfo.maxLod = maxLod;
 
     handle = Renderer::getDeviceHandle().createSampler(samplerInfo);
 }
 
+void Sampler::setMaxLod(float maxLod)
+{
+    destroy();
+    create(m_filter, m_addressMode, maxLod);
+}
+
 void Sampler::destroy()
 {
     if (handle)
@@ -6,9 +6,14 @@ class Sampler
 {
 public:
 	~Sampler();
-	void create(vk::Filter filter, vk::SamplerAddressMode addressMode);
+	void create(vk::Filter filter, vk::SamplerAddressMode addressMode, float maxLod = VK_LOD_CLAMP_NONE);
 	void destroy();
 
+	/// recreates the sampler, descriptors using it have to be written again
+	void setMaxLod(float maxLod);
+
 	vk::Sampler handle;
 private:
+	vk::Filter m_filter = vk::Filter::eNearest;
+	vk::SamplerAddressMode m_addressMode = vk::SamplerAddressMode::eRepeat;
 };
\ No newline at end of file
@@ -2,50 +2,184 @@
 
 #include "../utils/Log.h"
 #include "../Renderer.h"
+#include "../utils/Timer.h"
+#include "../utils/MappedFile.h"
+#include "MipChain.h"
+#include "Ktx2.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include <algorithm>
 
-void Texture::create(const std::string& path, vk::Format format)
+TextureData Texture::decode(const std::string& path, MipMode mipMode, bool srgb)
 {
+    //a ktx2 file that fails to parse falls through to stb, which can't load it either and stages the error pixel
+    if (path.size() > 5 && path.compare(path.size() - 5, 5, ".ktx2") == 0)
+    {
+        TextureData ktx2 = decodeKtx2(path);
+        if (ktx2.staging.isValid())
+            return ktx2;
+    }
+
+    Timer timer;
+    TextureData data;
+
     //load data from disk
-    stbi_uc* pixels = stbi_load(path.c_str(), &m_width, &m_height, &m_channels, STBI_rgb_alpha);
-    vk::DeviceSize imageSize = m_width * m_height * 4;
+    int channels;
+    stbi_uc* pixels = stbi_load(path.c_str(), &data.width, &data.height, &channels, STBI_rgb_alpha);
 
+    //fall back to a single magenta pixel so a missing file doesn't take the whole model down
+    static stbi_uc errorPixel[4] = { 255, 0, 255, 255 };
     if (!pixels)
-        Log::error("error in Texture::create(): failed to load texture file: {}", path);
-
-    VkBuffer stagingBuffer;
-    VmaAllocation bufferAllocation;
+    {
+        Log::error("error in Texture::decode(): failed to load texture file: {}", path);
+        data.width = 1;
+        data.height = 1;
+    }
 
-    //allocate staging buffer
-    VkBufferCreateInfo bufferInfo = {};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = imageSize;
-    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    uint32_t width = static_cast<uint32_t>(data.width);
+    uint32_t height = static_cast<uint32_t>(data.height);
+    data.mipMode = mipMode;
+    data.mipLevels = mipMode == MipMode::eNone ? 1 : utils::getMipLevelCount(width, height);
 
-    VmaAllocationCreateInfo bufferAllocInfo = {};
-    bufferAllocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    //the cpu path stores the whole chain in staging, the blit path only mip 0
+    vk::DeviceSize imageSize = static_cast<vk::DeviceSize>(width) * height * 4;
+    vk::DeviceSize stagingSize = mipMode == MipMode::eCpu ? utils::getMipChainSize(width, height, data.mipLevels) : imageSize;
 
-    if (vmaCreateBuffer(Renderer::getAllocator(), &bufferInfo, &bufferAllocInfo, &stagingBuffer, &bufferAllocation, nullptr) != VK_SUCCESS)
-        Log::error("error in Texture::create(): failed to create staging buffer");
+    data.staging = Renderer::getUploadContext().allocateStaging(stagingSize);
+    if (data.staging.isValid())
+    {
+        memcpy(data.staging.data, pixels ? pixels : errorPixel, imageSize);
+        if (mipMode == MipMode::eCpu)
+            utils::generateMipChain(static_cast<uint8_t*>(data.staging.data), width, height, data.mipLevels, srgb);
+    }
 
-    //map memory
-    void* data;
-    vmaMapMemory(Renderer::getAllocator(), bufferAllocation, &data);
-    memcpy(data, pixels, imageSize);
-    vmaUnmapMemory(Renderer::getAllocator(), bufferAllocation);
+    uint32_t stagedLevels = mipMode == MipMode::eCpu ? data.mipLevels : 1;
+    for (uint32_t mip = 0; mip < stagedLevels; mip++)
+        data.mipOffsets.push_back(utils::getMipOffset(width, height, mip));
 
     stbi_image_free(pixels);
 
+    data.decodeTime = timer.elapsedMs();
+    return data;
+}
+
+TextureData Texture::decodeKtx2(const std::string& path)
+{
+    Timer timer;
+    TextureData data;
+
+    MappedFile file;
+    Ktx2File ktx;
+    if (!file.open(path) || !ktx.parse(file.getData(), file.getSize()))
+    {
+        Log::error("error in Texture::decodeKtx2(): failed to load texture file: {}", path);
+        return data;
+    }
+
+    data.width = static_cast<int>(ktx.getWidth());
+    data.height = static_cast<int>(ktx.getHeight());
+    data.format = static_cast<vk::Format>(ktx.getVkFormat());
+    data.mipLevels = ktx.getLevelCount();
+
+    //block compressed copies need offsets aligned to the block size, 16 covers every bc format
+    vk::DeviceSize stagingSize = 0;
+    for (uint32_t level = 0; level < data.mipLevels; level++)
+    {
+        data.mipOffsets.push_back(stagingSize);
+        stagingSize += (ktx.getLevelSize(level) + 15) & ~vk::DeviceSize(15);
+    }
+
+    data.staging = Renderer::getUploadContext().allocateStaging(stagingSize);
+    if (data.staging.isValid())
+    {
+        uint8_t* staging = static_cast<uint8_t*>(data.staging.data);
+        for (uint32_t level = 0; level < data.mipLevels; level++)
+            memcpy(staging + data.mipOffsets[level], ktx.getLevelData(level), ktx.getLevelSize(level));
+    }
+
+    //KTXswizzle holds one of rgba01 per component
+    std::string swizzle = ktx.getValue("KTXswizzle");
+    if (swizzle.size() == 4)
+    {
+        auto toComponent = [](char c)
+        {
+            switch (c)
+            {
+            case 'r': return vk::ComponentSwizzle::eR;
+            case 'g': return vk::ComponentSwizzle::eG;
+            case 'b': return vk::ComponentSwizzle::eB;
+            case 'a': return vk::ComponentSwizzle::eA;
+            case '0': return vk::ComponentSwizzle::eZero;
+            case '1': return vk::ComponentSwizzle::eOne;
+            default: return vk::ComponentSwizzle::eIdentity;
+            }
+        };
+        data.swizzle = vk::ComponentMapping(toComponent(swizzle[0]), toComponent(swizzle[1]), toComponent(swizzle[2]), toComponent(swizzle[3]));
+    }
+
+    data.decodeTime = timer.elapsedMs();
+    return data;
+}
+
+MipMode Texture::getMipMode(vk::Format format)
+{
+    return Image::supportsBlitMips(format) ? MipMode::eGpuBlit : MipMode::eCpu;
+}
+
+void Texture::create(const std::string& path, vk::Format format)
+{
+    create(decode(path, getMipMode(format), format == vk::Format::eR8G8B8A8Srgb), format);
+    Renderer::getUploadContext().flush();
+}
+
+void Texture::create(const TextureData& data, vk::Format format)
+{
+    if (!data.staging.isValid())
+    {
+        Log::error("error in Texture::create(): no staging memory to create the texture from");
+        return;
+    }
+
+    m_width = data.width;
+    m_height = data.height;
+    m_channels = 4;
+    if (data.format != vk::Format::eUndefined)
+        format = data.format;
+
     //create image
-    m_image.create(m_width, m_height, format, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled);
+    bool blitMips = data.mipMode == MipMode::eGpuBlit && data.mipLevels > data.mipOffsets.size();
+    auto usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+    if (blitMips)
+        usage |= vk::ImageUsageFlagBits::eTransferSrc;
+    m_image.create(m_width, m_height, format, usage, data.mipLevels);
+
+    auto& upload = Renderer::getUploadContext();
+    auto cmd = upload.getCommandBuffer();
 
-    m_image.transitionLayout(format, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-    copyBufferToImage(stagingBuffer);
+    m_image.transitionLayout(cmd, format, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+    copyBufferToImage(cmd, data.staging.buffer, data.staging.offset, data.mipOffsets);
+
+    //the graphics queue acquires the image and finishes the transition in the first frame after the batch completes
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, data.mipLevels, 0, 1);
+    if (blitMips)
+    {
+        //transfer queues can't blit, so the chain is generated right after the acquire
+        upload.releaseImage(m_image.getHandle(), range, vk::ImageLayout::eTransferDstOptimal,
+            vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite);
 
-    m_image.transitionLayout(format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
-    m_image.createView(format, vk::ImageAspectFlagBits::eColor);
+        Image image = m_image;
+        upload.recordAfterAcquire([image, format](vk::CommandBuffer cmd) mutable { image.generateMips(cmd, format); });
+    }
+    else
+    {
+        upload.releaseImage(m_image.getHandle(), range, vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead);
+    }
+    m_image.setCurrentLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    m_uploadTicket = upload.getRecordingTicket();
+
+    m_image.createView(format, vk::ImageAspectFlagBits::eColor, data.swizzle);
 
     //create sampler
     if (!m_hasSampler)
@@ -55,7 +189,7 @@ void Texture::create(const std::string& path, vk::Format format)
         m_hasSampler = true;
     }
 
-    vmaDestroyBuffer(Renderer::getAllocator(), stagingBuffer, bufferAllocation);
+    upload.releaseStaging(data.staging);
 }
 
 void Texture::create(const Image& image)
@@ -69,31 +203,42 @@ void Texture::create(const Image& image)
     }
 }
 
+bool Texture::isAvailable() const
+{
+    return m_image.getView() && Renderer::getUploadContext().isAvailable(m_uploadTicket);
+}
+
 void Texture::destroy()
 {
+    //an upload that was never acquired must not record a barrier on the destroyed image
+    Renderer::getUploadContext().discardAcquires(m_image.getHandle());
     m_image.destroy();
 }
 
-void Texture::copyBufferToImage(VkBuffer buffer)
+void Texture::copyBufferToImage(vk::CommandBuffer cmd, vk::Buffer buffer, vk::DeviceSize offset, const std::vector<vk::DeviceSize>& mipOffsets)
 {
-    vk::BufferImageCopy region;
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
+    uint32_t width = static_cast<uint32_t>(m_width);
+    uint32_t height = static_cast<uint32_t>(m_height);
 
-    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
+    std::vector<vk::BufferImageCopy> regions;
+    for (uint32_t mip = 0; mip < mipOffsets.size(); mip++)
+    {
+        vk::BufferImageCopy region;
+        region.bufferOffset = offset + mipOffsets[mip];
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
 
-    region.imageOffset = vk::Offset3D{ 0, 0, 0 };
-    region.imageExtent = vk::Extent3D{ static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height), 1 };
+        region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+        region.imageSubresource.mipLevel = mip;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
 
-    std::vector<vk::BufferImageCopy> regions = { region };
+        region.imageOffset = vk::Offset3D{ 0, 0, 0 };
+        region.imageExtent = vk::Extent3D{ std::max(width >> mip, 1u), std::max(height >> mip, 1u), 1 };
+        regions.push_back(region);
+    }
 
-    auto cmd = Renderer::beginSingleTimeCommand();
     cmd.copyBufferToImage(buffer, m_image.getHandle(), vk::ImageLayout::eTransferDstOptimal, regions);
-    Renderer::endSingleTimeCommand(cmd);
 }
 
 std::optional<vk::DescriptorBufferInfo> Texture::getDescriptorBufferInfo() const
@@ -5,6 +5,32 @@
 
 #include "Image.h"
 #include "Sampler.h"
+#include "../UploadContext.h"
+
+enum class MipMode
+{
+	eNone,
+	//mip 0 is uploaded and the rest of the chain is blitted on the graphics queue
+	eGpuBlit,
+	//the whole chain is filtered on the decoding thread, for formats that can't be blitted
+	eCpu
+};
+
+//image decoded into upload staging memory, ready to be copied into a Texture
+struct TextureData
+{
+	StagingAllocation staging;
+	int width = 0;
+	int height = 0;
+	MipMode mipMode = MipMode::eNone;
+	uint32_t mipLevels = 1;
+	/// offsets of the mips stored in staging, relative to the staging offset
+	std::vector<vk::DeviceSize> mipOffsets;
+	/// set when the file decides the format, overrides the format passed to Texture::create
+	vk::Format format = vk::Format::eUndefined;
+	vk::ComponentMapping swizzle;
+	double decodeTime = 0.0;
+};
 
 class Texture : public Descriptor
 {
@@ -12,20 +38,34 @@ public:
 	Texture() = default;
 	~Texture() = default;
 
+	/// decodes the file into upload staging memory, safe to call from worker threads.
+	/// .ktx2 files are copied as they are, with their own format and mips
+	static TextureData decode(const std::string& path, MipMode mipMode = MipMode::eNone, bool srgb = false);
+	static MipMode getMipMode(vk::Format format);
+
+	/// uploads and waits for the upload to finish
 	void create(const std::string& path, vk::Format format);
+	/// records the upload into the renderer's UploadContext and releases the staging memory,
+	/// the texture can be sampled once isAvailable() returns true
+	void create(const TextureData& data, vk::Format format);
 	void create(const Image& image);
 	void destroy();
 
 	void setSampler(const std::shared_ptr<Sampler>& sampler) { m_sampler = sampler; m_hasSampler = true; }
 	Sampler& getSampler() { return *m_sampler; }
 	Image& getImage() { return m_image; }
+	/// debug name of the image, call before create()
+	void setName(const std::string& name) { m_image.setName(name); }
+	/// true once the upload has completed and the graphics queue owns the image
+	bool isAvailable() const;
 
 
 	std::optional<vk::DescriptorBufferInfo> getDescriptorBufferInfo() const;
 	std::optional<vk::DescriptorImageInfo> getDescriptorImageInfo() const;
 	vk::DescriptorType getDescriptorType() const { return vk::DescriptorType::eCombinedImageSampler; }
 private:
-	void copyBufferToImage(VkBuffer buffer);
+	static TextureData decodeKtx2(const std::string& path);
+	void copyBufferToImage(vk::CommandBuffer cmd, vk::Buffer buffer, vk::DeviceSize offset, const std::vector<vk::DeviceSize>& mipOffsets);
 private:
 	std::shared_ptr<Sampler> m_sampler;
 	Image m_image;
@@ -34,4 +74,5 @@ private:
 	int m_height;
 	int m_channels;
 	bool m_hasSampler = false;
+	UploadTicket m_uploadTicket = 0;
 };
\ No newline at end of file
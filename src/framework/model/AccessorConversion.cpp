@@ -0,0 +1,165 @@
+#include "AccessorConversion.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ACCESSOR_CONVERSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+#ifdef ACCESSOR_CONVERSION_SSE2
+	//the last element of a vec3 is copied scalar, a 16 byte load would read past the end of the accessor
+	__m128 loadFloats(const float* source, uint32_t components)
+	{
+		if (components == 2)
+			return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(source)));
+		return _mm_loadu_ps(source);
+	}
+
+	void storeFloats(float* destination, __m128 value, uint32_t components)
+	{
+		if (components == 4)
+		{
+			_mm_storeu_ps(destination, value);
+			return;
+		}
+
+		_mm_storel_pi(reinterpret_cast<__m64*>(destination), value);
+		if (components == 3)
+			_mm_store_ss(destination + 2, _mm_movehl_ps(value, value));
+	}
+#endif
+
+	void copyScalar(const uint8_t* source, uint32_t components, uint8_t* destination)
+	{
+		memcpy(destination, source, components * sizeof(float));
+	}
+
+	void normalizeScalar(const uint8_t* source, uint8_t* destination)
+	{
+		float v[3];
+		memcpy(v, source, sizeof(v));
+		float lengthSquared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+		float scale = lengthSquared > 1e-24f ? 1.0f / std::sqrt(lengthSquared) : 0.0f;
+		for (float& c : v)
+			c *= scale;
+		memcpy(destination, v, sizeof(v));
+	}
+}
+
+void utils::widenIndices(const uint8_t* source, uint32_t indexSize, size_t count, uint32_t* destination)
+{
+	if (indexSize == 4)
+	{
+		memcpy(destination, source, count * sizeof(uint32_t));
+		return;
+	}
+
+	size_t i = 0;
+#ifdef ACCESSOR_CONVERSION_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	if (indexSize == 2)
+	{
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_unpacklo_epi16(indices, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 4), _mm_unpackhi_epi16(indices, zero));
+		}
+	}
+	else
+	{
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			__m128i low = _mm_unpacklo_epi8(indices, zero);
+			__m128i high = _mm_unpackhi_epi8(indices, zero);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_unpacklo_epi16(low, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 4), _mm_unpackhi_epi16(low, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 8), _mm_unpacklo_epi16(high, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 12), _mm_unpackhi_epi16(high, zero));
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		if (indexSize == 2)
+		{
+			uint16_t index;
+			memcpy(&index, source + i * 2, sizeof(index));
+			destination[i] = index;
+		}
+		else
+		{
+			destination[i] = source[i];
+		}
+	}
+}
+
+void utils::narrowIndices(const uint32_t* source, size_t count, uint16_t* destination)
+{
+	size_t i = 0;
+#ifdef ACCESSOR_CONVERSION_SSE2
+	//sse2 only has a signed saturating pack, so the range is shifted into int16 and back
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i low = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), bias32);
+		__m128i high = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4)), bias32);
+		__m128i packed = _mm_xor_si128(_mm_packs_epi32(low, high), bias16);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), packed);
+	}
+#endif
+
+	for (; i < count; i++)
+		destination[i] = static_cast<uint16_t>(source[i]);
+}
+
+void utils::copyFloats(const uint8_t* source, size_t sourceStride, uint32_t components, size_t count, uint8_t* destination, size_t destinationStride)
+{
+	size_t i = 0;
+#ifdef ACCESSOR_CONVERSION_SSE2
+	if (components >= 2)
+	{
+		size_t vectorCount = components == 3 && count > 0 ? count - 1 : count;
+		for (; i < vectorCount; i++)
+		{
+			__m128 value = loadFloats(reinterpret_cast<const float*>(source + i * sourceStride), components);
+			storeFloats(reinterpret_cast<float*>(destination + i * destinationStride), value, components);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+		copyScalar(source + i * sourceStride, components, destination + i * destinationStride);
+}
+
+void utils::copyNormalized(const uint8_t* source, size_t sourceStride, size_t count, uint8_t* destination, size_t destinationStride)
+{
+	size_t i = 0;
+#ifdef ACCESSOR_CONVERSION_SSE2
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 epsilon = _mm_set1_ps(1e-24f);
+	for (; i + 1 < count; i++)
+	{
+		__m128 value = _mm_and_ps(_mm_loadu_ps(reinterpret_cast<const float*>(source + i * sourceStride)), xyzMask);
+
+		//horizontal sum of the squares, broadcast to every lane
+		__m128 squared = _mm_mul_ps(value, value);
+		__m128 sum = _mm_add_ps(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1)));
+		sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		__m128 normalized = _mm_div_ps(value, _mm_sqrt_ps(sum));
+		normalized = _mm_and_ps(normalized, _mm_cmpgt_ps(sum, epsilon));
+		storeFloats(reinterpret_cast<float*>(destination + i * destinationStride), normalized, 3);
+	}
+#endif
+
+	for (; i < count; i++)
+		normalizeScalar(source + i * sourceStride, destination + i * destinationStride);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//conversions between gltf accessor data and the loader's arrays, sse2 with a scalar fallback
+namespace utils
+{
+	/// widens count indices of indexSize bytes (1, 2 or 4) to uint32_t
+	void widenIndices(const uint8_t* source, uint32_t indexSize, size_t count, uint32_t* destination);
+
+	/// every index has to be below 65536
+	void narrowIndices(const uint32_t* source, size_t count, uint16_t* destination);
+
+	/// copies count elements of components floats (1 to 4), both strides are in bytes.
+	/// source elements have to be 4 byte aligned, as gltf requires for float accessors
+	void copyFloats(const uint8_t* source, size_t sourceStride, uint32_t components, size_t count, uint8_t* destination, size_t destinationStride);
+
+	/// like copyFloats for 3 components, but normalizes each vector. zero vectors stay zero
+	void copyNormalized(const uint8_t* source, size_t sourceStride, size_t count, uint8_t* destination, size_t destinationStride);
+}
\ No newline at end of file
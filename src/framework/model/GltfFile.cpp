@@ -0,0 +1,199 @@
+#include "GltfFile.h"
+
+#include "../utils/Log.h"
+
+#include <json.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t glbHeaderSize = 12;
+	constexpr uint32_t glbChunkJson = 0x4E4F534A;
+	constexpr uint32_t glbChunkBin = 0x004E4942;
+
+	//tinygltf gets a one byte buffer instead of the real data
+	const char* placeholderUri = "data:application/octet-stream;base64,AA==";
+
+	uint32_t readUint32(const uint8_t* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	bool readGlbChunks(const MappedFile& file, DataView<uint8_t>& json, DataView<uint8_t>& bin)
+	{
+		const uint8_t* data = file.getData();
+		size_t size = std::min<size_t>(file.getSize(), readUint32(data + 8));
+		if (readUint32(data + 4) != 2)
+			return false;
+
+		size_t offset = glbHeaderSize;
+		while (offset + 8 <= size)
+		{
+			uint32_t chunkLength = readUint32(data + offset);
+			uint32_t chunkType = readUint32(data + offset + 4);
+			if (offset + 8 + chunkLength > size)
+				return false;
+
+			if (chunkType == glbChunkJson && json.empty())
+				json = DataView<uint8_t>(data + offset + 8, chunkLength);
+			else if (chunkType == glbChunkBin && bin.empty())
+				bin = DataView<uint8_t>(data + offset + 8, chunkLength);
+
+			//chunks are padded to 4 bytes
+			offset += 8 + ((chunkLength + 3) & ~3u);
+		}
+
+		return !json.empty();
+	}
+}
+
+bool GltfFile::load(const std::string& filename, tinygltf::Model& model)
+{
+	close();
+
+	size_t slash = filename.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		Log::error("error in GltfFile::load(): failed to open {}", filename);
+		return false;
+	}
+
+	DataView<uint8_t> json(file.getData(), file.getSize());
+	DataView<uint8_t> bin;
+	bool binary = file.getSize() >= glbHeaderSize && memcmp(file.getData(), "glTF", 4) == 0;
+	if (binary)
+	{
+		json = {};
+		if (!readGlbChunks(file, json, bin))
+		{
+			Log::error("error in GltfFile::load(): {} is not a valid glb file", filename);
+			return false;
+		}
+	}
+
+	nlohmann::json document = nlohmann::json::parse(json.begin(), json.end(), nullptr, false);
+	if (document.is_discarded() || !document.is_object())
+	{
+		Log::error("error in GltfFile::load(): failed to parse the json of {}", filename);
+		return false;
+	}
+
+	std::vector<bool> mapped;
+	if (document.contains("buffers"))
+	{
+		auto& buffers = document["buffers"];
+		m_buffers.resize(buffers.size());
+		mapped.resize(buffers.size(), false);
+
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			auto& buffer = buffers[i];
+			size_t byteLength = buffer.value("byteLength", size_t(0));
+			std::string uri = buffer.value("uri", std::string());
+
+			if (uri.rfind("data:", 0) == 0)
+				continue;
+
+			DataView<uint8_t> data;
+			if (uri.empty())
+			{
+				if (!binary || bin.size() < byteLength)
+				{
+					Log::error("error in GltfFile::load(): buffer {} of {} has no data", i, filename);
+					return false;
+				}
+				data = DataView<uint8_t>(bin.data(), byteLength);
+			}
+			else
+			{
+				std::string path;
+				tinygltf::URIDecode(uri, &path, nullptr);
+
+				MappedFile bufferFile;
+				if (!bufferFile.open(directory + path) || bufferFile.getSize() < byteLength)
+				{
+					Log::error("error in GltfFile::load(): failed to map {} with {} bytes", directory + path, byteLength);
+					return false;
+				}
+
+				data = DataView<uint8_t>(bufferFile.getData(), byteLength);
+				m_files.push_back(std::move(bufferFile));
+				m_dependencies.push_back(path);
+			}
+
+			m_buffers[i] = data;
+			mapped[i] = true;
+			buffer["uri"] = placeholderUri;
+			buffer["byteLength"] = 1;
+		}
+	}
+
+	//images inside a mapped buffer would be read from the placeholder, textures are only loaded from uris anyway
+	if (document.contains("images") && document.contains("bufferViews"))
+	{
+		for (auto& image : document["images"])
+		{
+			if (!image.contains("bufferView"))
+				continue;
+
+			const auto& views = document["bufferViews"];
+			size_t view = image["bufferView"].get<size_t>();
+			int buffer = view < views.size() ? views[view].value("buffer", -1) : -1;
+			if (buffer < 0 || buffer >= static_cast<int>(mapped.size()) || !mapped[buffer])
+				continue;
+
+			Log::warn("{}: images stored in buffers are not supported", filename);
+			image.erase("bufferView");
+			image.erase("mimeType");
+			image["uri"] = "";
+		}
+	}
+
+	std::string text = document.dump();
+	document = nullptr;
+
+	tinygltf::TinyGLTF loader;
+	std::string err, warn;
+	if (!loader.LoadASCIIFromString(&model, &err, &warn, text.c_str(), static_cast<unsigned int>(text.size()), directory))
+	{
+		Log::error("tinygltf error: {}", err);
+		return false;
+	}
+
+	if (!warn.empty())
+		Log::warn("tinygltf warning: {}", warn);
+
+	//data uris were decoded by tinygltf
+	m_buffers.resize(model.buffers.size());
+	mapped.resize(model.buffers.size(), false);
+	for (size_t i = 0; i < model.buffers.size(); i++)
+	{
+		if (!mapped[i])
+			m_buffers[i] = model.buffers[i].data;
+	}
+
+	if (binary)
+		m_files.push_back(std::move(file));
+	return true;
+}
+
+void GltfFile::close()
+{
+	m_buffers.clear();
+	m_files.clear();
+	m_dependencies.clear();
+}
+
+size_t GltfFile::getMappedSize() const
+{
+	size_t size = 0;
+	for (auto& file : m_files)
+		size += file.getSize();
+	return size;
+}
\ No newline at end of file
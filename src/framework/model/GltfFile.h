@@ -0,0 +1,27 @@
+#pragma once
+
+#include "framework/utils/DataView.h"
+#include "framework/utils/MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <tiny_gltf.h>
+
+/// parses .gltf and .glb files without copying their binary buffers. the BIN chunk of a .glb and external
+/// .bin files are memory mapped and read in place, tinygltf only sees the json. data uris are still decoded by tinygltf
+class GltfFile
+{
+public:
+	bool load(const std::string& filename, tinygltf::Model& model);
+	void close();
+
+	/// bytes of a gltf buffer, valid until close() as long as the model passed to load() is alive
+	DataView<uint8_t> getBuffer(size_t index) const { return m_buffers[index]; }
+	/// external files the buffers were mapped from, relative to the gltf file
+	const std::vector<std::string>& getDependencies() const { return m_dependencies; }
+	size_t getMappedSize() const;
+private:
+	std::vector<MappedFile> m_files;
+	std::vector<DataView<uint8_t>> m_buffers;
+	std::vector<std::string> m_dependencies;
+};
\ No newline at end of file
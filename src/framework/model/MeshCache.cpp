@@ -0,0 +1,229 @@
+#include "MeshCache.h"
+
+#include "../utils/Log.h"
+#include "../utils/Hash.h"
+
+#include <fstream>
+#include <cstdio>
+
+namespace
+{
+	constexpr uint64_t sectionAlignment = 16;
+
+	std::string getDirectory(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+	}
+
+	uint64_t alignOffset(uint64_t offset)
+	{
+		return (offset + sectionAlignment - 1) & ~(sectionAlignment - 1);
+	}
+}
+
+uint64_t MeshCache::hashSources(const std::string& sourcePath, const std::vector<std::string>& dependencies, uint64_t optionsHash)
+{
+	std::vector<std::string> paths = { sourcePath };
+	std::string directory = getDirectory(sourcePath);
+	for (auto& dependency : dependencies)
+		paths.push_back(directory + dependency);
+
+	uint64_t hash = utils::hashValue(optionsHash);
+	for (auto& path : paths)
+	{
+		MappedFile file;
+		if (!file.open(path))
+			return 0;
+
+		hash = utils::hashBytes(file.getData(), file.getSize(), hash);
+	}
+
+	return hash;
+}
+
+bool MeshCache::write(const std::string& sourcePath, uint64_t optionsHash, const MeshCacheData& data)
+{
+	uint64_t sourceHash = hashSources(sourcePath, data.dependencies, optionsHash);
+	if (sourceHash == 0)
+	{
+		Log::warn("error in MeshCache::write(): failed to hash sources of {}", sourcePath);
+		return false;
+	}
+
+	//strings are stored in one blob and referenced by offset
+	std::string strings;
+	auto addString = [&strings](const std::string& str)
+	{
+		StringRecord record = { static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(str.size()) };
+		strings += str;
+		return record;
+	};
+
+	std::vector<StringRecord> dependencies;
+	for (auto& dependency : data.dependencies)
+		dependencies.push_back(addString(dependency));
+
+	std::vector<TextureRecord> textures;
+	for (auto& texture : data.textures)
+		textures.push_back({ addString(texture.uri), static_cast<uint32_t>(texture.format), texture.sampler });
+
+	struct SectionData
+	{
+		MeshCacheSection type;
+		uint32_t elementSize;
+		uint64_t count;
+		const void* data;
+	};
+
+	std::vector<SectionData> sections =
+	{
+		{ MeshCacheSection::eStrings,	   1,							  strings.size(),		   strings.data() },
+		{ MeshCacheSection::eDependencies, sizeof(StringRecord),		  dependencies.size(),	   dependencies.data() },
+		{ MeshCacheSection::eVertices,	   sizeof(Vertex),				  data.vertices.size(),	   data.vertices.data() },
+		{ MeshCacheSection::eIndices,	   sizeof(uint32_t),			  data.indices.size(),	   data.indices.data() },
+		{ MeshCacheSection::ePrimitives,   sizeof(Primitive),			  data.primitives.size(),  data.primitives.data() },
+		{ MeshCacheSection::eSamplers,	   sizeof(SamplerReference),	  data.samplers.size(),	   data.samplers.data() },
+		{ MeshCacheSection::eTextures,	   sizeof(TextureRecord),		  textures.size(),		   textures.data() },
+		{ MeshCacheSection::eMaterials,	   sizeof(MaterialReference),	  data.materials.size(),   data.materials.data() },
+		{ MeshCacheSection::eNodes,		   sizeof(SceneNode),			  data.nodes.size(),	   data.nodes.data() },
+		{ MeshCacheSection::eMeshlets,	   sizeof(Meshlet),				  data.meshlets.size(),	   data.meshlets.data() },
+		{ MeshCacheSection::eLods,		   sizeof(MeshLod),				  data.lods.size(),		   data.lods.data() },
+		{ MeshCacheSection::eInstances,	   sizeof(uint32_t),			  data.instances.size(),   data.instances.data() },
+	};
+
+	Header header = {};
+	header.magic = magic;
+	header.version = version;
+	header.sourceHash = sourceHash;
+	header.sectionCount = static_cast<uint32_t>(sections.size());
+
+	std::vector<SectionEntry> entries;
+	uint64_t offset = alignOffset(sizeof(Header) + sizeof(SectionEntry) * sections.size());
+	for (auto& section : sections)
+	{
+		entries.push_back({ section.type, section.elementSize, offset, section.count });
+		offset = alignOffset(offset + section.elementSize * section.count);
+	}
+
+	//write to a temporary file first so an interrupted write never leaves a cache that looks valid
+	std::string path = getPath(sourcePath);
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			Log::warn("error in MeshCache::write(): failed to open {}", tempPath);
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(reinterpret_cast<const char*>(entries.data()), sizeof(SectionEntry) * entries.size());
+
+		const char padding[sectionAlignment] = {};
+		for (size_t i = 0; i < sections.size(); i++)
+		{
+			uint64_t position = static_cast<uint64_t>(file.tellp());
+			file.write(padding, entries[i].offset - position);
+			file.write(reinterpret_cast<const char*>(sections[i].data), sections[i].elementSize * sections[i].count);
+		}
+
+		if (!file.good())
+		{
+			Log::warn("error in MeshCache::write(): failed to write {}", tempPath);
+			return false;
+		}
+	}
+
+	std::remove(path.c_str());
+	if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		Log::warn("error in MeshCache::write(): failed to rename {}", tempPath);
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::open(const std::string& sourcePath, uint64_t optionsHash)
+{
+	close();
+
+	if (!m_file.open(getPath(sourcePath)))
+		return false;
+
+	const Header* header = reinterpret_cast<const Header*>(m_file.getData());
+	bool valid = m_file.getSize() >= sizeof(Header)
+		&& header->magic == magic
+		&& header->version == version
+		&& m_file.getSize() >= sizeof(Header) + sizeof(SectionEntry) * header->sectionCount;
+
+	if (valid)
+	{
+		//every section has to lie inside the file before anything is read from it
+		const SectionEntry* entries = reinterpret_cast<const SectionEntry*>(m_file.getData() + sizeof(Header));
+		for (uint32_t i = 0; i < header->sectionCount && valid; i++)
+			valid = entries[i].offset + entries[i].elementSize * entries[i].count <= m_file.getSize();
+	}
+
+	if (!valid)
+	{
+		Log::info("mesh cache for {} is outdated", sourcePath);
+		close();
+		return false;
+	}
+
+	if (hashSources(sourcePath, getDependencies(), optionsHash) != header->sourceHash)
+	{
+		Log::info("mesh cache for {} does not match its source", sourcePath);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MeshCache::close()
+{
+	m_file.close();
+}
+
+std::vector<TextureReference> MeshCache::getTextures() const
+{
+	std::vector<TextureReference> textures;
+	for (auto& record : getSection<TextureRecord>(MeshCacheSection::eTextures))
+		textures.push_back({ getString(record.uri), static_cast<vk::Format>(record.format), record.sampler });
+	return textures;
+}
+
+std::vector<std::string> MeshCache::getDependencies() const
+{
+	std::vector<std::string> dependencies;
+	for (auto& record : getSection<StringRecord>(MeshCacheSection::eDependencies))
+		dependencies.push_back(getString(record));
+	return dependencies;
+}
+
+std::string MeshCache::getString(const StringRecord& record) const
+{
+	auto strings = getSection<char>(MeshCacheSection::eStrings);
+	if (static_cast<size_t>(record.offset) + record.length > strings.size())
+		return {};
+	return std::string(strings.data() + record.offset, record.length);
+}
+
+const MeshCache::SectionEntry* MeshCache::findSection(MeshCacheSection type, uint32_t elementSize) const
+{
+	if (!m_file.isOpen())
+		return nullptr;
+
+	const Header* header = reinterpret_cast<const Header*>(m_file.getData());
+	const SectionEntry* entries = reinterpret_cast<const SectionEntry*>(m_file.getData() + sizeof(Header));
+	for (uint32_t i = 0; i < header->sectionCount; i++)
+	{
+		if (entries[i].type == type)
+			return entries[i].elementSize == elementSize ? &entries[i] : nullptr;
+	}
+
+	return nullptr;
+}
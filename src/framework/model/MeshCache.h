@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Vertex.h"
+#include "Primitive.h"
+#include "Meshlet.h"
+#include "framework/scene/SceneGraph.h"
+#include "framework/utils/MappedFile.h"
+#include "framework/utils/DataView.h"
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+//glTF sampler enums, converted to vulkan when the samplers are created
+struct SamplerReference
+{
+	int32_t magFilter;
+	int32_t wrapS;
+};
+
+struct TextureReference
+{
+	std::string uri;
+	vk::Format format;
+	int32_t sampler;
+};
+
+struct MaterialReference
+{
+	int32_t albedo;
+	int32_t normal;
+	int32_t metallicRoughness;
+	glm::vec4 baseColorFactor;
+	float metallicFactor;
+	float roughnessFactor;
+};
+
+enum class MeshCacheSection : uint32_t
+{
+	eStrings,
+	eDependencies,
+	eVertices,
+	eIndices,
+	ePrimitives,
+	eSamplers,
+	eTextures,
+	eMaterials,
+	eNodes,
+	eMeshlets,
+	eLods,
+	eInstances,
+};
+
+struct MeshCacheData
+{
+	std::vector<std::string> dependencies;
+	DataView<Vertex> vertices;
+	DataView<uint32_t> indices;
+	DataView<Primitive> primitives;
+	DataView<Meshlet> meshlets;
+	DataView<MeshLod> lods;
+	DataView<SamplerReference> samplers;
+	DataView<TextureReference> textures;
+	DataView<MaterialReference> materials;
+	DataView<SceneNode> nodes;
+	DataView<uint32_t> instances;
+};
+
+/// binary cache of an imported model, stored next to the source asset as <source>.meshcache
+/// the file is memory mapped and the vertex/index sections are handed out as views into the mapping,
+/// so they stay valid until close() is called
+class MeshCache
+{
+public:
+	static constexpr uint32_t magic = 0x4348534d; //"MSHC"
+	static constexpr uint32_t version = 9;
+
+	static std::string getPath(const std::string& sourcePath) { return sourcePath + ".meshcache"; }
+	static bool write(const std::string& sourcePath, uint64_t optionsHash, const MeshCacheData& data);
+
+	bool open(const std::string& sourcePath, uint64_t optionsHash);
+	void close();
+	bool isOpen() const { return m_file.isOpen(); }
+
+	DataView<Vertex> getVertices() const { return getSection<Vertex>(MeshCacheSection::eVertices); }
+	DataView<uint32_t> getIndices() const { return getSection<uint32_t>(MeshCacheSection::eIndices); }
+	DataView<Primitive> getPrimitives() const { return getSection<Primitive>(MeshCacheSection::ePrimitives); }
+	DataView<Meshlet> getMeshlets() const { return getSection<Meshlet>(MeshCacheSection::eMeshlets); }
+	DataView<MeshLod> getLods() const { return getSection<MeshLod>(MeshCacheSection::eLods); }
+	DataView<SamplerReference> getSamplers() const { return getSection<SamplerReference>(MeshCacheSection::eSamplers); }
+	DataView<MaterialReference> getMaterials() const { return getSection<MaterialReference>(MeshCacheSection::eMaterials); }
+	std::vector<TextureReference> getTextures() const;
+	DataView<SceneNode> getNodes() const { return getSection<SceneNode>(MeshCacheSection::eNodes); }
+	DataView<uint32_t> getInstances() const { return getSection<uint32_t>(MeshCacheSection::eInstances); }
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t sectionCount;
+		uint32_t padding;
+	};
+
+	struct SectionEntry
+	{
+		MeshCacheSection type;
+		uint32_t elementSize;
+		uint64_t offset;
+		uint64_t count;
+	};
+
+	struct StringRecord
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct TextureRecord
+	{
+		StringRecord uri;
+		uint32_t format;
+		int32_t sampler;
+	};
+
+	static uint64_t hashSources(const std::string& sourcePath, const std::vector<std::string>& dependencies, uint64_t optionsHash);
+	std::vector<std::string> getDependencies() const;
+	std::string getString(const StringRecord& record) const;
+
+	const SectionEntry* findSection(MeshCacheSection type, uint32_t elementSize) const;
+
+	template<typename T>
+	DataView<T> getSection(MeshCacheSection type) const
+	{
+		const SectionEntry* section = findSection(type, sizeof(T));
+		if (!section)
+			return {};
+		return { reinterpret_cast<const T*>(m_file.getData() + section->offset), static_cast<size_t>(section->count) };
+	}
+private:
+	MappedFile m_file;
+};
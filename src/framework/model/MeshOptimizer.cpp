@@ -0,0 +1,316 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+	constexpr uint32_t invalidIndex = ~0u;
+
+	//fifo cache simulated with insertion timestamps, a vertex is cached while fewer than cacheSize vertices were inserted after it
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount, uint32_t cacheSize) : m_timestamps(vertexCount, 0), m_cacheSize(cacheSize), m_time(cacheSize + 1) {}
+
+		bool access(uint32_t vertex)
+		{
+			if (m_time - m_timestamps[vertex] <= m_cacheSize)
+				return true;
+
+			m_timestamps[vertex] = m_time++;
+			return false;
+		}
+
+		void reset() { m_time += m_cacheSize + 1; }
+	private:
+		std::vector<uint32_t> m_timestamps;
+		uint32_t m_cacheSize;
+		uint32_t m_time;
+	};
+
+	struct Cluster
+	{
+		size_t firstTriangle;
+		size_t triangleCount;
+		float sortKey;
+	};
+
+	uint32_t getTriangleMisses(FifoCache& cache, const uint32_t* triangle)
+	{
+		uint32_t misses = 0;
+		for (uint32_t i = 0; i < 3; i++)
+			misses += cache.access(triangle[i]) ? 0 : 1;
+		return misses;
+	}
+
+	//a hard boundary is a triangle without any cached vertex, splitting there costs nothing.
+	//the first triangle always starts a cluster, a degenerate one misses fewer than 3 vertices
+	std::vector<size_t> getHardBoundaries(const uint32_t* indices, size_t triangleCount, size_t vertexCount, uint32_t cacheSize)
+	{
+		std::vector<size_t> boundaries = { 0 };
+		FifoCache cache(vertexCount, cacheSize);
+		getTriangleMisses(cache, &indices[0]);
+		for (size_t t = 1; t < triangleCount; t++)
+		{
+			if (getTriangleMisses(cache, &indices[t * 3]) == 3)
+				boundaries.push_back(t);
+		}
+		return boundaries;
+	}
+
+	//splits every hard cluster again whenever the cold cache acmr of the current piece is within the threshold
+	std::vector<size_t> getSoftBoundaries(const uint32_t* indices, size_t triangleCount, size_t vertexCount, const std::vector<size_t>& hardBoundaries, float threshold, uint32_t cacheSize)
+	{
+		std::vector<size_t> boundaries;
+		FifoCache cache(vertexCount, cacheSize);
+
+		for (size_t i = 0; i < hardBoundaries.size(); i++)
+		{
+			size_t start = hardBoundaries[i];
+			size_t end = i + 1 < hardBoundaries.size() ? hardBoundaries[i + 1] : triangleCount;
+
+			cache.reset();
+			uint32_t clusterMisses = 0;
+			for (size_t t = start; t < end; t++)
+				clusterMisses += getTriangleMisses(cache, &indices[t * 3]);
+
+			float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+			size_t firstBoundary = boundaries.size();
+			boundaries.push_back(start);
+
+			cache.reset();
+			uint32_t runningMisses = 0;
+			uint32_t runningTriangles = 0;
+			for (size_t t = start; t < end; t++)
+			{
+				runningMisses += getTriangleMisses(cache, &indices[t * 3]);
+				runningTriangles++;
+
+				if (static_cast<float>(runningMisses) / static_cast<float>(runningTriangles) <= clusterThreshold && t + 1 < end)
+				{
+					boundaries.push_back(t + 1);
+					cache.reset();
+					runningMisses = 0;
+					runningTriangles = 0;
+				}
+			}
+
+			//the tail never reached the target, merge it into the previous piece
+			if (runningTriangles > 0 && boundaries.size() > firstBoundary + 1)
+				boundaries.pop_back();
+		}
+
+		return boundaries;
+	}
+}
+
+VertexCacheStats utils::analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats;
+	if (indexCount < 3)
+		return stats;
+
+	FifoCache cache(vertexCount, cacheSize);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t uniqueVertices = 0;
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		if (!cache.access(indices[i]))
+			stats.transformedVertices++;
+
+		if (!referenced[indices[i]])
+		{
+			referenced[indices[i]] = true;
+			uniqueVertices++;
+		}
+	}
+
+	stats.acmr = static_cast<float>(stats.transformedVertices) / static_cast<float>(indexCount / 3);
+	stats.atvr = static_cast<float>(stats.transformedVertices) / static_cast<float>(uniqueVertices);
+	return stats;
+}
+
+void utils::optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return;
+
+	//triangles adjacent to each vertex
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		liveTriangles[indices[i]]++;
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	size_t cursor = 0;
+
+	auto skipDeadEnd = [&]() -> uint32_t
+	{
+		while (!deadEnd.empty())
+		{
+			uint32_t vertex = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveTriangles[vertex] > 0)
+				return vertex;
+		}
+
+		for (; cursor < vertexCount; cursor++)
+		{
+			if (liveTriangles[cursor] > 0)
+				return static_cast<uint32_t>(cursor);
+		}
+
+		return invalidIndex;
+	};
+
+	uint32_t fanning = skipDeadEnd();
+	while (fanning != invalidIndex)
+	{
+		candidates.clear();
+
+		for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++)
+		{
+			uint32_t triangle = adjacency[a];
+			if (emitted[triangle])
+				continue;
+
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				uint32_t vertex = indices[triangle * 3 + i];
+				output.push_back(vertex);
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+
+				if (time - timestamps[vertex] > cacheSize)
+					timestamps[vertex] = time++;
+			}
+
+			emitted[triangle] = true;
+		}
+
+		//prefer the oldest cached vertex whose remaining triangles still fit into the cache
+		uint32_t next = invalidIndex;
+		int64_t bestPriority = -1;
+		for (uint32_t vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			int64_t priority = 0;
+			if (time - timestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+				priority = time - timestamps[vertex];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		fanning = next != invalidIndex ? next : skipDeadEnd();
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void utils::optimizeOverdraw(uint32_t* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount, float threshold, uint32_t cacheSize)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	auto hardBoundaries = getHardBoundaries(indices, triangleCount, vertexCount, cacheSize);
+	auto boundaries = getSoftBoundaries(indices, triangleCount, vertexCount, hardBoundaries, threshold, cacheSize);
+
+	//area weighted centroid and normal of every cluster
+	std::vector<Cluster> clusters(boundaries.size());
+	std::vector<glm::vec3> centroids(boundaries.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(boundaries.size(), glm::vec3(0.0f));
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		size_t end = c + 1 < boundaries.size() ? boundaries[c + 1] : triangleCount;
+		clusters[c].firstTriangle = boundaries[c];
+		clusters[c].triangleCount = end - boundaries[c];
+
+		float clusterArea = 0.0f;
+		for (size_t t = boundaries[c]; t < end; t++)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(normal);
+
+			centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+			normals[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += centroids[c];
+		meshArea += clusterArea;
+		centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : vertices[indices[boundaries[c] * 3]].position;
+	}
+
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+	//clusters facing away from the center occlude the rest of the mesh, so they are drawn first
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		float length = glm::length(normals[c]);
+		clusters[c].sortKey = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	for (auto& cluster : clusters)
+		output.insert(output.end(), indices + cluster.firstTriangle * 3, indices + (cluster.firstTriangle + cluster.triangleCount) * 3);
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+size_t utils::optimizeVertexFetch(std::vector<Vertex>& vertices, uint32_t* indices, size_t indexCount)
+{
+	std::vector<uint32_t> remap(vertices.size(), invalidIndex);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		uint32_t& mapped = remap[indices[i]];
+		if (mapped == invalidIndex)
+		{
+			mapped = static_cast<uint32_t>(reordered.size());
+			reordered.push_back(vertices[indices[i]]);
+		}
+
+		indices[i] = mapped;
+	}
+
+	vertices = std::move(reordered);
+	return vertices.size();
+}
\ No newline at end of file
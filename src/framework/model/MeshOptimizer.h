@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/// statistics of a simulated fifo post-transform cache
+struct VertexCacheStats
+{
+	/// vertex shader invocations per triangle, 0.5 is the lower bound for regular meshes
+	float acmr = 0.0f;
+	/// vertex shader invocations per referenced vertex, 1.0 is optimal
+	float atvr = 0.0f;
+	uint32_t transformedVertices = 0;
+};
+
+//all functions work on primitive local indices in [0, vertexCount)
+namespace utils
+{
+	constexpr uint32_t vertexCacheSize = 16;
+
+	VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = vertexCacheSize);
+
+	/// tipsify (Sander et al. 2007), reorders triangles in place for the post-transform cache
+	void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = vertexCacheSize);
+
+	/// splits the cache optimized order into clusters and draws outward facing clusters first,
+	/// threshold is the acmr degradation allowed for splitting clusters further
+	void optimizeOverdraw(uint32_t* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount, float threshold = 1.05f, uint32_t cacheSize = vertexCacheSize);
+
+	/// reorders vertices by first use and drops unreferenced ones, returns the new vertex count
+	size_t optimizeVertexFetch(std::vector<Vertex>& vertices, uint32_t* indices, size_t indexCount);
+}
\ No newline at end of file
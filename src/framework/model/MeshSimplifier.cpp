@@ -0,0 +1,284 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <cstring>
+
+namespace
+{
+	//symmetric 4x4 matrix of summed plane equations, weighted by triangle area
+	struct Quadric
+	{
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+		double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+		double a22 = 0.0, a23 = 0.0;
+		double a33 = 0.0;
+		double weight = 0.0;
+
+		void addPlane(const glm::dvec3& n, double d, double w)
+		{
+			a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+			a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+			a22 += w * n.z * n.z; a23 += w * n.z * d;
+			a33 += w * d * d;
+			weight += w;
+		}
+
+		void add(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+			a11 += q.a11; a12 += q.a12; a13 += q.a13;
+			a22 += q.a22; a23 += q.a23;
+			a33 += q.a33;
+			weight += q.weight;
+		}
+
+		//weighted mean squared distance of p to the planes
+		double evaluate(const glm::vec3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double result = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+						  + a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+						  + a22 * z * z + 2.0 * a23 * z
+						  + a33;
+			return weight > 0.0 ? std::max(result, 0.0) / weight : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3& p) const
+		{
+			uint32_t bits[3];
+			memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	uint64_t edgeKey(uint32_t a, uint32_t b)
+	{
+		return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+	}
+
+	glm::vec3 triangleNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+	{
+		return glm::cross(p1 - p0, p2 - p0);
+	}
+}
+
+std::vector<uint32_t> utils::simplifyMesh(const uint32_t* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount,
+	size_t targetIndexCount, float targetError, float* error)
+{
+	std::vector<uint32_t> result(indices, indices + indexCount);
+	float maxError = 0.0f;
+	if (error)
+		*error = 0.0f;
+
+	if (vertexCount == 0 || indexCount < 3)
+		return result;
+
+	//vertices sharing a position are one point of the surface, they differ only in their attributes
+	std::vector<uint32_t> canonical(vertexCount);
+	std::vector<uint32_t> positionUsers(vertexCount, 0);
+	{
+		std::unordered_map<glm::vec3, uint32_t, PositionHash> positions;
+		positions.reserve(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			auto it = positions.emplace(vertices[v].position, v).first;
+			canonical[v] = it->second;
+			positionUsers[it->second]++;
+		}
+	}
+
+	//seams and borders stay in place, otherwise the lods would tear open
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, uint32_t> edgeUse;
+		edgeUse.reserve(indexCount);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (uint32_t e = 0; e < 3; e++)
+				edgeUse[edgeKey(canonical[result[i + e]], canonical[result[i + (e + 1) % 3]])]++;
+		}
+
+		for (auto& [key, uses] : edgeUse)
+		{
+			if (uses != 1)
+				continue;
+			locked[key >> 32] = true;
+			locked[key & 0xffffffffu] = true;
+		}
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if (positionUsers[canonical[v]] > 1 || locked[canonical[v]])
+				locked[v] = true;
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		glm::dvec3 p0 = vertices[result[i + 0]].position;
+		glm::dvec3 p1 = vertices[result[i + 1]].position;
+		glm::dvec3 p2 = vertices[result[i + 2]].position;
+
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		double area = glm::length(normal);
+		if (area <= 1e-20)
+			continue;
+
+		normal /= area;
+		Quadric quadric;
+		quadric.addPlane(normal, -glm::dot(normal, p0), area);
+		for (uint32_t k = 0; k < 3; k++)
+			quadrics[canonical[result[i + k]]].add(quadric);
+	}
+
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<bool> touched(vertexCount);
+	double maxCost = double(targetError) * double(targetError);
+
+	while (result.size() > targetIndexCount)
+	{
+		size_t triangleCount = result.size() / 3;
+
+		//triangles around every vertex
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result)
+			adjacencyOffsets[index + 1]++;
+		for (size_t v = 0; v < vertexCount; v++)
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+		adjacency.resize(result.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < result.size(); i++)
+			adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+
+		//collapse candidates, a free vertex can move onto any of its neighbours
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (uint32_t e = 0; e < 3; e++)
+			{
+				uint32_t a = result[i + e];
+				uint32_t b = result[i + (e + 1) % 3];
+				if (canonical[a] == canonical[b])
+					continue;
+
+				Quadric quadric = quadrics[canonical[a]];
+				quadric.add(quadrics[canonical[b]]);
+				if (!locked[a])
+					collapses.push_back({ a, b, quadric.evaluate(vertices[b].position) });
+				if (!locked[b])
+					collapses.push_back({ b, a, quadric.evaluate(vertices[a].position) });
+			}
+		}
+
+		if (collapses.empty())
+			break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+			remap[v] = v;
+		std::fill(touched.begin(), touched.end(), false);
+
+		//each collapse removes about two triangles
+		size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+		size_t removed = 0;
+		size_t applied = 0;
+
+		for (auto& collapse : collapses)
+		{
+			if (collapse.cost > maxCost || removed >= trianglesToRemove)
+				break;
+
+			if (touched[collapse.from] || touched[collapse.to])
+				continue;
+
+			//reject collapses that flip or squash a triangle around the moving vertex
+			const glm::vec3& target = vertices[collapse.to].position;
+			bool valid = true;
+			uint32_t removedHere = 0;
+			for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && valid; a++)
+			{
+				const uint32_t* triangle = &result[adjacency[a] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+				{
+					removedHere++;
+					continue;
+				}
+
+				glm::vec3 p[3];
+				glm::vec3 q[3];
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					p[k] = vertices[triangle[k]].position;
+					q[k] = triangle[k] == collapse.from ? target : p[k];
+				}
+
+				glm::vec3 before = triangleNormal(p[0], p[1], p[2]);
+				glm::vec3 after = triangleNormal(q[0], q[1], q[2]);
+				float beforeLength = glm::length(before);
+				float afterLength = glm::length(after);
+				if (afterLength <= 1e-12f || glm::dot(before, after) < 0.25f * beforeLength * afterLength)
+					valid = false;
+			}
+
+			if (!valid)
+				continue;
+
+			//the neighbourhood changed, later flip checks in this pass would be stale
+			for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++)
+			{
+				const uint32_t* triangle = &result[adjacency[a] * 3];
+				for (uint32_t k = 0; k < 3; k++)
+					touched[triangle[k]] = true;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[canonical[collapse.to]].add(quadrics[canonical[collapse.from]]);
+			maxError = std::max(maxError, static_cast<float>(std::sqrt(collapse.cost)));
+			removed += removedHere;
+			applied++;
+		}
+
+		if (applied == 0)
+			break;
+
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t a = remap[result[i + 0]];
+			uint32_t b = remap[result[i + 1]];
+			uint32_t c = remap[result[i + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+
+		result.resize(write);
+		if (write / 3 == triangleCount)
+			break;
+	}
+
+	if (error)
+		*error = maxError;
+	return result;
+}
\ No newline at end of file
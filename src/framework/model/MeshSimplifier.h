@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace utils
+{
+	/// quadric error metric edge collapse on primitive local indices. vertices are only ever collapsed onto other
+	/// existing vertices, so the result indexes the same vertex range. uv seams and open borders are kept in place.
+	/// stops at targetIndexCount or when the next collapse would move the surface further than targetError,
+	/// error receives the largest distance actually introduced
+	std::vector<uint32_t> simplifyMesh(const uint32_t* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount,
+		size_t targetIndexCount, float targetError, float* error = nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	void computeBounds(Meshlet& meshlet, DataView<uint32_t> indices, DataView<Vertex> vertices, const std::vector<uint32_t>& meshletVertices)
+	{
+		glm::vec3 minPosition = vertices[meshletVertices[0]].position;
+		glm::vec3 maxPosition = minPosition;
+		for (uint32_t vertex : meshletVertices)
+		{
+			minPosition = glm::min(minPosition, vertices[vertex].position);
+			maxPosition = glm::max(maxPosition, vertices[vertex].position);
+		}
+
+		meshlet.center = (minPosition + maxPosition) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (uint32_t vertex : meshletVertices)
+			meshlet.radius = std::max(meshlet.radius, glm::length(vertices[vertex].position - meshlet.center));
+
+		//normal cone, meshlets with widely spread normals are never cone culled
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec3> corners;
+		glm::vec3 axis(0.0f);
+		for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+		{
+			const glm::vec3& p0 = vertices[indices[i + 0]].position;
+			const glm::vec3& p1 = vertices[indices[i + 1]].position;
+			const glm::vec3& p2 = vertices[indices[i + 2]].position;
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float length = glm::length(normal);
+			if (length <= 1e-12f)
+				continue;
+
+			normals.push_back(normal / length);
+			corners.push_back(p0);
+			axis += normals.back();
+		}
+
+		meshlet.coneApex = meshlet.center;
+		meshlet.coneAxis = glm::vec3(0.0f);
+		meshlet.coneCutoff = 1.0f;
+
+		float axisLength = glm::length(axis);
+		if (normals.empty() || axisLength <= 1e-6f)
+			return;
+
+		axis /= axisLength;
+		float minDot = 1.0f;
+		for (auto& normal : normals)
+			minDot = std::min(minDot, glm::dot(normal, axis));
+
+		if (minDot <= 0.1f)
+			return;
+
+		//move the apex back along the axis until it lies behind every triangle plane
+		float maxDistance = 0.0f;
+		for (size_t i = 0; i < normals.size(); i++)
+			maxDistance = std::max(maxDistance, glm::dot(meshlet.center - corners[i], normals[i]) / glm::dot(axis, normals[i]));
+
+		meshlet.coneApex = meshlet.center - axis * maxDistance;
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
+
+void utils::buildMeshlets(DataView<uint32_t> indices, uint32_t firstIndex, uint32_t indexCount, DataView<Vertex> vertices, std::vector<Meshlet>& meshlets)
+{
+	std::vector<uint32_t> meshletVertices;
+	meshletVertices.reserve(maxMeshletVertices);
+
+	Meshlet meshlet = {};
+	meshlet.firstIndex = firstIndex;
+
+	auto finish = [&]()
+	{
+		if (meshlet.indexCount == 0)
+			return;
+
+		computeBounds(meshlet, indices, vertices, meshletVertices);
+		meshlets.push_back(meshlet);
+
+		meshlet = {};
+		meshlet.firstIndex = meshlets.back().firstIndex + meshlets.back().indexCount;
+		meshletVertices.clear();
+	};
+
+	for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3)
+	{
+		uint32_t newVertices = 0;
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint32_t vertex = indices[i + j];
+			bool known = std::find(meshletVertices.begin(), meshletVertices.end(), vertex) != meshletVertices.end();
+			bool repeated = (j > 0 && indices[i] == vertex) || (j > 1 && indices[i + 1] == vertex);
+			newVertices += known || repeated ? 0 : 1;
+		}
+
+		if (meshletVertices.size() + newVertices > maxMeshletVertices || meshlet.indexCount / 3 >= maxMeshletTriangles)
+			finish();
+
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint32_t vertex = indices[i + j];
+			if (std::find(meshletVertices.begin(), meshletVertices.end(), vertex) == meshletVertices.end())
+				meshletVertices.push_back(vertex);
+		}
+
+		meshlet.indexCount += 3;
+	}
+
+	finish();
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Vertex.h"
+#include "framework/utils/DataView.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/// contiguous range of a primitive's indices, the unit of cluster culling
+struct Meshlet
+{
+	glm::vec3 center;
+	float radius;
+	//every triangle faces away from a camera inside the cone with apex coneApex opening along coneAxis,
+	//coneCutoff is the sine of the half angle of the normal cone
+	glm::vec3 coneApex;
+	float coneCutoff;
+	glm::vec3 coneAxis;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
+
+namespace utils
+{
+	constexpr uint32_t maxMeshletVertices = 64;
+	constexpr uint32_t maxMeshletTriangles = 124;
+
+	/// splits indices [firstIndex, firstIndex + indexCount) in their current order, meshlets are appended
+	void buildMeshlets(DataView<uint32_t> indices, uint32_t firstIndex, uint32_t indexCount, DataView<Vertex> vertices, std::vector<Meshlet>& meshlets);
+}
\ No newline at end of file
@@ -1,11 +1,21 @@
 #include "Model.h"
 
 #include "../utils/Log.h"
+#include "../Renderer.h"
+#include "../utils/Hash.h"
+#include "../utils/Utils.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "AccessorConversion.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
+//images are decoded by Texture on the loader threads, not by tinygltf
+#define TINYGLTF_NO_EXTERNAL_IMAGE
 #define TINYGLTF_IMPLEMENTATION
 #include <tiny_gltf.h>
 #include <set>
+#include <filesystem>
+#include <cstddef>
 
 #include <glm/gtc/type_ptr.hpp>
 
@@ -13,6 +23,87 @@ namespace
 {
 	std::unordered_map<int, vk::Filter> filterMap;
 	std::unordered_map<int, vk::SamplerAddressMode> addressMap;
+
+	//start of the first element and the distance between elements, tightly packed views report their element size
+	const uint8_t* getAccessorData(const tinygltf::Model& model, const GltfFile& file, const tinygltf::Accessor& accessor, size_t& stride)
+	{
+		const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+		stride = static_cast<size_t>(std::max(accessor.ByteStride(view), 0));
+		return file.getBuffer(view.buffer).data() + accessor.byteOffset + view.byteOffset;
+	}
+
+	//nodes of the displayed scene, or every node without a parent if there is no scene
+	std::vector<int> getRootNodes(const tinygltf::Model& model)
+	{
+		if (!model.scenes.empty())
+			return model.scenes[model.defaultScene >= 0 ? model.defaultScene : 0].nodes;
+
+		std::vector<bool> isChild(model.nodes.size(), false);
+		for (auto& node : model.nodes)
+			for (int child : node.children)
+				isChild[child] = true;
+
+		std::vector<int> roots;
+		for (size_t i = 0; i < model.nodes.size(); i++)
+			if (!isChild[i])
+				roots.push_back(static_cast<int>(i));
+		return roots;
+	}
+
+	//first pass of the import, sizes the vertex and index arrays so they are allocated only once
+	void countGeometry(const tinygltf::Model& model, const tinygltf::Mesh& mesh, size_t& vertexCount, size_t& indexCount)
+	{
+		for (auto& primitive : mesh.primitives)
+		{
+			auto position = primitive.attributes.find("POSITION");
+			if (primitive.indices < 0 || position == primitive.attributes.end())
+				continue;
+
+			vertexCount += model.accessors[position->second].count;
+			indexCount += model.accessors[primitive.indices].count;
+		}
+	}
+
+	//one element of a float or normalized integer accessor, missing components are 0
+	glm::vec4 readAccessor(const tinygltf::Model& model, const GltfFile& file, const tinygltf::Accessor& accessor, size_t index)
+	{
+		size_t stride = 0;
+		const uint8_t* element = getAccessorData(model, file, accessor, stride) + index * stride;
+		uint32_t components = std::min(static_cast<uint32_t>(tinygltf::GetNumComponentsInType(accessor.type)), 4u);
+
+		glm::vec4 result(0.0f);
+		for (uint32_t c = 0; c < components; c++)
+		{
+			switch (accessor.componentType)
+			{
+			case TINYGLTF_COMPONENT_TYPE_FLOAT:
+				memcpy(&result[c], element + c * sizeof(float), sizeof(float));
+				break;
+			case TINYGLTF_COMPONENT_TYPE_BYTE:
+				result[c] = std::max(static_cast<int8_t>(element[c]) / 127.0f, -1.0f);
+				break;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				result[c] = element[c] / 255.0f;
+				break;
+			case TINYGLTF_COMPONENT_TYPE_SHORT:
+			{
+				int16_t value;
+				memcpy(&value, element + c * sizeof(value), sizeof(value));
+				result[c] = std::max(value / 32767.0f, -1.0f);
+				break;
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				memcpy(&value, element + c * sizeof(value), sizeof(value));
+				result[c] = value / 65535.0f;
+				break;
+			}
+			}
+		}
+
+		return result;
+	}
 }
 
 Model::Model()
@@ -31,40 +122,175 @@ Model::Model()
 
 void Model::destroy()
 {
+	//let pending decodes finish before the textures go away
+	m_texturePool.reset();
+
+	//textures decoded while streaming but never created still own their staging
+	auto& upload = Renderer::getUploadContext();
+	for (size_t i = m_nextTexture; i < m_decodedTextures.size(); i++)
+	{
+		if (m_decodedTextures[i].staging.isValid())
+			upload.releaseStaging(m_decodedTextures[i].staging);
+	}
+	m_decodedTextures.clear();
+
+	//the transfer queue may still write the images, and their acquires and mip blits may not have been recorded by a frame yet
+	upload.flush();
+	auto cmd = Renderer::beginSingleTimeCommand();
+	upload.recordAcquires(cmd);
+	Renderer::endSingleTimeCommand(cmd);
+
 	for (auto& texture : m_textures)
 		texture.destroy();
+
+	m_meshCache.close();
+}
+
+void Model::loadFromDisk(const std::string& filename, const ModelLoadOptions& options)
+{
+	Timer timer;
+	m_options = options;
+
+	size_t slash = filename.find_last_of("/\\");
+	m_directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+
+	bool cached = m_options.useMeshCache && loadMeshCache(filename);
+	if (!cached)
+	{
+		tinygltf::Model model;
+		GltfFile file;
+		if (!loadGltfModel(filename, file, model))
+			return;
+
+		if (m_options.useMeshCache)
+			writeMeshCache(filename, file);
+	}
+
+	setVertexFormat(m_options.vertexFormat);
+	selectIndexType();
+
+	double geometryTime = timer.elapsedMs();
+
+	if (m_options.loadTextures)
+	{
+		createTextures();
+		createMaterials();
+	}
+
+	Log::info("loaded {} from {}: {} vertices and {} indices, geometry {:.2f} ms, total {:.2f} ms, peak rss {:.1f} MB",
+		filename, cached ? "mesh cache" : "gltf", m_vertices.size(), m_indices.size(), geometryTime, timer.elapsedMs(),
+		utils::getPeakMemoryUsage() / (1024.0 * 1024.0));
 }
 
-void Model::loadFromDisk(const std::string& filename)
+bool Model::loadMeshCache(const std::string& filename)
 {
-	loadGltfModel(filename);
+	if (!m_meshCache.open(filename, getOptionsHash()))
+		return false;
+
+	m_vertices = m_meshCache.getVertices();
+	m_indices = m_meshCache.getIndices();
+	m_primitives = m_meshCache.getPrimitives();
+	m_meshlets = m_meshCache.getMeshlets();
+	m_lods = m_meshCache.getLods();
+	m_instances = m_meshCache.getInstances();
+
+	auto samplers = m_meshCache.getSamplers();
+	auto materials = m_meshCache.getMaterials();
+	m_samplerReferences.assign(samplers.begin(), samplers.end());
+	m_materialReferences.assign(materials.begin(), materials.end());
+	m_textureReferences = m_meshCache.getTextures();
+	m_sceneGraph.create(m_meshCache.getNodes());
+	return true;
 }
 
-void Model::loadGltfModel(const std::string& filename)
+void Model::writeMeshCache(const std::string& filename, const GltfFile& file)
 {
-	tinygltf::TinyGLTF loader;
-	tinygltf::Model model;
-	std::string err, warn;
-	bool success = loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+	//embedded buffers are covered by the hash of the gltf file itself
+	MeshCacheData data;
+	data.dependencies = file.getDependencies();
+
+	data.vertices = m_vertices;
+	data.indices = m_indices;
+	data.primitives = m_primitives;
+	data.meshlets = m_meshlets;
+	data.lods = m_lods;
+	data.instances = m_instances;
+	data.samplers = m_samplerReferences;
+	data.textures = m_textureReferences;
+	data.materials = m_materialReferences;
+	std::vector<SceneNode> nodes;
+	for (uint32_t i = 0; i < m_sceneGraph.size(); i++)
+		nodes.push_back(m_sceneGraph.getNode(i));
+	data.nodes = nodes;
+
+	if (MeshCache::write(filename, getOptionsHash(), data))
+		Log::info("wrote mesh cache {}", MeshCache::getPath(filename));
+}
 
-	if (!success)
+bool Model::loadGltfModel(const std::string& filename, GltfFile& file, tinygltf::Model& model)
+{
+	//buffers are memory mapped, tinygltf only parses the json
+	if (!file.load(filename, model))
+		return false;
+
+	Timer importTimer;
+
+	//only the nodes of the displayed scene, children are reached through their parents.
+	//every referenced mesh is imported once, the nodes using it become its instances
+	std::vector<std::vector<uint32_t>> meshInstances(model.meshes.size());
+	m_sceneGraph.clear();
+	for (int node : getRootNodes(model))
+		loadNode(model, file, node, SceneGraph::invalidNode, meshInstances);
+	m_sceneGraph.update();
+
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	for (size_t mesh = 0; mesh < model.meshes.size(); mesh++)
 	{
-		Log::error("tinygltf error: {}", err);
-		return;
+		if (!meshInstances[mesh].empty())
+			countGeometry(model, model.meshes[mesh], vertexCount, indexCount);
+	}
+	m_vertexBuffer.reserve(vertexCount);
+	m_indexBuffer.reserve(indexCount);
+
+	size_t meshCount = 0;
+	for (size_t mesh = 0; mesh < model.meshes.size(); mesh++)
+	{
+		auto& instances = meshInstances[mesh];
+		if (instances.empty())
+			continue;
+
+		uint32_t firstInstance = static_cast<uint32_t>(m_instanceBuffer.size());
+		m_instanceBuffer.insert(m_instanceBuffer.end(), instances.begin(), instances.end());
+		loadMesh(model, file, model.meshes[mesh], firstInstance, static_cast<uint32_t>(instances.size()));
+		meshCount++;
 	}
 
-	if (!warn.empty())
-		Log::warn("tinygltf warning: {}", warn);
+	double importTime = importTimer.elapsedMs();
+	Log::info("imported {} vertices and {} indices from {:.1f} MB of mapped buffers in {:.2f} ms, {:.1f} M vertices/s", m_vertexBuffer.size(),
+		m_indexBuffer.size(), file.getMappedSize() / (1024.0 * 1024.0), importTime, m_vertexBuffer.size() / std::max(importTime, 0.001) / 1000.0);
+	Log::info("{} meshes with {} instances", meshCount, m_instanceBuffer.size());
+
+	if (m_options.optimizeMeshes)
+		optimizeMeshes();
 
-	for (auto& node : model.nodes)
-		loadNode(model, node);
+	computeBounds();
+	buildLods();
 
-	loadTextures(model);
-	loadMaterials(model);
-	Log::info("loaded gltf model: {} vertices and {} indices", m_vertexBuffer.size(), m_indexBuffer.size());
+	m_vertices = m_vertexBuffer;
+	m_indices = m_indexBuffer;
+	buildMeshlets();
+	m_primitives = m_mesh;
+	m_meshlets = m_meshletBuffer;
+	m_lods = m_lodBuffer;
+	m_instances = m_instanceBuffer;
+
+	loadTextureReferences(model);
+	loadMaterialReferences(model);
+	return true;
 }
 
-void Model::loadTextures(tinygltf::Model& model)
+void Model::loadTextureReferences(tinygltf::Model& model)
 {
 	std::set<int> normalTextureIndices;
 	for (auto& gltfMaterial : model.materials)
@@ -76,11 +302,7 @@ void Model::loadTextures(tinygltf::Model& model)
 	}
 
 	for (auto& gltfSampler : model.samplers)
-	{
-		std::shared_ptr<Sampler> sampler = std::make_shared<Sampler>();
-		sampler->create(filterMap[gltfSampler.magFilter], addressMap[gltfSampler.wrapS]);
-		m_samplers.emplace_back(std::move(sampler));
-	}
+		m_samplerReferences.push_back({ gltfSampler.magFilter, gltfSampler.wrapS });
 
 	int i = 0;
 	for (auto& gltfTexture : model.textures)
@@ -91,31 +313,173 @@ void Model::loadTextures(tinygltf::Model& model)
 		if (normalTextureIndices.find(i++) != normalTextureIndices.end())
 			format = vk::Format::eR8G8B8A8Unorm;
 
-		Texture texture;
-		texture.setSampler(m_samplers[gltfTexture.sampler]);
-		texture.create("res/models/Sponza/glTF/" + model.images[gltfTexture.source].uri, format);
-		m_textures.emplace_back(texture);
+		m_textureReferences.push_back({ model.images[gltfTexture.source].uri, format, gltfTexture.sampler });
 	}
 }
 
-void Model::loadMaterials(tinygltf::Model& model)
+void Model::loadMaterialReferences(tinygltf::Model& model)
 {
-	if (m_textures.empty())
+	if (m_textureReferences.empty())
 		return;
 
 	for (auto& gltfMaterial : model.materials)
 	{
-		size_t lastTextureIndex = m_textures.size() == 0 ? 0 : m_textures.size() - 1;
+		int lastTextureIndex = static_cast<int>(m_textureReferences.size()) - 1;
 		auto textureInfo = gltfMaterial.pbrMetallicRoughness;
 
-		int albedoTexIndex			  = (textureInfo.baseColorTexture.index == -1 ? lastTextureIndex : textureInfo.baseColorTexture.index);
-		int metallicRoughnessTexIndex = (textureInfo.metallicRoughnessTexture.index == -1 ? lastTextureIndex : textureInfo.metallicRoughnessTexture.index);
-		int normalTexIndex			  = (gltfMaterial.normalTexture.index == -1 ? lastTextureIndex : gltfMaterial.normalTexture.index);
+		MaterialReference material;
+		material.albedo			   = (textureInfo.baseColorTexture.index == -1 ? lastTextureIndex : textureInfo.baseColorTexture.index);
+		material.metallicRoughness = (textureInfo.metallicRoughnessTexture.index == -1 ? lastTextureIndex : textureInfo.metallicRoughnessTexture.index);
+		material.normal			   = (gltfMaterial.normalTexture.index == -1 ? lastTextureIndex : gltfMaterial.normalTexture.index);
+		material.baseColorFactor = glm::vec4(glm::make_vec4(textureInfo.baseColorFactor.data()));
+		material.metallicFactor = static_cast<float>(textureInfo.metallicFactor);
+		material.roughnessFactor = static_cast<float>(textureInfo.roughnessFactor);
+		m_materialReferences.push_back(material);
+	}
+}
+
+void Model::createTextures()
+{
+	for (auto& reference : m_samplerReferences)
+	{
+		std::shared_ptr<Sampler> sampler = std::make_shared<Sampler>();
+		sampler->create(filterMap[reference.magFilter], addressMap[reference.wrapS]);
+		m_samplers.emplace_back(std::move(sampler));
+	}
+
+	//sized up front, materials keep pointers into it while textures are still streaming in
+	m_textures.resize(m_textureReferences.size());
+	m_decodedTextures.resize(m_textureReferences.size());
+	m_nextTexture = 0;
+	m_textureDecodeTime = 0.0;
+	m_textureBatches = 0;
+	m_textureBytes = 0;
+	m_textureTimer.reset();
+
+	//decode on the pool, the main thread only creates the images and records the copies as decodes finish
+	m_texturePool = std::make_unique<ThreadPool>(m_options.textureThreadCount);
+	for (size_t i = 0; i < m_textureReferences.size(); i++)
+	{
+		std::string path = m_directory + m_textureReferences[i].uri;
+		if (m_options.useCompressedTextures)
+		{
+			std::string baked = std::filesystem::path(path).replace_extension(".ktx2").string();
+			if (std::filesystem::exists(baked))
+				path = baked;
+		}
+
+		vk::Format format = m_textureReferences[i].format;
+		MipMode mipMode = m_options.generateMips ? Texture::getMipMode(format) : MipMode::eNone;
+		bool srgb = format == vk::Format::eR8G8B8A8Srgb;
+
+		TextureData* decoded = &m_decodedTextures[i];
+		m_decodeTasks.push_back(m_texturePool->submit([decoded, path, mipMode, srgb]()
+		{
+			*decoded = Texture::decode(path, mipMode, srgb);
+			Log::trace("decoded {} ({}x{}) in {:.2f} ms", path, decoded->width, decoded->height, decoded->decodeTime);
+		}));
+	}
+
+	if (m_options.streamTextures)
+		return;
+
+	//all copies go into a few large batches, submitting early lets the staging ring recycle while decoding continues
+	auto& upload = Renderer::getUploadContext();
+	while (m_nextTexture < m_textures.size())
+	{
+		m_decodeTasks[m_nextTexture].wait();
+		createTexture(m_nextTexture++);
+
+		if (upload.getRecordedSize() >= upload.getStagingCapacity() / 2)
+		{
+			upload.submit();
+			m_textureBatches++;
+		}
+	}
+
+	upload.flush();
+	m_textureBatches++;
+	finishStreaming();
+}
+
+void Model::updateStreaming()
+{
+	if (!m_texturePool)
+		return;
+
+	//textures are created in order, stop at the first one still decoding
+	auto& upload = Renderer::getUploadContext();
+	vk::DeviceSize recorded = 0;
+	while (m_nextTexture < m_textures.size() && recorded < m_options.streamingBudget)
+	{
+		auto& task = m_decodeTasks[m_nextTexture];
+		if (task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			break;
+
+		recorded += m_decodedTextures[m_nextTexture].staging.size;
+		createTexture(m_nextTexture++);
+	}
+
+	if (recorded > 0)
+	{
+		upload.submit();
+		m_textureBatches++;
+	}
+
+	if (m_nextTexture == m_textures.size())
+		finishStreaming();
+}
+
+void Model::createTexture(size_t index)
+{
+	auto& reference = m_textureReferences[index];
+	auto& texture = m_textures[index];
+	auto& decoded = m_decodedTextures[index];
+
+	if (reference.sampler >= 0)
+		texture.setSampler(m_samplers[reference.sampler]);
+	texture.setName(reference.uri);
+	texture.create(decoded, reference.format);
+
+	m_textureDecodeTime += decoded.decodeTime;
+	m_textureBytes += decoded.staging.size;
+	decoded = {};
+}
+
+void Model::finishStreaming()
+{
+	Log::info("created {} textures on {} threads in {:.2f} ms ({:.2f} ms of decoding, {:.1f} MB in {} upload batches)",
+		m_textures.size(), m_texturePool->getThreadCount(), m_textureTimer.elapsedMs(), m_textureDecodeTime,
+		m_textureBytes / (1024.0 * 1024.0), m_textureBatches);
 
+	m_texturePool.reset();
+	m_decodeTasks.clear();
+	m_decodedTextures.clear();
+}
+
+bool Model::isMaterialReady(size_t index) const
+{
+	if (index >= m_materials.size())
+		return false;
+
+	auto& material = m_materials[index];
+	return material.albedo->isAvailable() && material.normal->isAvailable() && material.metallicRoughness->isAvailable();
+}
+
+void Model::createMaterials()
+{
+	for (auto& reference : m_materialReferences)
+	{
 		Material material;
-		material.albedo = &m_textures[albedoTexIndex];
-		material.normal = &m_textures[normalTexIndex];
-		material.metallicRoughness = &m_textures[metallicRoughnessTexIndex];
+		material.albedo = &m_textures[reference.albedo];
+		material.normal = &m_textures[reference.normal];
+		material.metallicRoughness = &m_textures[reference.metallicRoughness];
+		material.albedoIndex = reference.albedo;
+		material.normalIndex = reference.normal;
+		material.metallicRoughnessIndex = reference.metallicRoughness;
+		material.baseColorFactor = reference.baseColorFactor;
+		material.metallicFactor = reference.metallicFactor;
+		material.roughnessFactor = reference.roughnessFactor;
 		material.emissive = nullptr;
 		material.occlusion = nullptr;
 		m_materials.emplace_back(material);
@@ -124,130 +488,398 @@ void Model::loadMaterials(tinygltf::Model& model)
 	Log::info("mat size: {}", m_materials.size());
 }
 
-void Model::loadNode(tinygltf::Model& model, tinygltf::Node& node)
+void Model::setMaxLod(float maxLod)
 {
-	if (node.translation.size() == 3)
+	std::set<Sampler*> samplers;
+	for (auto& texture : m_textures)
 	{
-		glm::vec3 translation = glm::make_vec3(node.translation.data());
-		m_translation = glm::translate(glm::mat4(1.0f), translation);
+		if (texture.getImage().getView())
+			samplers.insert(&texture.getSampler());
 	}
 
-	if (node.rotation.size() == 4)
-		m_rotation = glm::mat4(glm::quat(glm::make_vec4(node.rotation.data())));
+	for (Sampler* sampler : samplers)
+		sampler->setMaxLod(maxLod);
+}
 
-	if (node.scale.size() == 3)
+void Model::setVertexFormat(VertexFormat format)
+{
+	m_options.vertexFormat = format;
+	m_positionDequantization = {};
+
+	if (format == VertexFormat::eQuantized)
+		m_positionDequantization = utils::computePositionDequantization(m_vertices);
+}
+
+void Model::selectIndexType()
+{
+	bool fits = m_options.shortIndices;
+	for (auto& primitive : m_primitives)
+		fits = fits && primitive.vertexCount <= 65536;
+
+	m_indexType = fits ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
+
+size_t Model::getIndexStreamSize() const
+{
+	return m_indices.size() * (m_indexType == vk::IndexType::eUint16 ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+void Model::writeIndexStream(uint8_t* destination) const
+{
+	if (m_indexType == vk::IndexType::eUint16)
+		utils::narrowIndices(m_indices.data(), m_indices.size(), reinterpret_cast<uint16_t*>(destination));
+	else
+		memcpy(destination, m_indices.data(), m_indices.sizeBytes());
+}
+
+size_t Model::getVertexStreamSize() const
+{
+	return m_vertices.size() * (m_options.vertexFormat == VertexFormat::eQuantized ? sizeof(QuantizedVertex) : sizeof(Vertex));
+}
+
+void Model::writeVertexStream(uint8_t* destination) const
+{
+	if (m_options.vertexFormat == VertexFormat::eQuantized)
+		utils::quantizeVertices(m_vertices, m_positionDequantization, reinterpret_cast<QuantizedVertex*>(destination));
+	else
+		memcpy(destination, m_vertices.data(), m_vertices.sizeBytes());
+}
+
+void Model::releaseGeometry()
+{
+	if (!m_meshCache.isOpen())
+	{
+		m_vertices = {};
+		m_indices = {};
+	}
+
+	m_vertexBuffer.clear();
+	m_vertexBuffer.shrink_to_fit();
+	m_indexBuffer.clear();
+	m_indexBuffer.shrink_to_fit();
+}
+
+VertexDescription Model::getVertexDescription() const
+{
+	if (m_options.vertexFormat == VertexFormat::eQuantized)
+		return QuantizedVertex::getDescription();
+
+	return Vertex::getDescription();
+}
+
+uint64_t Model::getOptionsHash() const
+{
+	//only options that change the imported data belong in here
+	uint64_t hash = utils::hashValue(m_options.optimizeMeshes);
+	hash = utils::hashValue(m_options.lodCount, hash);
+	hash = utils::hashValue(m_options.lodReduction, hash);
+	return utils::hashValue(m_options.lodMaxError, hash);
+}
+
+void Model::loadNode(const tinygltf::Model& model, const GltfFile& file, int nodeIndex, uint32_t parent, std::vector<std::vector<uint32_t>>& meshInstances)
+{
+	const tinygltf::Node& node = model.nodes[nodeIndex];
+
+	SceneNode sceneNode;
+	sceneNode.parent = parent;
+	sceneNode.translation = glm::vec3(0.0f);
+	sceneNode.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	sceneNode.scale = glm::vec3(1.0f);
+
+	if (node.matrix.size() == 16)
 	{
-		glm::vec3 scale = glm::make_vec3(node.scale.data());
-		m_scale = glm::scale(glm::mat4(1.0f), scale);
+		//split into trs so the node can still be animated, shear is not supported
+		glm::mat4 matrix = glm::make_mat4(node.matrix.data());
+		sceneNode.translation = glm::vec3(matrix[3]);
+		sceneNode.scale = { glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])) };
+		glm::mat3 rotation(glm::vec3(matrix[0]) / sceneNode.scale.x, glm::vec3(matrix[1]) / sceneNode.scale.y, glm::vec3(matrix[2]) / sceneNode.scale.z);
+		sceneNode.rotation = glm::quat_cast(rotation);
 	}
 
-	if (!node.children.empty())
-		for (int i = 0; i < node.children.size(); i++)
-			loadNode(model, model.nodes[node.children[i]]);
+	if (node.translation.size() == 3)
+		sceneNode.translation = glm::make_vec3(node.translation.data());
+
+	//gltf stores x, y, z, w
+	if (node.rotation.size() == 4)
+		sceneNode.rotation = glm::quat(static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]),
+			static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2]));
+
+	if (node.scale.size() == 3)
+		sceneNode.scale = glm::make_vec3(node.scale.data());
+
+	uint32_t graphNode = m_sceneGraph.addNode(sceneNode);
 
-	m_modelMatrix = m_translation * m_rotation * m_scale;
+	for (int child : node.children)
+		loadNode(model, file, child, graphNode, meshInstances);
 
 	if (node.mesh < 0)
+		return;
+
+	auto instancing = node.extensions.find("EXT_mesh_gpu_instancing");
+	if (instancing != node.extensions.end())
+		loadInstances(model, file, instancing->second, graphNode, meshInstances[node.mesh]);
+	else
+		meshInstances[node.mesh].push_back(graphNode);
+}
+
+void Model::loadInstances(const tinygltf::Model& model, const GltfFile& file, const tinygltf::Value& extension, uint32_t parent, std::vector<uint32_t>& instances)
+{
+	//every instance becomes a child of the node, so it is placed by the scene graph like any other node
+	const tinygltf::Value& attributes = extension.Get("attributes");
+	auto getAccessor = [&](const char* name) -> const tinygltf::Accessor*
+	{
+		if (!attributes.Has(name))
+			return nullptr;
+
+		int index = attributes.Get(name).GetNumberAsInt();
+		if (index < 0 || index >= static_cast<int>(model.accessors.size()) || model.accessors[index].bufferView < 0)
+			return nullptr;
+		return &model.accessors[index];
+	};
+
+	const tinygltf::Accessor* translations = getAccessor("TRANSLATION");
+	const tinygltf::Accessor* rotations = getAccessor("ROTATION");
+	const tinygltf::Accessor* scales = getAccessor("SCALE");
+
+	size_t count = ~size_t(0);
+	for (auto* accessor : { translations, rotations, scales })
+	{
+		if (accessor)
+			count = std::min(count, accessor->count);
+	}
+
+	if (count == ~size_t(0))
 	{
-		Log::error("node has no mesh");
+		Log::warn("EXT_mesh_gpu_instancing without attributes, the node is drawn once");
+		instances.push_back(parent);
 		return;
 	}
 
-	const tinygltf::Mesh mesh = model.meshes[node.mesh];
+	for (size_t i = 0; i < count; i++)
+	{
+		SceneNode instance;
+		instance.parent = parent;
+		instance.translation = translations ? glm::vec3(readAccessor(model, file, *translations, i)) : glm::vec3(0.0f);
+		instance.scale = scales ? glm::vec3(readAccessor(model, file, *scales, i)) : glm::vec3(1.0f);
+		instance.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		if (rotations)
+		{
+			glm::vec4 rotation = readAccessor(model, file, *rotations, i);
+			instance.rotation = glm::normalize(glm::quat(rotation.w, rotation.x, rotation.y, rotation.z));
+		}
+
+		instances.push_back(m_sceneGraph.addNode(instance));
+	}
+}
+
+void Model::loadMesh(const tinygltf::Model& model, const GltfFile& file, const tinygltf::Mesh& mesh, uint32_t firstInstance, uint32_t instanceCount)
+{
 	for (auto& primitive : mesh.primitives)
 	{
 		if (primitive.indices < 0)
 			continue;
 
+		const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
+		uint32_t indexSize = static_cast<uint32_t>(tinygltf::GetComponentSizeInBytes(indexAccessor.componentType));
+		if (indexAccessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT && indexAccessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT &&
+			indexAccessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE)
+		{
+			Log::error("Index component type, {}, not supported!", indexAccessor.componentType);
+			continue;
+		}
+
+		auto positionAttribute = primitive.attributes.find("POSITION");
+		if (positionAttribute == primitive.attributes.end())
+			continue;
+
 		uint32_t firstIndex = static_cast<uint32_t>(m_indexBuffer.size());
 		uint32_t vertexStart = static_cast<uint32_t>(m_vertexBuffer.size());
-		uint32_t indexCount = 0;
+		uint32_t indexCount = static_cast<uint32_t>(indexAccessor.count);
+		size_t vertexCount = model.accessors[positionAttribute->second].count;
 
-		//vertices
-		const float* positionBuffer = nullptr;
-		const float* normalsBuffer = nullptr;
-		const float* texCoordsBuffer = nullptr;
-		const float* tangentsBuffer = nullptr;
-		size_t vertexCount = 0;
+		//vertices, every attribute is copied straight from its accessor into the interleaved array
+		m_vertexBuffer.resize(vertexStart + vertexCount, { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f), glm::vec4(0.0f) });
+		uint8_t* vertices = reinterpret_cast<uint8_t*>(&m_vertexBuffer[vertexStart]);
 
-		if (primitive.attributes.find("POSITION") != primitive.attributes.end())
+		auto copyAttribute = [&](const char* name, size_t offset, uint32_t components, bool normalize)
 		{
-			const tinygltf::Accessor& accessor = model.accessors[primitive.attributes.find("POSITION")->second];
-			const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-			positionBuffer = reinterpret_cast<const float*>(&(model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-			vertexCount = accessor.count;
-		}
+			auto attribute = primitive.attributes.find(name);
+			if (attribute == primitive.attributes.end())
+				return;
+
+			const tinygltf::Accessor& accessor = model.accessors[attribute->second];
+			if (accessor.componentType != TINYGLTF_PARAMETER_TYPE_FLOAT || accessor.count < vertexCount)
+			{
+				Log::warn("{} accessor {} is not a float accessor with {} elements, ignored", name, attribute->second, vertexCount);
+				return;
+			}
+
+			size_t stride = 0;
+			const uint8_t* source = getAccessorData(model, file, accessor, stride);
+			if (normalize)
+				utils::copyNormalized(source, stride, vertexCount, vertices + offset, sizeof(Vertex));
+			else
+				utils::copyFloats(source, stride, components, vertexCount, vertices + offset, sizeof(Vertex));
+		};
+
+		copyAttribute("POSITION", offsetof(Vertex, position), 3, false);
+		copyAttribute("NORMAL", offsetof(Vertex, normal), 3, true);
+		copyAttribute("TEXCOORD_0", offsetof(Vertex, texCoord), 2, false);
+		copyAttribute("TANGENT", offsetof(Vertex, tangent), 4, false);
+
+		//indices stay relative to the primitive, draws pass firstVertex as vertexOffset
+		size_t indexStride = 0;
+		m_indexBuffer.resize(firstIndex + indexCount);
+		utils::widenIndices(getAccessorData(model, file, indexAccessor, indexStride), indexSize, indexCount, &m_indexBuffer[firstIndex]);
 
-		if (primitive.attributes.find("NORMAL") != primitive.attributes.end())
-		{
-			const tinygltf::Accessor& accessor = model.accessors[primitive.attributes.find("NORMAL")->second];
-			const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-			normalsBuffer = reinterpret_cast<const float*>(&(model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-		}
+		Primitive prim;
+		prim.firstIndex = firstIndex;
+		prim.indexCount = indexCount;
+		prim.materialIndex = primitive.material;
+		prim.firstInstance = firstInstance;
+		prim.instanceCount = instanceCount;
+		prim.firstVertex = vertexStart;
+		prim.vertexCount = static_cast<uint32_t>(vertexCount);
+		prim.firstMeshlet = 0;
+		prim.meshletCount = 0;
+		prim.firstLod = 0;
+		prim.lodCount = 0;
+		prim.center = glm::vec3(0.0f);
+		prim.radius = 0.0f;
+		prim.boundsMin = glm::vec3(0.0f);
+		prim.boundsMax = glm::vec3(0.0f);
+		m_mesh.push_back(prim);
+	}
+}
 
-		if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end())
-		{
-			const tinygltf::Accessor& accessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
-			const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-			texCoordsBuffer = reinterpret_cast<const float*>(&(model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-		}
+void Model::optimizeMeshes()
+{
+	Timer timer;
+	size_t triangles = 0;
+	size_t verticesBefore = m_vertexBuffer.size();
+	size_t transformedBefore = 0;
+	size_t transformedAfter = 0;
+
+	//primitives own disjoint vertex ranges, so each one is optimized on its own and compacted into a new buffer
+	std::vector<Vertex> vertexBuffer;
+	vertexBuffer.reserve(m_vertexBuffer.size());
+	std::vector<Vertex> vertices;
+
+	for (auto& primitive : m_mesh)
+	{
+		uint32_t* indices = m_indexBuffer.data() + primitive.firstIndex;
+		vertices.assign(m_vertexBuffer.begin() + primitive.firstVertex, m_vertexBuffer.begin() + primitive.firstVertex + primitive.vertexCount);
+		transformedBefore += utils::analyzeVertexCache(indices, primitive.indexCount, vertices.size()).transformedVertices;
 
-		if (primitive.attributes.find("TANGENT") != primitive.attributes.end())
-		{
-			const tinygltf::Accessor& accessor = model.accessors[primitive.attributes.find("TANGENT")->second];
-			const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-			tangentsBuffer = reinterpret_cast<const float*>(&(model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-		}
+		utils::optimizeVertexCache(indices, primitive.indexCount, vertices.size());
+		utils::optimizeOverdraw(indices, primitive.indexCount, vertices.data(), vertices.size());
+		utils::optimizeVertexFetch(vertices, indices, primitive.indexCount);
 
-		for (size_t v = 0; v < vertexCount; v++)
-		{
-			Vertex vertex;
-			vertex.position = glm::make_vec3(&positionBuffer[v * 3]);
-			vertex.normal = glm::normalize(normalsBuffer ? glm::make_vec3(&normalsBuffer[v * 3]) : glm::vec3(0.0f));
-			vertex.texCoord = texCoordsBuffer ? glm::make_vec2(&texCoordsBuffer[v * 2]) : glm::vec2(0.0f);
-			vertex.tangent = tangentsBuffer ? glm::make_vec4(&tangentsBuffer[v * 4]) : glm::vec4(0.0f);
-			m_vertexBuffer.push_back(vertex);
-		}
+		auto stats = utils::analyzeVertexCache(indices, primitive.indexCount, vertices.size());
+		transformedAfter += stats.transformedVertices;
+		triangles += primitive.indexCount / 3;
+		Log::trace("primitive {}: acmr {:.3f}, atvr {:.3f}", &primitive - m_mesh.data(), stats.acmr, stats.atvr);
 
-		//indices
-		const tinygltf::Accessor& accessor = model.accessors[primitive.indices];
-		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-		const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+		primitive.firstVertex = static_cast<uint32_t>(vertexBuffer.size());
+		primitive.vertexCount = static_cast<uint32_t>(vertices.size());
 
-		indexCount += static_cast<uint32_t>(accessor.count);
+		vertexBuffer.insert(vertexBuffer.end(), vertices.begin(), vertices.end());
+	}
 
-		switch (accessor.componentType)
-		{
-		case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
-		{
-			const uint32_t* buf = reinterpret_cast<const uint32_t*>(&buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-			for (size_t index = 0; index < accessor.count; index++)
-				m_indexBuffer.push_back(buf[index] + vertexStart);
-			break;
-		}
-		case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+	m_vertexBuffer = std::move(vertexBuffer);
+
+	//acmr is averaged over all triangles, atvr over the vertices each side had, compaction drops unreferenced ones
+	double triangleCount = std::max<double>(static_cast<double>(triangles), 1.0);
+	double vertexCountBefore = std::max<double>(static_cast<double>(verticesBefore), 1.0);
+	double vertexCountAfter = std::max<double>(static_cast<double>(m_vertexBuffer.size()), 1.0);
+	Log::info("optimized {} triangles in {:.2f} ms: acmr {:.3f} -> {:.3f}, atvr {:.3f} -> {:.3f}, {} -> {} vertices",
+		triangles, timer.elapsedMs(), transformedBefore / triangleCount, transformedAfter / triangleCount,
+		transformedBefore / vertexCountBefore, transformedAfter / vertexCountAfter, verticesBefore, m_vertexBuffer.size());
+}
+
+void Model::buildMeshlets()
+{
+	//runs after optimizeMeshes(), so meshlets follow the cache and overdraw friendly triangle order
+	m_meshletBuffer.clear();
+	for (auto& primitive : m_mesh)
+	{
+		primitive.firstMeshlet = static_cast<uint32_t>(m_meshletBuffer.size());
+		DataView<Vertex> vertices(m_vertices.data() + primitive.firstVertex, primitive.vertexCount);
+		utils::buildMeshlets(m_indices, primitive.firstIndex, primitive.indexCount, vertices, m_meshletBuffer);
+		primitive.meshletCount = static_cast<uint32_t>(m_meshletBuffer.size()) - primitive.firstMeshlet;
+	}
+
+	Log::info("built {} meshlets for {} primitives", m_meshletBuffer.size(), m_mesh.size());
+}
+
+void Model::computeBounds()
+{
+	for (auto& primitive : m_mesh)
+	{
+		if (primitive.vertexCount == 0)
+			continue;
+
+		auto first = m_vertexBuffer.begin() + primitive.firstVertex;
+		auto last = first + primitive.vertexCount;
+
+		glm::vec3 minPosition = first->position;
+		glm::vec3 maxPosition = first->position;
+		for (auto it = first; it != last; ++it)
 		{
-			const uint16_t* buf = reinterpret_cast<const uint16_t*>(&buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-			for (size_t index = 0; index < accessor.count; index++)
-				m_indexBuffer.push_back(buf[index] + vertexStart);
-			break;
+			minPosition = glm::min(minPosition, it->position);
+			maxPosition = glm::max(maxPosition, it->position);
 		}
-		case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
+
+		primitive.boundsMin = minPosition;
+		primitive.boundsMax = maxPosition;
+		primitive.center = (minPosition + maxPosition) * 0.5f;
+		primitive.radius = 0.0f;
+		for (auto it = first; it != last; ++it)
+			primitive.radius = std::max(primitive.radius, glm::length(it->position - primitive.center));
+	}
+}
+
+void Model::buildLods()
+{
+	//levels are appended behind all original indices and share the vertices of their primitive
+	Timer timer;
+	m_lodBuffer.clear();
+	size_t baseIndexCount = m_indexBuffer.size();
+	std::vector<uint32_t> indices;
+
+	for (auto& primitive : m_mesh)
+	{
+		primitive.firstLod = static_cast<uint32_t>(m_lodBuffer.size());
+		m_lodBuffer.push_back({ primitive.firstIndex, primitive.indexCount, 0.0f });
+
+		indices.assign(m_indexBuffer.begin() + primitive.firstIndex, m_indexBuffer.begin() + primitive.firstIndex + primitive.indexCount);
+
+		float maxError = m_options.lodMaxError * primitive.radius;
+		for (uint32_t level = 0; level < m_options.lodCount; level++)
 		{
-			const uint8_t* buf = reinterpret_cast<const uint8_t*>(&buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-			for (size_t index = 0; index < accessor.count; index++)
-				m_indexBuffer.push_back(buf[index] + vertexStart);
-			break;
-		}
-		default:
-			Log::error("Index component type, {}, not supported!", accessor.componentType);
-			return;
+			size_t target = static_cast<size_t>(indices.size() * m_options.lodReduction) / 3 * 3;
+			float error = 0.0f;
+			auto simplified = utils::simplifyMesh(indices.data(), indices.size(), &m_vertexBuffer[primitive.firstVertex], primitive.vertexCount, target, maxError, &error);
+
+			//a level that barely shrinks costs memory without saving any work
+			if (simplified.empty() || simplified.size() > indices.size() * 9 / 10)
+				break;
+
+			indices = std::move(simplified);
+			utils::optimizeVertexCache(indices.data(), indices.size(), primitive.vertexCount);
+
+			MeshLod lod;
+			lod.firstIndex = static_cast<uint32_t>(m_indexBuffer.size());
+			lod.indexCount = static_cast<uint32_t>(indices.size());
+			//each level is simplified from the previous one, so the errors add up
+			lod.error = m_lodBuffer.back().error + error;
+			m_lodBuffer.push_back(lod);
+
+			m_indexBuffer.insert(m_indexBuffer.end(), indices.begin(), indices.end());
 		}
 
-		Primitive prim;
-		prim.firstIndex = firstIndex;
-		prim.indexCount = indexCount;
-		prim.materialIndex = primitive.material;
-		m_mesh.push_back(prim);
+		primitive.lodCount = static_cast<uint32_t>(m_lodBuffer.size()) - primitive.firstLod;
 	}
+
+	Log::info("built {} lods in {:.2f} ms, {} additional indices", m_lodBuffer.size() - m_mesh.size(), timer.elapsedMs(), m_indexBuffer.size() - baseIndexCount);
 }
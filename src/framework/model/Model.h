@@ -1,19 +1,48 @@
 #pragma once
 
 #include "Vertex.h"
+#include "Primitive.h"
+#include "MeshCache.h"
+#include "VertexQuantization.h"
+#include "GltfFile.h"
 #include "framework/image/Texture.h"
 #include "framework/image/Sampler.h"
 #include "framework/Material.h"
+#include "framework/utils/DataView.h"
+#include "framework/utils/ThreadPool.h"
+#include "framework/utils/Timer.h"
+#include "framework/scene/SceneGraph.h"
 
+#include <memory>
 #include <string>
 #include <tiny_gltf.h>
 #include <glm/glm.hpp>
 
-struct Primitive
+struct ModelLoadOptions
 {
-	uint32_t firstIndex;
-	uint32_t indexCount;
-	uint32_t materialIndex;
+	bool useMeshCache = true;
+	/// reorders every primitive for the post-transform cache, overdraw and vertex fetch, the result is stored in the mesh cache
+	bool optimizeMeshes = true;
+	/// simplified levels generated per primitive in addition to the original, 0 disables lods
+	uint32_t lodCount = 4;
+	/// index count of each level relative to the previous one
+	float lodReduction = 0.5f;
+	/// largest simplification error allowed for any level, relative to the primitive's bounding radius
+	float lodMaxError = 0.05f;
+	bool loadTextures = true;
+	/// worker threads used to decode textures, 0 uses one per hardware thread
+	uint32_t textureThreadCount = 0;
+	bool generateMips = true;
+	/// use <image>.ktx2 baked by tools/texbake instead of the original image when it exists
+	bool useCompressedTextures = true;
+	/// return before the textures are uploaded, updateStreaming() finishes them while frames are rendered
+	bool streamTextures = false;
+	/// staging bytes recorded per updateStreaming() call
+	vk::DeviceSize streamingBudget = 16 * 1024 * 1024;
+	/// layout of writeVertexStream(), the mesh cache always stores float vertices
+	VertexFormat vertexFormat = VertexFormat::eFloat;
+	/// upload 16 bit indices when no primitive references more than 65536 vertices
+	bool shortIndices = true;
 };
 
 class Model
@@ -23,35 +52,105 @@ public:
 
 	void destroy();
 
-	void loadFromDisk(const std::string& filename);
+	void loadFromDisk(const std::string& filename, const ModelLoadOptions& options = {});
+	/// uploads decoded textures within the streaming budget, call once per frame
+	void updateStreaming();
+	bool isStreaming() const { return m_texturePool != nullptr; }
+	/// true once every texture of the material can be sampled
+	bool isMaterialReady(size_t index) const;
+	/// clamps sampling of every texture to mips [0, maxLod], material descriptors have to be written again
+	void setMaxLod(float maxLod);
+	/// rebuilds the vertex stream, the vertex buffer and pipeline have to be recreated afterwards
+	void setVertexFormat(VertexFormat format);
 
-	const std::vector<uint32_t>& getIndexData() const { return m_indexBuffer; }
-	const std::vector<Vertex>& getVertexData() const { return m_vertexBuffer; }
+	/// primitive relative indices, draws pass Primitive::firstVertex as vertexOffset
+	DataView<uint32_t> getIndexData() const { return m_indices; }
+	/// writes the indices in the layout of getIndexType() to destination, usually mapped buffer memory
+	void writeIndexStream(uint8_t* destination) const;
+	size_t getIndexStreamSize() const;
+	vk::IndexType getIndexType() const { return m_indexType; }
+	DataView<Vertex> getVertexData() const { return m_vertices; }
+	/// writes the vertices in the layout of getVertexFormat() to destination, usually mapped buffer memory
+	void writeVertexStream(uint8_t* destination) const;
+	size_t getVertexStreamSize() const;
+	VertexDescription getVertexDescription() const;
+	VertexFormat getVertexFormat() const { return m_options.vertexFormat; }
+	const PositionDequantization& getPositionDequantization() const { return m_positionDequantization; }
 	const std::vector<Material>& getMaterials() const { return m_materials; }
-	const std::vector<Primitive>& getMesh() const { return m_mesh; }
-	const glm::mat4 getScale() const { return m_scale; }
-	const glm::mat4 getRotation() const { return m_rotation; }
-	const glm::mat4 getTranslation() const { return m_translation; }
-	const glm::mat4 getModelMatrix() const { return m_modelMatrix; }
+	size_t getTextureCount() const { return m_textures.size(); }
+	DataView<Primitive> getMesh() const { return m_primitives; }
+	DataView<Meshlet> getMeshlets() const { return m_meshlets; }
+	DataView<MeshLod> getLods() const { return m_lods; }
+	/// scene graph node of every instance, see Primitive::firstInstance
+	DataView<uint32_t> getInstances() const { return m_instances; }
+	/// frees the imported vertices and indices once they are uploaded. data backed by the mesh cache stays readable,
+	/// otherwise getVertexData() and getIndexData() are empty afterwards and the streams can't be written again
+	void releaseGeometry();
+	/// Primitive::node indexes the nodes of the graph
+	SceneGraph& getSceneGraph() { return m_sceneGraph; }
+	const SceneGraph& getSceneGraph() const { return m_sceneGraph; }
 
 private:
-	void loadGltfModel(const std::string& filename);
-	void loadTextures(tinygltf::Model& model);
-	void loadMaterials(tinygltf::Model& model);
-	void loadNode(tinygltf::Model& model, tinygltf::Node& node);
+	bool loadMeshCache(const std::string& filename);
+	void writeMeshCache(const std::string& filename, const GltfFile& file);
+	bool loadGltfModel(const std::string& filename, GltfFile& file, tinygltf::Model& model);
+	void loadTextureReferences(tinygltf::Model& model);
+	void loadMaterialReferences(tinygltf::Model& model);
+	/// adds the node and its children to the scene graph and records which meshes they instance
+	void loadNode(const tinygltf::Model& model, const GltfFile& file, int nodeIndex, uint32_t parent, std::vector<std::vector<uint32_t>>& meshInstances);
+	void loadInstances(const tinygltf::Model& model, const GltfFile& file, const tinygltf::Value& extension, uint32_t parent, std::vector<uint32_t>& instances);
+	void loadMesh(const tinygltf::Model& model, const GltfFile& file, const tinygltf::Mesh& mesh, uint32_t firstInstance, uint32_t instanceCount);
+	void optimizeMeshes();
+	void buildMeshlets();
+	void computeBounds();
+	void buildLods();
+	void selectIndexType();
+
+	void createTextures();
+	void createTexture(size_t index);
+	void finishStreaming();
+	void createMaterials();
+	uint64_t getOptionsHash() const;
 private:
+	std::string m_directory;
+	ModelLoadOptions m_options;
+	MeshCache m_meshCache;
+
+	std::vector<SamplerReference> m_samplerReferences;
+	std::vector<TextureReference> m_textureReferences;
+	std::vector<MaterialReference> m_materialReferences;
+
 	std::vector<std::shared_ptr<Sampler>> m_samplers;
 	std::vector<Texture> m_textures;
 	std::vector<Material> m_materials;
 
+	//decoding state, only alive until every texture has been uploaded
+	std::unique_ptr<ThreadPool> m_texturePool;
+	std::vector<TextureData> m_decodedTextures;
+	std::vector<std::future<void>> m_decodeTasks;
+	size_t m_nextTexture = 0;
+	Timer m_textureTimer;
+	double m_textureDecodeTime = 0.0;
+	uint32_t m_textureBatches = 0;
+	vk::DeviceSize m_textureBytes = 0;
+
+	//views point either at the vectors below or into the memory mapped mesh cache
+	DataView<Primitive> m_primitives;
+	DataView<uint32_t> m_indices;
+	DataView<Vertex> m_vertices;
+	DataView<Meshlet> m_meshlets;
+	DataView<MeshLod> m_lods;
+	DataView<uint32_t> m_instances;
+
 	std::vector<Primitive> m_mesh;
 	std::vector<uint32_t> m_indexBuffer;
 	std::vector<Vertex> m_vertexBuffer;
+	std::vector<Meshlet> m_meshletBuffer;
+	std::vector<MeshLod> m_lodBuffer;
+	std::vector<uint32_t> m_instanceBuffer;
 
+	SceneGraph m_sceneGraph;
 
-public:
-	glm::mat4 m_translation = glm::mat4(1.f);
-	glm::mat4 m_rotation = glm::mat4(1.f);
-	glm::mat4 m_scale = glm::mat4(1.f);
-	glm::mat4 m_modelMatrix = glm::mat4(1.f);
-};
\ No newline at end of file
+	vk::IndexType m_indexType = vk::IndexType::eUint32;
+	PositionDequantization m_positionDequantization;
+};
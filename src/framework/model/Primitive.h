@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/// simplified version of a primitive, indexes the same vertex range
+struct MeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	//largest distance the simplification moved the surface, in model space
+	float error;
+};
+
+struct Primitive
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t materialIndex;
+	//instances drawing the primitive, Model::getInstances() holds the scene graph node of each one.
+	//all primitives of a gltf mesh share the same range
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+	//vertices referenced by the primitive, indices are relative to firstVertex
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+	//meshlets cover the index range of the primitive in order, see Meshlet.h
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+	//lod 0 is the original index range
+	uint32_t firstLod;
+	uint32_t lodCount;
+	//model space bounding sphere, centered on the bounding box
+	glm::vec3 center;
+	float radius;
+	//model space bounding box
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+};
@@ -0,0 +1,101 @@
+#include "VertexQuantization.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	int16_t toSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	uint16_t toUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	Snorm16x2 encodeDirection(const glm::vec3& direction)
+	{
+		//zero vectors (missing normals or tangents) stay zero
+		if (glm::dot(direction, direction) < 1e-12f)
+			return { 0, 0 };
+
+		glm::vec2 e = utils::octEncode(glm::normalize(direction));
+		return { toSnorm16(e.x), toSnorm16(e.y) };
+	}
+
+	//a zero tangent encodes like +z, so vertices without one are marked with a sign of 0.5 instead of 0 or 1
+	uint16_t getTangentSign(const glm::vec4& tangent)
+	{
+		if (glm::dot(glm::vec3(tangent), glm::vec3(tangent)) < 1e-12f)
+			return 32768;
+		return tangent.w < 0.0f ? 0 : 65535;
+	}
+}
+
+glm::vec2 utils::octEncode(const glm::vec3& n)
+{
+	glm::vec3 v = n / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+	glm::vec2 e(v.x, v.y);
+	if (v.z < 0.0f)
+	{
+		e.x = (1.0f - std::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f);
+		e.y = (1.0f - std::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return e;
+}
+
+glm::vec3 utils::octDecode(const glm::vec2& e)
+{
+	glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+PositionDequantization utils::computePositionDequantization(DataView<Vertex> vertices)
+{
+	glm::vec3 minPosition(INFINITY);
+	glm::vec3 maxPosition(-INFINITY);
+	for (auto& vertex : vertices)
+	{
+		minPosition = glm::min(minPosition, vertex.position);
+		maxPosition = glm::max(maxPosition, vertex.position);
+	}
+
+	if (vertices.empty())
+		minPosition = maxPosition = glm::vec3(0.0f);
+
+	PositionDequantization dequantization;
+	dequantization.offset = glm::vec4(minPosition, 0.0f);
+	dequantization.scale = glm::vec4(maxPosition - minPosition, 1.0f);
+	return dequantization;
+}
+
+void utils::quantizeVertices(DataView<Vertex> vertices, const PositionDequantization& dequantization, QuantizedVertex* destination)
+{
+	glm::vec3 minPosition(dequantization.offset);
+	glm::vec3 extent(dequantization.scale);
+	glm::vec3 invExtent(
+		extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+		extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+		extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const Vertex& vertex = vertices[i];
+		glm::vec3 p = (vertex.position - minPosition) * invExtent;
+
+		//built on the stack and written once, destination may be write combined memory
+		QuantizedVertex q;
+		q.position = { toUnorm16(p.x), toUnorm16(p.y), toUnorm16(p.z), getTangentSign(vertex.tangent) };
+		q.normal = encodeDirection(vertex.normal);
+		q.tangent = encodeDirection(glm::vec3(vertex.tangent));
+		q.texCoord = { glm::packHalf1x16(vertex.texCoord.x), glm::packHalf1x16(vertex.texCoord.y) };
+		destination[i] = q;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Vertex.h"
+#include "framework/utils/DataView.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/// position = offset + quantized * scale, passed to shader.vert through the uniform buffer
+struct PositionDequantization
+{
+	glm::vec4 offset = glm::vec4(0.0f);
+	glm::vec4 scale = glm::vec4(1.0f);
+};
+
+namespace utils
+{
+	/// maps a unit vector to the [-1, 1] square
+	glm::vec2 octEncode(const glm::vec3& n);
+	glm::vec3 octDecode(const glm::vec2& e);
+
+	/// positions are normalized to the bounds of all vertices
+	PositionDequantization computePositionDequantization(DataView<Vertex> vertices);
+	/// destination has room for vertices.size() elements, usually mapped buffer memory
+	void quantizeVertices(DataView<Vertex> vertices, const PositionDequantization& dequantization, QuantizedVertex* destination);
+}
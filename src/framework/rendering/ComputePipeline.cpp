@@ -0,0 +1,47 @@
+#include "ComputePipeline.h"
+
+#include "Pipeline.h"
+#include "../utils/Log.h"
+#include "../Renderer.h"
+
+void ComputePipeline::create(const std::string& shaderFile)
+{
+	vk::PushConstantRange pushConstants;
+	pushConstants.stageFlags = vk::ShaderStageFlagBits::eCompute;
+	pushConstants.offset = 0;
+	pushConstants.size = m_pushConstantSize;
+
+	vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+	pipelineLayoutInfo.setSetLayouts(m_descriptors);
+	if (m_pushConstantSize > 0)
+		pipelineLayoutInfo.setPushConstantRanges(pushConstants);
+
+	m_layout = Renderer::getDeviceHandle().createPipelineLayout(pipelineLayoutInfo);
+	if (!m_layout)
+		Log::critical("failed to create pipeline layout");
+
+	auto shaderModule = Pipeline::loadShader(shaderFile);
+	if (!shaderModule)
+	{
+		Log::error("error in ComputePipeline::create(): missing shader, {} stays without a pipeline", shaderFile);
+		return;
+	}
+
+	vk::ComputePipelineCreateInfo createInfo;
+	createInfo.stage.stage = vk::ShaderStageFlagBits::eCompute;
+	createInfo.stage.module = shaderModule;
+	createInfo.stage.pName = "main";
+	createInfo.layout = m_layout;
+
+	handle = Renderer::getDeviceHandle().createComputePipeline(VK_NULL_HANDLE, createInfo).value;
+	if (!handle)
+		Log::error("error in ComputePipeline::create(): failed to create pipeline for {}", shaderFile);
+
+	Renderer::getDeviceHandle().destroyShaderModule(shaderModule);
+}
+
+void ComputePipeline::destroy()
+{
+	Renderer::getDeviceHandle().destroyPipeline(handle);
+	Renderer::getDeviceHandle().destroyPipelineLayout(m_layout);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <string>
+#include <vector>
+
+class ComputePipeline
+{
+public:
+	ComputePipeline() = default;
+
+	/// path of the spir-v file, handle stays empty if it couldn't be loaded
+	void create(const std::string& shaderFile);
+	void destroy();
+
+	void addDescriptorLayout(vk::DescriptorSetLayout layout) { m_descriptors.push_back(layout); }
+	/// push constants of size bytes at offset 0, call before create()
+	void setPushConstantSize(uint32_t size) { m_pushConstantSize = size; }
+
+	vk::PipelineLayout getLayout() { return m_layout; }
+	vk::Pipeline handle;
+private:
+	vk::PipelineLayout m_layout;
+	std::vector<vk::DescriptorSetLayout> m_descriptors;
+	uint32_t m_pushConstantSize = 0;
+};
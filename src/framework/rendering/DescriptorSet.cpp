@@ -18,7 +18,8 @@ void DescriptorSet::destroy()
     Renderer::getDeviceHandle().destroyDescriptorSetLayout(m_layout);
 }
 
-void DescriptorSet::addBinding(vk::DescriptorType type, vk::Flags<vk::ShaderStageFlagBits> stage, uint32_t binding, uint32_t count)
+void DescriptorSet::addBinding(vk::DescriptorType type, vk::Flags<vk::ShaderStageFlagBits> stage, uint32_t binding, uint32_t count,
+    vk::DescriptorBindingFlags flags)
 {
     //add layout binding
     vk::DescriptorSetLayoutBinding layoutBinding;
@@ -28,6 +29,7 @@ void DescriptorSet::addBinding(vk::DescriptorType type, vk::Flags<vk::ShaderStag
     layoutBinding.stageFlags = stage;
 
     m_bindings.emplace_back(layoutBinding);
+    m_bindingFlags.push_back(flags);
 }
 
 void DescriptorSet::addPoolSize(vk::DescriptorType type, uint32_t count)
@@ -45,6 +47,8 @@ void DescriptorSet::createDescriptorPool()
     vk::DescriptorPoolCreateInfo createInfo;
     createInfo.setPoolSizes(m_sizes);
     createInfo.maxSets = m_maxSets;
+    if (isUpdateAfterBind())
+        createInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
 
     m_pool = Renderer::getDeviceHandle().createDescriptorPool(createInfo);
 }
@@ -54,6 +58,13 @@ void DescriptorSet::createLayout()
     vk::DescriptorSetLayoutCreateInfo createInfo;
     createInfo.setBindings(m_bindings);
 
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo flagsInfo;
+    flagsInfo.setBindingFlags(m_bindingFlags);
+    if (std::any_of(m_bindingFlags.begin(), m_bindingFlags.end(), [](vk::DescriptorBindingFlags flags) { return bool(flags); }))
+        createInfo.pNext = &flagsInfo;
+    if (isUpdateAfterBind())
+        createInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+
     m_layout = Renderer::getDeviceHandle().createDescriptorSetLayout(createInfo);
 }
 
@@ -67,4 +78,10 @@ void DescriptorSet::createDescriptorSets()
     allocInfo.setSetLayouts(layouts);
 
     m_sets = Renderer::getDeviceHandle().allocateDescriptorSets(allocInfo);
+}
+
+bool DescriptorSet::isUpdateAfterBind() const
+{
+    return std::any_of(m_bindingFlags.begin(), m_bindingFlags.end(),
+        [](vk::DescriptorBindingFlags flags) { return bool(flags & vk::DescriptorBindingFlagBits::eUpdateAfterBind); });
 }
\ No newline at end of file
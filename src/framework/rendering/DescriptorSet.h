@@ -14,11 +14,15 @@ public:
 	void create();
 	void destroy();
 
-    void addBinding(vk::DescriptorType type, vk::Flags<vk::ShaderStageFlagBits> stage, uint32_t binding, uint32_t count = 1);
+    /// bindings with eUpdateAfterBind make the whole layout and pool update after bind
+    void addBinding(vk::DescriptorType type, vk::Flags<vk::ShaderStageFlagBits> stage, uint32_t binding, uint32_t count = 1,
+        vk::DescriptorBindingFlags flags = {});
     void addPoolSize(vk::DescriptorType type, uint32_t count);
+    /// number of sets to allocate, call after addPoolSize(). otherwise it is the largest pool size
+    void setSetCount(uint32_t count) { m_maxSets = count; }
 
     template<typename T>
-    void writeDescriptor(const T& descriptor, uint32_t binding, int index);
+    void writeDescriptor(const T& descriptor, uint32_t binding, int index, uint32_t arrayElement = 0);
     /// write descriptor to vk::DescriptorSet i
 
     template<typename T>
@@ -31,18 +35,20 @@ private:
 	void createDescriptorPool();
 	void createLayout();
 	void createDescriptorSets();
+	bool isUpdateAfterBind() const;
 private:
 	vk::DescriptorSetLayout m_layout;
 	vk::DescriptorPool m_pool;
 	std::vector<vk::DescriptorSet> m_sets;
 
 	std::vector<vk::DescriptorSetLayoutBinding> m_bindings;
+	std::vector<vk::DescriptorBindingFlags> m_bindingFlags;
 	std::vector<vk::DescriptorPoolSize> m_sizes;
     uint32_t m_maxSets = 0;
 };
 
 template<typename T>
-void DescriptorSet::writeDescriptor(const T& descriptor, uint32_t binding, int index)
+void DescriptorSet::writeDescriptor(const T& descriptor, uint32_t binding, int index, uint32_t arrayElement)
 {
     if (m_sets.size() == 0)
     {
@@ -56,7 +62,7 @@ void DescriptorSet::writeDescriptor(const T& descriptor, uint32_t binding, int i
     vk::WriteDescriptorSet write;
     write.dstSet = m_sets[index];
     write.dstBinding = binding;
-    write.dstArrayElement = 0;
+    write.dstArrayElement = arrayElement;
     write.descriptorType = descriptor.getDescriptorType();
     write.descriptorCount = 1;
 
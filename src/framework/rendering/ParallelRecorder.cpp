@@ -0,0 +1,111 @@
+#include "ParallelRecorder.h"
+
+#include "../Renderer.h"
+
+#include <algorithm>
+#include <future>
+
+void ParallelRecorder::create(uint32_t threadCount)
+{
+	m_threadPool = std::make_unique<ThreadPool>(threadCount);
+	m_threadCount = m_threadPool->getThreadCount();
+
+	vk::CommandPoolCreateInfo createInfo;
+	createInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+	createInfo.queueFamilyIndex = Renderer::getDevice().findQueueFamilies().graphicsFamily.value();
+
+	m_pools.resize(Device::maxFramesInFlight);
+	for (auto& framePools : m_pools)
+	{
+		framePools.resize(m_threadCount);
+		for (auto& slicePool : framePools)
+			slicePool.pool = Renderer::getDeviceHandle().createCommandPool(createInfo);
+	}
+}
+
+void ParallelRecorder::destroy()
+{
+	//the workers finish their queue before the pools go away
+	m_threadPool.reset();
+
+	for (auto& framePools : m_pools)
+	{
+		for (auto& slicePool : framePools)
+			Renderer::getDeviceHandle().destroyCommandPool(slicePool.pool);
+	}
+	m_pools.clear();
+}
+
+void ParallelRecorder::beginFrame(uint32_t frameIndex)
+{
+	m_frameIndex = frameIndex;
+
+	//resetting the pool resets every buffer allocated from it, which is cheaper than resetting them one by one
+	for (auto& slicePool : m_pools[frameIndex])
+	{
+		Renderer::getDeviceHandle().resetCommandPool(slicePool.pool);
+		slicePool.used = 0;
+	}
+}
+
+vk::CommandBuffer ParallelRecorder::getCommandBuffer(uint32_t slice)
+{
+	SlicePool& slicePool = m_pools[m_frameIndex][slice];
+	if (slicePool.used == slicePool.buffers.size())
+	{
+		vk::CommandBufferAllocateInfo allocInfo;
+		allocInfo.commandPool = slicePool.pool;
+		allocInfo.level = vk::CommandBufferLevel::eSecondary;
+		allocInfo.commandBufferCount = 1;
+		slicePool.buffers.push_back(Renderer::getDeviceHandle().allocateCommandBuffers(allocInfo)[0]);
+	}
+
+	return slicePool.buffers[slicePool.used++];
+}
+
+void ParallelRecorder::record(vk::CommandBuffer primary, RenderPass& renderPass, vk::Framebuffer framebuffer, vk::Extent2D extent,
+	uint32_t count, const RecordFunction& recordSlice)
+{
+	m_sliceCount = std::clamp(count / minSliceSize, 1u, m_threadCount);
+	m_recorded.resize(m_sliceCount);
+
+	vk::CommandBufferInheritanceInfo inheritanceInfo;
+	inheritanceInfo.renderPass = renderPass.handle;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = framebuffer;
+
+	//slice i always uses pool i, so a pool is never touched by two tasks at once
+	std::vector<std::future<void>> tasks;
+	tasks.reserve(m_sliceCount);
+	for (uint32_t slice = 0; slice < m_sliceCount; slice++)
+	{
+		//the first count % sliceCount slices take one item more
+		uint32_t first = slice * (count / m_sliceCount) + std::min(slice, count % m_sliceCount);
+		uint32_t sliceSize = count / m_sliceCount + (slice < count % m_sliceCount ? 1 : 0);
+
+		tasks.push_back(m_threadPool->submit([this, slice, first, sliceSize, extent, &inheritanceInfo, &recordSlice]()
+		{
+			vk::CommandBuffer cmd = getCommandBuffer(slice);
+
+			vk::CommandBufferBeginInfo beginInfo;
+			beginInfo.flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+			cmd.begin(beginInfo);
+
+			//secondary buffers inherit no state from the primary
+			vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f);
+			cmd.setViewport(0, viewport);
+			cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
+
+			recordSlice(cmd, slice, first, sliceSize);
+			cmd.end();
+			m_recorded[slice] = cmd;
+		}));
+	}
+
+	for (auto& task : tasks)
+		task.get();
+
+	//a fixed order, the result doesn't depend on which thread finished first
+	primary.executeCommands(m_recorded);
+}
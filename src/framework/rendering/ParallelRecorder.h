@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "RenderPass.h"
+#include "../utils/ThreadPool.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+/// records a range of items inside a render pass on worker threads. the range is split into one contiguous slice per thread,
+/// each slice is recorded into a secondary command buffer that inherits the render pass and the primary executes them in slice order.
+/// every slice has its own command pool per frame in flight, so no pool is used by two threads and nothing is locked while recording
+class ParallelRecorder
+{
+public:
+	/// cmd is the secondary command buffer of the slice with viewport and scissor set, pipelines and descriptors have to be bound again
+	using RecordFunction = std::function<void(vk::CommandBuffer cmd, uint32_t slice, uint32_t first, uint32_t count)>;
+
+	/// threadCount of 0 uses one thread per hardware thread
+	void create(uint32_t threadCount = 0);
+	void destroy();
+
+	/// resets the pools of the frame, call after Renderer::prepareFrame() waited for the frame's fence
+	void beginFrame(uint32_t frameIndex);
+	/// call inside a render pass begun with vk::SubpassContents::eSecondaryCommandBuffers, returns once every slice was executed.
+	/// can be called more than once per frame, e.g. for a pre-pass and the main pass
+	void record(vk::CommandBuffer primary, RenderPass& renderPass, vk::Framebuffer framebuffer, vk::Extent2D extent,
+		uint32_t count, const RecordFunction& recordSlice);
+
+	uint32_t getThreadCount() const { return m_threadCount; }
+	/// slices of the last record(), at most one per thread, fewer when there are too few items to split
+	uint32_t getSliceCount() const { return m_sliceCount; }
+private:
+	vk::CommandBuffer getCommandBuffer(uint32_t slice);
+private:
+	//below this many items per slice the secondary buffers cost more than they save
+	static constexpr uint32_t minSliceSize = 64;
+
+	struct SlicePool
+	{
+		vk::CommandPool pool;
+		//secondary buffers allocated so far, reused after the pool was reset
+		std::vector<vk::CommandBuffer> buffers;
+		uint32_t used = 0;
+	};
+
+	std::unique_ptr<ThreadPool> m_threadPool;
+	uint32_t m_threadCount = 0;
+	//one pool per slice for every frame in flight
+	std::vector<std::vector<SlicePool>> m_pools;
+	uint32_t m_frameIndex = 0;
+	uint32_t m_sliceCount = 0;
+	std::vector<vk::CommandBuffer> m_recorded;
+};
@@ -19,24 +19,37 @@ void Pipeline::create(RenderPass& renderPass, const std::string& shaderFileLocat
 		Log::critical("failed to create pipeline layout");
 
 	//shaders
-	auto vertShaderModule = loadShader(shaderFileLocation + "vert.spv");
-	auto fragShaderModule = loadShader(shaderFileLocation + "frag.spv");
+	bool depthOnly = m_fragmentShader.empty();
+	auto vertShaderModule = loadShader(shaderFileLocation + m_vertexShader);
+	vk::ShaderModule fragShaderModule = depthOnly ? vk::ShaderModule() : loadShader(shaderFileLocation + m_fragmentShader);
+	if (!vertShaderModule || (!depthOnly && !fragShaderModule))
+	{
+		Log::error("error in Pipeline::create(): missing shaders, {} and {} stay without a pipeline", m_vertexShader, m_fragmentShader);
+		Renderer::getDeviceHandle().destroyShaderModule(vertShaderModule);
+		Renderer::getDeviceHandle().destroyShaderModule(fragShaderModule);
+		return;
+	}
+
+	vk::SpecializationInfo specializationInfo;
+	specializationInfo.setMapEntries(m_specializationEntries);
+	specializationInfo.dataSize = m_specializationData.size() * sizeof(uint32_t);
+	specializationInfo.pData = m_specializationData.data();
 
 	vk::PipelineShaderStageCreateInfo vertShaderStageInfo;
 	vertShaderStageInfo.stage = vk::ShaderStageFlagBits::eVertex;
 	vertShaderStageInfo.module = vertShaderModule;
 	vertShaderStageInfo.pName = "main";
+	vertShaderStageInfo.pSpecializationInfo = &specializationInfo;
 
 	vk::PipelineShaderStageCreateInfo fragShaderStageInfo;
 	fragShaderStageInfo.stage = vk::ShaderStageFlagBits::eFragment;
 	fragShaderStageInfo.module = fragShaderModule;
 	fragShaderStageInfo.pName = "main";
+	fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
 
-	std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages =
-	{
-		vertShaderStageInfo,
-		fragShaderStageInfo,
-	};
+	std::vector<vk::PipelineShaderStageCreateInfo> shaderStages = { vertShaderStageInfo };
+	if (!depthOnly)
+		shaderStages.push_back(fragShaderStageInfo);
 
 	//dynamic state
 	std::vector<vk::DynamicState> dynamicStates =
@@ -63,9 +76,9 @@ void Pipeline::create(RenderPass& renderPass, const std::string& shaderFileLocat
 	//depth
 	vk::PipelineDepthStencilStateCreateInfo depthStencil;
 	depthStencil.depthTestEnable = VK_TRUE;
-	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = m_depthWrite;
 	depthStencil.depthBoundsTestEnable = VK_FALSE;
-	depthStencil.depthCompareOp = vk::CompareOp::eLessOrEqual;
+	depthStencil.depthCompareOp = m_depthCompareOp;
 
 	//viewport
 	vk::Viewport viewport;
@@ -112,6 +125,9 @@ void Pipeline::create(RenderPass& renderPass, const std::string& shaderFileLocat
 										| vk::ColorComponentFlagBits::eG 
 										| vk::ColorComponentFlagBits::eB 
 										| vk::ColorComponentFlagBits::eA;
+	//the color attachment stays in the render pass, it just isn't written
+	if (depthOnly)
+		colorBlendAttachment.colorWriteMask = {};
 	colorBlendAttachment.blendEnable = VK_FALSE;
 	colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eOne;
 	colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eZero;
@@ -147,7 +163,27 @@ void Pipeline::create(RenderPass& renderPass, const std::string& shaderFileLocat
 	handle = Renderer::getDeviceHandle().createGraphicsPipeline(VK_NULL_HANDLE, createInfo).value;
 
 	Renderer::getDeviceHandle().destroyShaderModule(vertShaderModule);
-	Renderer::getDeviceHandle().destroyShaderModule(fragShaderModule);
+	if (!depthOnly)
+		Renderer::getDeviceHandle().destroyShaderModule(fragShaderModule);
+}
+
+void Pipeline::setSpecializationConstant(uint32_t id, uint32_t value)
+{
+	for (size_t i = 0; i < m_specializationEntries.size(); i++)
+	{
+		if (m_specializationEntries[i].constantID == id)
+		{
+			m_specializationData[i] = value;
+			return;
+		}
+	}
+
+	vk::SpecializationMapEntry entry;
+	entry.constantID = id;
+	entry.offset = static_cast<uint32_t>(m_specializationData.size() * sizeof(uint32_t));
+	entry.size = sizeof(uint32_t);
+	m_specializationEntries.push_back(entry);
+	m_specializationData.push_back(value);
 }
 
 void Pipeline::destroy()
@@ -160,8 +196,12 @@ vk::ShaderModule Pipeline::loadShader(const std::string& filename)
 {
 	std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
+	//the spir-v is built from the glsl sources and not part of the repository
 	if (!file.is_open())
-		Log::error("failed to open shader: {}", filename);
+	{
+		Log::critical("error in Pipeline::loadShader(): {} not found, compile the shaders with res/shaders/compile.sh or compile.bat", filename);
+		return {};
+	}
 
 	const size_t fileSize = (size_t)file.tellg();
 	std::vector<char> buffer(fileSize);
@@ -169,6 +209,13 @@ vk::ShaderModule Pipeline::loadShader(const std::string& filename)
 	file.read(buffer.data(), fileSize);
 	file.close();
 
+	constexpr uint32_t spirvMagic = 0x07230203;
+	if (fileSize < sizeof(uint32_t) || fileSize % sizeof(uint32_t) != 0 || *reinterpret_cast<const uint32_t*>(buffer.data()) != spirvMagic)
+	{
+		Log::critical("error in Pipeline::loadShader(): {} is not spir-v", filename);
+		return {};
+	}
+
 	vk::ShaderModuleCreateInfo createInfo;
 	createInfo.codeSize = fileSize;
 	createInfo.pCode = reinterpret_cast<const uint32_t*>(buffer.data());
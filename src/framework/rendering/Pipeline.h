@@ -8,19 +8,34 @@ class Pipeline
 public:
 	Pipeline() = default;
 
+	/// handle stays empty if a shader couldn't be loaded
 	void create(RenderPass& renderPass, const std::string& shaderFileLocation, vk::Extent2D swapChainExtent);
 	void destroy();
 	
 	void setVertexDescriptionInfo(const VertexDescription& vertexDescription) { m_vertexDescription = vertexDescription; }
 	void addDescriptorLayout(vk::DescriptorSetLayout layout) { m_descriptors.push_back(layout); }
+	void clearDescriptorLayouts() { m_descriptors.clear(); }
+	/// specialization constants are applied to every shader stage
+	void setSpecializationConstant(uint32_t id, uint32_t value);
+	/// spir-v files inside the shader location passed to create(), without a fragment shader the pipeline only writes depth
+	void setShaderFiles(const std::string& vertex, const std::string& fragment) { m_vertexShader = vertex; m_fragmentShader = fragment; }
+	/// eLessOrEqual with depth writes by default
+	void setDepthState(vk::CompareOp compareOp, bool write) { m_depthCompareOp = compareOp; m_depthWrite = write; }
 
 	vk::PipelineLayout getLayout() { return m_layout; }
 	vk::Pipeline handle;
-private:
-	vk::ShaderModule loadShader(const std::string& filename);
+
+	/// spir-v file to shader module, the caller destroys it. an empty module if the file is missing or not spir-v
+	static vk::ShaderModule loadShader(const std::string& filename);
 private:
 	vk::PipelineLayout m_layout;
 	VertexDescription m_vertexDescription;
 
 	std::vector<vk::DescriptorSetLayout> m_descriptors = {};
+	std::vector<vk::SpecializationMapEntry> m_specializationEntries = {};
+	std::vector<uint32_t> m_specializationData = {};
+	std::string m_vertexShader = "vert.spv";
+	std::string m_fragmentShader = "frag.spv";
+	vk::CompareOp m_depthCompareOp = vk::CompareOp::eLessOrEqual;
+	bool m_depthWrite = true;
 };
\ No newline at end of file
@@ -2,27 +2,27 @@
 
 #include "../Renderer.h"
 
-void RenderPass::create(vk::Format format)
+void RenderPass::create(vk::Format format, bool clear, bool present)
 {
     vk::AttachmentDescription colorAttachment; 
     colorAttachment.format = format;
     colorAttachment.samples = vk::SampleCountFlagBits::e1;
-    colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    colorAttachment.loadOp = clear ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eLoad;
     colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
     colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
     colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-    colorAttachment.initialLayout = vk::ImageLayout::eUndefined;
-    colorAttachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+    colorAttachment.initialLayout = clear ? vk::ImageLayout::eUndefined : vk::ImageLayout::eColorAttachmentOptimal;
+    colorAttachment.finalLayout = present ? vk::ImageLayout::ePresentSrcKHR : vk::ImageLayout::eColorAttachmentOptimal;
 
     vk::AttachmentDescription depthAttachment;
     depthAttachment.format = Renderer::getDevice().findDepthFormat();
     depthAttachment.samples = vk::SampleCountFlagBits::e1;
-    depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    depthAttachment.loadOp = clear ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eLoad;
     depthAttachment.storeOp = vk::AttachmentStoreOp::eStore;
     //depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
     depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
     depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-    depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
+    depthAttachment.initialLayout = clear ? vk::ImageLayout::eUndefined : vk::ImageLayout::eDepthStencilAttachmentOptimal;
     depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
 
     vk::AttachmentReference colorAttachmentRef;
@@ -47,12 +47,17 @@ void RenderPass::create(vk::Format format)
                             | vk::PipelineStageFlagBits::eLateFragmentTests;
 
     dependency.srcAccessMask = vk::AccessFlagBits::eNone;
+    //loaded attachments have to wait for the writes of the earlier pass
+    if (!clear)
+        dependency.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
 
     dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput 
                             | vk::PipelineStageFlagBits::eEarlyFragmentTests 
                             | vk::PipelineStageFlagBits::eLateFragmentTests;
 
     dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+    if (!clear)
+        dependency.dstAccessMask |= vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentRead;
 
     std::vector<vk::AttachmentDescription> attachments = { colorAttachment, depthAttachment };
     std::vector<vk::SubpassDescription> subpasses = { subpass };
@@ -7,7 +7,9 @@ class RenderPass
 public:
 	RenderPass() = default;
 
-	void create(vk::Format format);
+	/// a pass that doesn't clear continues the attachments of an earlier pass, one that doesn't present leaves the color attachment to a later pass.
+	/// every combination is compatible with the same framebuffers
+	void create(vk::Format format, bool clear = true, bool present = true);
 	void destroy();
 
 	vk::RenderPass handle;
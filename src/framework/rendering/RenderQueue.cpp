@@ -0,0 +1,52 @@
+#include "RenderQueue.h"
+
+#include <array>
+#include <cstring>
+
+uint64_t RenderQueue::makeKey(uint32_t pipeline, uint32_t material, float depth)
+{
+	//the bits of a non negative float grow with its value, so they sort without quantizing to a depth range
+	uint32_t depthBits = 0;
+	if (depth > 0.0f)
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	return (uint64_t(pipeline & (maxPipelines - 1)) << 56) | (uint64_t(material & (maxMaterials - 1)) << 32) | depthBits;
+}
+
+void RenderQueue::sort()
+{
+	if (m_packets.size() < 2)
+		return;
+
+	//one histogram per byte, built in a single pass over the keys
+	std::array<std::array<uint32_t, 256>, 8> histograms = {};
+	for (const DrawPacket& packet : m_packets)
+	{
+		for (uint32_t byte = 0; byte < 8; byte++)
+			histograms[byte][(packet.key >> (byte * 8)) & 0xff]++;
+	}
+
+	m_scratch.resize(m_packets.size());
+	for (uint32_t byte = 0; byte < 8; byte++)
+	{
+		auto& histogram = histograms[byte];
+
+		//every key has the same value in this byte, e.g. the pipeline with a single pipeline
+		uint32_t shift = byte * 8;
+		if (histogram[(m_packets[0].key >> shift) & 0xff] == m_packets.size())
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t& count : histogram)
+		{
+			uint32_t bucketSize = count;
+			count = offset;
+			offset += bucketSize;
+		}
+
+		for (const DrawPacket& packet : m_packets)
+			m_scratch[histogram[(packet.key >> shift) & 0xff]++] = packet;
+
+		m_packets.swap(m_scratch);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// a draw waiting in the queue, draw indexes the caller's draw list
+struct DrawPacket
+{
+	uint64_t key;
+	uint32_t draw;
+};
+
+/// collects the draws of a frame with a sort key and orders them with a radix sort, so draws that share state are
+/// adjacent and the caller only binds what changed. keys sort by pipeline, then material, then front to back
+///
+/// key layout, most significant first: 8 bits pipeline, 24 bits material, 32 bits depth
+class RenderQueue
+{
+public:
+	static constexpr uint32_t maxPipelines = 1u << 8;
+	static constexpr uint32_t maxMaterials = 1u << 24;
+
+	/// depth is the distance to the camera, negative values are clamped to 0.
+	/// pass the same material for every draw when materials cost nothing to switch, the queue is front to back then
+	static uint64_t makeKey(uint32_t pipeline, uint32_t material, float depth);
+	static uint32_t getPipeline(uint64_t key) { return static_cast<uint32_t>(key >> 56); }
+	static uint32_t getMaterial(uint64_t key) { return static_cast<uint32_t>(key >> 32) & (maxMaterials - 1); }
+
+	void clear() { m_packets.clear(); }
+	void push(uint64_t key, uint32_t draw) { m_packets.push_back({ key, draw }); }
+	/// stable lsd radix sort over bytes, bytes that are equal in every key are skipped
+	void sort();
+
+	const std::vector<DrawPacket>& getPackets() const { return m_packets; }
+	size_t size() const { return m_packets.size(); }
+	bool empty() const { return m_packets.empty(); }
+private:
+	std::vector<DrawPacket> m_packets;
+	std::vector<DrawPacket> m_scratch;
+};
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "SceneGraph.h"
+
+#include "../utils/Log.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCENE_GRAPH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	glm::mat4 composeTransform(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+	{
+		glm::mat3 r = glm::mat3_cast(rotation);
+		glm::mat4 result;
+		result[0] = glm::vec4(r[0] * scale.x, 0.0f);
+		result[1] = glm::vec4(r[1] * scale.y, 0.0f);
+		result[2] = glm::vec4(r[2] * scale.z, 0.0f);
+		result[3] = glm::vec4(translation, 1.0f);
+		return result;
+	}
+
+	void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result)
+	{
+#ifdef SCENE_GRAPH_SSE2
+		//column i of the result is a * b[i], glm matrices are column major
+		__m128 a0 = _mm_loadu_ps(&a[0][0]);
+		__m128 a1 = _mm_loadu_ps(&a[1][0]);
+		__m128 a2 = _mm_loadu_ps(&a[2][0]);
+		__m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+		for (int i = 0; i < 4; i++)
+		{
+			__m128 column = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b[i][0])), _mm_mul_ps(a1, _mm_set1_ps(b[i][1]))),
+				_mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b[i][2])), _mm_mul_ps(a3, _mm_set1_ps(b[i][3]))));
+			_mm_storeu_ps(&result[i][0], column);
+		}
+#else
+		result = a * b;
+#endif
+	}
+}
+
+void SceneGraph::create(DataView<SceneNode> nodes)
+{
+	clear();
+	for (auto& node : nodes)
+		addNode(node);
+	update();
+}
+
+void SceneGraph::clear()
+{
+	m_parents.clear();
+	m_translations.clear();
+	m_rotations.clear();
+	m_scales.clear();
+	m_localMatrices.clear();
+	m_worldMatrices.clear();
+	m_localDirty.clear();
+	m_worldDirty.clear();
+	m_nodeVersions.clear();
+	m_updatedNodes.clear();
+	m_dirty = false;
+}
+
+uint32_t SceneGraph::addNode(const SceneNode& node)
+{
+	uint32_t index = static_cast<uint32_t>(m_parents.size());
+	uint32_t parent = node.parent;
+	if (parent != invalidNode && parent >= index)
+	{
+		Log::error("error in SceneGraph::addNode(): parent {} of node {} does not exist yet", parent, index);
+		parent = invalidNode;
+	}
+
+	m_parents.push_back(parent);
+	m_translations.push_back(node.translation);
+	m_rotations.push_back(node.rotation);
+	m_scales.push_back(node.scale);
+	m_localMatrices.push_back(glm::mat4(1.0f));
+	m_worldMatrices.push_back(glm::mat4(1.0f));
+	m_localDirty.push_back(1);
+	m_worldDirty.push_back(1);
+	m_nodeVersions.push_back(0);
+	m_dirty = true;
+	return index;
+}
+
+SceneNode SceneGraph::getNode(uint32_t node) const
+{
+	return { m_parents[node], m_translations[node], m_rotations[node], m_scales[node] };
+}
+
+void SceneGraph::setTranslation(uint32_t node, const glm::vec3& translation)
+{
+	m_translations[node] = translation;
+	markDirty(node);
+}
+
+void SceneGraph::setRotation(uint32_t node, const glm::quat& rotation)
+{
+	m_rotations[node] = rotation;
+	markDirty(node);
+}
+
+void SceneGraph::setScale(uint32_t node, const glm::vec3& scale)
+{
+	m_scales[node] = scale;
+	markDirty(node);
+}
+
+void SceneGraph::markDirty(uint32_t node)
+{
+	m_localDirty[node] = 1;
+	m_worldDirty[node] = 1;
+	m_dirty = true;
+}
+
+void SceneGraph::update()
+{
+	m_updatedNodes.clear();
+	if (!m_dirty)
+		return;
+
+	//parents come first, so one forward pass pushes the dirty flag down every subtree
+	for (size_t i = 0; i < m_parents.size(); i++)
+	{
+		uint32_t parent = m_parents[i];
+		if (parent != invalidNode)
+			m_worldDirty[i] |= m_worldDirty[parent];
+
+		if (m_worldDirty[i])
+			m_updatedNodes.push_back(static_cast<uint32_t>(i));
+	}
+
+	//batched passes over the dirty nodes only
+	for (uint32_t node : m_updatedNodes)
+	{
+		if (m_localDirty[node])
+			m_localMatrices[node] = composeTransform(m_translations[node], m_rotations[node], m_scales[node]);
+	}
+
+	m_version++;
+	for (uint32_t node : m_updatedNodes)
+	{
+		uint32_t parent = m_parents[node];
+		if (parent == invalidNode)
+			m_worldMatrices[node] = m_localMatrices[node];
+		else
+			multiply(m_worldMatrices[parent], m_localMatrices[node], m_worldMatrices[node]);
+
+		m_nodeVersions[node] = m_version;
+		m_localDirty[node] = 0;
+		m_worldDirty[node] = 0;
+	}
+
+	m_dirty = false;
+}
+
+float utils::getMaxScale(const glm::mat4& matrix)
+{
+	float x = glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0]));
+	float y = glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1]));
+	float z = glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]));
+	return std::sqrt(std::max(x, std::max(y, z)));
+}
\ No newline at end of file
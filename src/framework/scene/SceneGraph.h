@@ -0,0 +1,77 @@
+#pragma once
+
+#include "framework/utils/DataView.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/// local transform of a node, parent is SceneGraph::invalidNode for roots
+struct SceneNode
+{
+	uint32_t parent;
+	glm::vec3 translation;
+	glm::quat rotation;
+	glm::vec3 scale;
+};
+
+/// node hierarchy flattened into structure of arrays, every parent is stored before its children.
+/// changing a local transform marks the node dirty, update() then recomputes only the dirty subtrees
+class SceneGraph
+{
+public:
+	static constexpr uint32_t invalidNode = ~0u;
+
+	void create(DataView<SceneNode> nodes);
+	void clear();
+
+	/// the parent has to exist already, which keeps parents in front of their children
+	uint32_t addNode(const SceneNode& node);
+
+	void setTranslation(uint32_t node, const glm::vec3& translation);
+	void setRotation(uint32_t node, const glm::quat& rotation);
+	void setScale(uint32_t node, const glm::vec3& scale);
+
+	/// recomputes the world matrices of dirty nodes and their descendants
+	void update();
+
+	size_t size() const { return m_parents.size(); }
+	uint32_t getParent(uint32_t node) const { return m_parents[node]; }
+	SceneNode getNode(uint32_t node) const;
+	const glm::mat4& getWorldMatrix(uint32_t node) const { return m_worldMatrices[node]; }
+	DataView<glm::mat4> getWorldMatrices() const { return m_worldMatrices; }
+
+	/// incremented by every update() that changed a world matrix
+	uint64_t getVersion() const { return m_version; }
+	/// version of the last update() that changed the node's world matrix
+	uint64_t getNodeVersion(uint32_t node) const { return m_nodeVersions[node]; }
+	/// nodes whose world matrix changed in the last update()
+	const std::vector<uint32_t>& getUpdatedNodes() const { return m_updatedNodes; }
+private:
+	void markDirty(uint32_t node);
+private:
+	std::vector<uint32_t> m_parents;
+	std::vector<glm::vec3> m_translations;
+	std::vector<glm::quat> m_rotations;
+	std::vector<glm::vec3> m_scales;
+
+	std::vector<glm::mat4> m_localMatrices;
+	std::vector<glm::mat4> m_worldMatrices;
+
+	//local transform changed, and world matrix has to be recomputed
+	std::vector<uint8_t> m_localDirty;
+	std::vector<uint8_t> m_worldDirty;
+	bool m_dirty = false;
+
+	std::vector<uint64_t> m_nodeVersions;
+	std::vector<uint32_t> m_updatedNodes;
+	uint64_t m_version = 0;
+};
+
+namespace utils
+{
+	/// largest axis scale of an affine transform, used to scale bounding spheres and errors
+	float getMaxScale(const glm::mat4& matrix);
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+//non-owning view over contiguous data, either a std::vector or a memory mapped file
+template<typename T>
+class DataView
+{
+public:
+	DataView() = default;
+	DataView(const T* data, size_t count) : m_data(data), m_count(count) {}
+	DataView(const std::vector<T>& data) : m_data(data.data()), m_count(data.size()) {}
+
+	const T* data() const { return m_data; }
+	size_t size() const { return m_count; }
+	size_t sizeBytes() const { return m_count * sizeof(T); }
+	bool empty() const { return m_count == 0; }
+
+	const T* begin() const { return m_data; }
+	const T* end() const { return m_data + m_count; }
+	const T& operator[](size_t index) const { return m_data[index]; }
+private:
+	const T* m_data = nullptr;
+	size_t m_count = 0;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace utils
+{
+	constexpr uint64_t hashSeed = 0xcbf29ce484222325ull;
+
+	//fnv-1a over 64 bit words, the tail is hashed byte by byte
+	inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = hashSeed)
+	{
+		constexpr uint64_t prime = 0x100000001b3ull;
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+
+		size_t i = 0;
+		for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+		{
+			uint64_t word;
+			memcpy(&word, bytes + i, sizeof(uint64_t));
+			hash = (hash ^ word) * prime;
+		}
+
+		for (; i < size; i++)
+			hash = (hash ^ bytes[i]) * prime;
+
+		return hash;
+	}
+
+	inline uint64_t hashString(const std::string& str, uint64_t seed = hashSeed)
+	{
+		return hashBytes(str.data(), str.size(), seed);
+	}
+
+	template<typename T>
+	uint64_t hashValue(const T& value, uint64_t seed = hashSeed)
+	{
+		return hashBytes(&value, sizeof(T), seed);
+	}
+}
@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this == &other)
+		return *this;
+
+	close();
+	std::swap(m_data, other.m_data);
+	std::swap(m_size, other.m_size);
+	std::swap(m_file, other.m_file);
+#ifdef _WIN32
+	std::swap(m_mapping, other.m_mapping);
+#endif
+	return *this;
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = static_cast<const uint8_t*>(data);
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	if (data == MAP_FAILED)
+	{
+		::close(file);
+		return false;
+	}
+
+	m_file = file;
+	m_data = static_cast<const uint8_t*>(data);
+	m_size = static_cast<size_t>(info.st_size);
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = nullptr;
+#else
+	if (m_data)
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+	if (m_file >= 0)
+		::close(m_file);
+	m_file = -1;
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
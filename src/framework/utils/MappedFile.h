@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "NonCopyable.h"
+
+//read only memory mapped file
+class MappedFile : public NonCopyable
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const { return m_data != nullptr; }
+	const uint8_t* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+};
@@ -0,0 +1,59 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (uint32_t i = 0; i < threadCount; i++)
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_taskAvailable.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_tasksFinished.wait(lock, [this]() { return m_tasks.empty() && m_activeTasks == 0; });
+}
+
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::packaged_task<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskAvailable.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+			if (m_stopping && m_tasks.empty())
+				return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+			m_activeTasks++;
+		}
+
+		//exceptions are stored in the task's future
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_activeTasks--;
+			if (m_tasks.empty() && m_activeTasks == 0)
+				m_tasksFinished.notify_all();
+		}
+	}
+}
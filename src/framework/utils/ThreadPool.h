@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "NonCopyable.h"
+
+class ThreadPool : public NonCopyable
+{
+public:
+	/// threadCount of 0 uses one thread per hardware thread
+	explicit ThreadPool(uint32_t threadCount = 0);
+	~ThreadPool();
+
+	template<typename F>
+	std::future<void> submit(F&& task);
+	/// blocks until every submitted task has finished
+	void wait();
+
+	uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+private:
+	void workerLoop();
+private:
+	std::vector<std::thread> m_workers;
+	std::queue<std::packaged_task<void()>> m_tasks;
+
+	std::mutex m_mutex;
+	std::condition_variable m_taskAvailable;
+	std::condition_variable m_tasksFinished;
+	uint32_t m_activeTasks = 0;
+	bool m_stopping = false;
+};
+
+template<typename F>
+std::future<void> ThreadPool::submit(F&& task)
+{
+	std::packaged_task<void()> packagedTask(std::forward<F>(task));
+	std::future<void> future = packagedTask.get_future();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push(std::move(packagedTask));
+	}
+	m_taskAvailable.notify_one();
+	return future;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+
+class Timer
+{
+public:
+	Timer() { reset(); }
+
+	void reset() { m_start = std::chrono::high_resolution_clock::now(); }
+
+	double elapsedMs() const
+	{
+		auto now = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(now - m_start).count();
+	}
+private:
+	std::chrono::high_resolution_clock::time_point m_start;
+};
@@ -2,6 +2,19 @@
 
 #include"Log.h"
 
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
 std::vector<const char*> utils::getGlfwExtensions()
 {
 	uint32_t count = 0;
@@ -48,4 +61,24 @@ bool utils::checkValidationLayerSupport(const std::vector<const char*> validatio
 bool utils::hasStencilComponent(vk::Format format)
 {
 	return format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD24UnormS8Uint;
+}
+
+size_t utils::getPeakMemoryUsage()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	//kilobytes on linux
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
 }
\ No newline at end of file
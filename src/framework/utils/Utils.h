@@ -16,4 +16,7 @@ namespace utils
 	uint32_t vectorsizeof(const std::vector<T>& vec) { return sizeof(T) * vec.size(); }
 
 	bool hasStencilComponent(vk::Format format);
+
+	/// largest resident set size of the process so far in bytes, 0 if the platform can't tell
+	size_t getPeakMemoryUsage();
 }
\ No newline at end of file
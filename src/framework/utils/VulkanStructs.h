@@ -14,6 +14,8 @@ struct QueueFamilyIndices
 {
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily;
+	//falls back to the graphics family when there is no dedicated transfer family
+	std::optional<uint32_t> transferFamily;
 
 	bool isComplete()
 	{
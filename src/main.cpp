@@ -1,12 +1,124 @@
+#include <charconv>
 #include <iostream>
+#include <string>
 
 #include "Application.h"
 #include "framework/Renderer.h"
+#include "framework/utils/Log.h"
+#include "bench/Benchmarks.h"
+#include "tests/Tests.h"
 
-int main()
+namespace
 {
+	const std::string modelPath = "res/models/Sponza/glTF/Sponza.gltf";
+	constexpr uint32_t defaultIterations = 10;
+
+	uint32_t parseIterations(const char* text)
+	{
+		uint32_t value = 0;
+		const char* end = text + std::char_traits<char>::length(text);
+		auto result = std::from_chars(text, end, value);
+		if (result.ec != std::errc() || result.ptr != end)
+		{
+			Log::error("error in parseIterations(): '{}' is not a valid count, using {}", text, defaultIterations);
+			return defaultIterations;
+		}
+		return value;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string mode = argc > 1 ? argv[1] : "";
+	//the tests don't need a device
+	if (mode == "--test")
+		return tests::runAll() == 0 ? 0 : 1;
+
 	Renderer::get();
+
+	uint32_t iterations = argc > 2 ? parseIterations(argv[2]) : defaultIterations;
+
+	if (mode == "--bench-load")
+	{
+		bench::modelLoad(modelPath, iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-textures")
+	{
+		bench::textureLoad(modelPath, iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-mips")
+	{
+		bench::mipFragmentTime(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-vertices")
+	{
+		bench::vertexFormat(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-culling")
+	{
+		bench::clusterCulling(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-lod")
+	{
+		bench::lodSelection(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-placement")
+	{
+		bench::bufferPlacement(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-indirect")
+	{
+		bench::indirectDraws(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-bindless")
+	{
+		bench::bindlessMaterials(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-frustum")
+	{
+		bench::frustumCulling(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-occlusion")
+	{
+		bench::occlusionCulling(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-prepass")
+	{
+		bench::depthPrepass(iterations);
+		return 0;
+	}
+
+	if (mode == "--bench-recording")
+	{
+		bench::parallelRecording(iterations);
+		return 0;
+	}
+
 	Application app;
+	if (mode == "--memory-stats")
+		app.setMemoryDump("memory_stats", argc > 2 ? iterations : 600);
 	app.run();
 }
 
@@ -0,0 +1,73 @@
+#include "Tests.h"
+
+#include "framework/model/MeshOptimizer.h"
+#include "framework/utils/Log.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace
+{
+	using Triangle = std::array<uint32_t, 3>;
+
+	std::vector<Triangle> getSortedTriangles(const std::vector<uint32_t>& indices)
+	{
+		std::vector<Triangle> triangles(indices.size() / 3);
+		for (size_t t = 0; t < triangles.size(); t++)
+			triangles[t] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+}
+
+uint32_t tests::runAll()
+{
+	struct Test
+	{
+		const char* name;
+		bool (*func)();
+	};
+
+	const Test all[] =
+	{
+		{ "overdrawKeepsTriangles", overdrawKeepsTriangles },
+	};
+
+	uint32_t failures = 0;
+	for (const Test& test : all)
+	{
+		bool passed = test.func();
+		if (passed)
+			Log::info("passed: {}", test.name);
+		else
+			Log::error("failed: {}", test.name);
+		failures += passed ? 0 : 1;
+	}
+	return failures;
+}
+
+bool tests::overdrawKeepsTriangles()
+{
+	//two fans on opposite sides of the origin, the first triangle of the list only references two vertices
+	std::vector<Vertex> vertices(10);
+	for (uint32_t i = 0; i < 5; i++)
+	{
+		vertices[i].position = { -1.0f, static_cast<float>(i), static_cast<float>(i % 2) };
+		vertices[i + 5].position = { 1.0f, static_cast<float>(i), static_cast<float>(i % 2) };
+	}
+
+	std::vector<uint32_t> indices =
+	{
+		0, 0, 1,
+		1, 2, 3,
+		2, 3, 4,
+		5, 6, 7,
+		6, 7, 8,
+		7, 8, 9,
+	};
+
+	std::vector<Triangle> before = getSortedTriangles(indices);
+	utils::optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+	return getSortedTriangles(indices) == before;
+}
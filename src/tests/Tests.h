@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+//checks of the cpu side algorithms, run from the command line with --test, see main.cpp
+namespace tests
+{
+	/// runs every test and logs the failed ones, returns the number of failures
+	uint32_t runAll();
+
+	/// optimizeOverdraw() only reorders triangles, also when the first one is degenerate and doesn't start a hard cluster
+	bool overdrawKeepsTriangles();
+}
@@ -0,0 +1,244 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const int bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8_t* data) : m_data(data) { memset(m_data, 0, 16); }
+
+		void write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t i = 0; i < bitCount; i++, m_position++)
+			{
+				if (value & (1u << i))
+					m_data[m_position / 8] |= static_cast<uint8_t>(1u << (m_position % 8));
+			}
+		}
+	private:
+		uint8_t* m_data;
+		uint32_t m_position = 0;
+	};
+
+	//7 bit endpoint plus a shared p bit, picks the p bit with the lowest error for all four channels
+	void quantizeEndpoint(const float endpoint[4], uint32_t quantized[4], uint32_t& pBit)
+	{
+		float bestError = INFINITY;
+		for (uint32_t p = 0; p < 2; p++)
+		{
+			uint32_t candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				float q = std::round((endpoint[c] - p) / 2.0f);
+				candidate[c] = static_cast<uint32_t>(std::clamp(q, 0.0f, 127.0f));
+				float d = static_cast<float>(candidate[c] * 2 + p) - endpoint[c];
+				error += d * d;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+}
+
+size_t texbake::getBlockSize(BlockFormat format)
+{
+	return format == BlockFormat::eBC4 ? 8 : 16;
+}
+
+void texbake::encodeBlockBC7(const uint8_t* texels, uint8_t* block)
+{
+	//mode 6 only: one subset, rgba endpoints with p bits and 4 bit indices
+	float mean[4] = {};
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			mean[c] += texels[i * 4 + c] / 16.0f;
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float d[4];
+		for (int c = 0; c < 4; c++)
+			d[c] = texels[i * 4 + c] - mean[c];
+		for (int a = 0; a < 4; a++)
+			for (int b = 0; b < 4; b++)
+				covariance[a][b] += d[a] * d[b];
+	}
+
+	//principal axis by power iteration
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = {};
+		for (int a = 0; a < 4; a++)
+			for (int b = 0; b < 4; b++)
+				next[a] += covariance[a][b] * axis[b];
+
+		float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+		if (length < 1e-6f)
+			break;
+		for (int c = 0; c < 4; c++)
+			axis[c] = next[c] / length;
+	}
+
+	float minT = INFINITY;
+	float maxT = -INFINITY;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < 4; c++)
+			t += (texels[i * 4 + c] - mean[c]) * axis[c];
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	float endpoints[2][4];
+	for (int c = 0; c < 4; c++)
+	{
+		endpoints[0][c] = std::clamp(mean[c] + minT * axis[c], 0.0f, 255.0f);
+		endpoints[1][c] = std::clamp(mean[c] + maxT * axis[c], 0.0f, 255.0f);
+	}
+
+	uint32_t quantized[2][4];
+	uint32_t pBits[2];
+	quantizeEndpoint(endpoints[0], quantized[0], pBits[0]);
+	quantizeEndpoint(endpoints[1], quantized[1], pBits[1]);
+
+	int palette[16][4];
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			int e0 = static_cast<int>(quantized[0][c] * 2 + pBits[0]);
+			int e1 = static_cast<int>(quantized[1][c] * 2 + pBits[1]);
+			palette[i][c] = ((64 - bc7Weights4[i]) * e0 + bc7Weights4[i] * e1 + 32) >> 6;
+		}
+	}
+
+	uint32_t indices[16];
+	for (int i = 0; i < 16; i++)
+	{
+		int bestError = INT32_MAX;
+		for (uint32_t p = 0; p < 16; p++)
+		{
+			int error = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				int d = palette[p][c] - texels[i * 4 + c];
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				indices[i] = p;
+			}
+		}
+	}
+
+	//the anchor index drops its top bit, so it has to be below 8
+	if (indices[0] >= 8)
+	{
+		std::swap(quantized[0], quantized[1]);
+		std::swap(pBits[0], pBits[1]);
+		for (auto& index : indices)
+			index = 15 - index;
+	}
+
+	BitWriter writer(block);
+	writer.write(1u << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		writer.write(quantized[0][c], 7);
+		writer.write(quantized[1][c], 7);
+	}
+	writer.write(pBits[0], 1);
+	writer.write(pBits[1], 1);
+
+	writer.write(indices[0], 3);
+	for (int i = 1; i < 16; i++)
+		writer.write(indices[i], 4);
+}
+
+void texbake::encodeBlockBC4(const uint8_t* texels, uint32_t channel, uint8_t* block)
+{
+	uint8_t minValue = 255;
+	uint8_t maxValue = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		minValue = std::min(minValue, texels[i * 4 + channel]);
+		maxValue = std::max(maxValue, texels[i * 4 + channel]);
+	}
+
+	//red0 > red1 selects the 8 value mode: index 0 is red0, 1 is red1 and 2..7 interpolate from red0 to red1
+	block[0] = maxValue;
+	block[1] = minValue;
+
+	uint64_t bits = 0;
+	if (maxValue != minValue)
+	{
+		float scale = 7.0f / (maxValue - minValue);
+		for (int i = 0; i < 16; i++)
+		{
+			int step = static_cast<int>(std::round((texels[i * 4 + channel] - minValue) * scale));
+			uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+			bits |= index << (i * 3);
+		}
+	}
+
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+}
+
+std::vector<uint8_t> texbake::compressImage(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format,
+	const uint32_t channels[2])
+{
+	uint32_t blocksX = (width + 3) / 4;
+	uint32_t blocksY = (height + 3) / 4;
+	size_t blockSize = getBlockSize(format);
+	std::vector<uint8_t> result(blocksX * blocksY * blockSize);
+
+	uint8_t texels[16 * 4];
+	for (uint32_t by = 0; by < blocksY; by++)
+	{
+		for (uint32_t bx = 0; bx < blocksX; bx++)
+		{
+			for (uint32_t y = 0; y < 4; y++)
+			{
+				for (uint32_t x = 0; x < 4; x++)
+				{
+					uint32_t sx = std::min(bx * 4 + x, width - 1);
+					uint32_t sy = std::min(by * 4 + y, height - 1);
+					memcpy(&texels[(y * 4 + x) * 4], &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+				}
+			}
+
+			uint8_t* block = &result[(static_cast<size_t>(by) * blocksX + bx) * blockSize];
+			switch (format)
+			{
+			case BlockFormat::eBC7:
+				encodeBlockBC7(texels, block);
+				break;
+			case BlockFormat::eBC4:
+				encodeBlockBC4(texels, channels[0], block);
+				break;
+			case BlockFormat::eBC5:
+				encodeBlockBC4(texels, channels[0], block);
+				encodeBlockBC4(texels, channels[1], block + 8);
+				break;
+			}
+		}
+	}
+
+	return result;
+}
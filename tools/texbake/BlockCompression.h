@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace texbake
+{
+	enum class BlockFormat
+	{
+		//rgba, 16 bytes per block
+		eBC7,
+		//single channel, 8 bytes per block
+		eBC4,
+		//two channels, 16 bytes per block
+		eBC5
+	};
+
+	size_t getBlockSize(BlockFormat format);
+
+	/// texels are 16 rgba8 values in row order
+	void encodeBlockBC7(const uint8_t* texels, uint8_t* block);
+	/// channel selects the component of the rgba8 texels that is encoded
+	void encodeBlockBC4(const uint8_t* texels, uint32_t channel, uint8_t* block);
+
+	/// compresses a tightly packed rgba8 image, edge blocks repeat the last row and column.
+	/// bc4 takes its channel from channels[0], bc5 from channels[0] and channels[1]
+	std::vector<uint8_t> compressImage(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format,
+		const uint32_t channels[2]);
+}
@@ -0,0 +1,170 @@
+#include "Ktx2Writer.h"
+
+#include "framework/image/Ktx2.h"
+#include "framework/utils/Log.h"
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+	//values from vulkan_core.h and khr_df.h
+	constexpr uint32_t vkFormatBC4Unorm = 139;
+	constexpr uint32_t vkFormatBC5Unorm = 141;
+	constexpr uint32_t vkFormatBC7Unorm = 145;
+	constexpr uint32_t vkFormatBC7Srgb = 146;
+
+	constexpr uint8_t dfModelBC4 = 131;
+	constexpr uint8_t dfModelBC5 = 132;
+	constexpr uint8_t dfModelBC7 = 136;
+	constexpr uint8_t dfPrimariesBT709 = 1;
+	constexpr uint8_t dfTransferLinear = 1;
+	constexpr uint8_t dfTransferSrgb = 2;
+
+	uint32_t getVkFormat(const texbake::Ktx2Image& image)
+	{
+		switch (image.format)
+		{
+		case texbake::BlockFormat::eBC4: return vkFormatBC4Unorm;
+		case texbake::BlockFormat::eBC5: return vkFormatBC5Unorm;
+		default: return image.srgb ? vkFormatBC7Srgb : vkFormatBC7Unorm;
+		}
+	}
+
+	template<typename T>
+	void append(std::vector<uint8_t>& data, T value)
+	{
+		size_t offset = data.size();
+		data.resize(offset + sizeof(T));
+		memcpy(data.data() + offset, &value, sizeof(T));
+	}
+
+	void pad(std::vector<uint8_t>& data, size_t alignment)
+	{
+		data.resize((data.size() + alignment - 1) / alignment * alignment, 0);
+	}
+
+	//basic data format descriptor with one sample per 64 bit half of the block
+	std::vector<uint8_t> createDfd(const texbake::Ktx2Image& image)
+	{
+		uint32_t sampleCount = image.format == texbake::BlockFormat::eBC5 ? 2 : 1;
+		uint16_t blockSize = static_cast<uint16_t>(24 + 16 * sampleCount);
+		uint8_t bytesPlane0 = static_cast<uint8_t>(texbake::getBlockSize(image.format));
+
+		uint8_t model = dfModelBC7;
+		if (image.format == texbake::BlockFormat::eBC4)
+			model = dfModelBC4;
+		else if (image.format == texbake::BlockFormat::eBC5)
+			model = dfModelBC5;
+
+		std::vector<uint8_t> dfd;
+		append<uint32_t>(dfd, 4 + blockSize);
+		append<uint32_t>(dfd, 0);
+		append<uint16_t>(dfd, 2);
+		append<uint16_t>(dfd, blockSize);
+		append<uint8_t>(dfd, model);
+		append<uint8_t>(dfd, dfPrimariesBT709);
+		append<uint8_t>(dfd, image.srgb ? dfTransferSrgb : dfTransferLinear);
+		append<uint8_t>(dfd, 0);
+		//texel block dimensions minus one
+		append<uint32_t>(dfd, 3 | (3 << 8));
+		append<uint32_t>(dfd, bytesPlane0);
+		append<uint32_t>(dfd, 0);
+
+		for (uint32_t i = 0; i < sampleCount; i++)
+		{
+			bool fullBlock = image.format == texbake::BlockFormat::eBC7;
+			append<uint16_t>(dfd, static_cast<uint16_t>(i * 64));
+			append<uint8_t>(dfd, fullBlock ? 127 : 63);
+			//bc7 color channel is 0, bc4/bc5 use red and green
+			append<uint8_t>(dfd, static_cast<uint8_t>(i));
+			append<uint32_t>(dfd, 0);
+			append<uint32_t>(dfd, 0);
+			append<uint32_t>(dfd, UINT32_MAX);
+		}
+
+		return dfd;
+	}
+
+	std::vector<uint8_t> createKvd(const texbake::Ktx2Image& image)
+	{
+		std::vector<uint8_t> kvd;
+		auto add = [&kvd](const std::string& key, const std::string& value)
+		{
+			append<uint32_t>(kvd, static_cast<uint32_t>(key.size() + 1 + value.size() + 1));
+			kvd.insert(kvd.end(), key.begin(), key.end());
+			kvd.push_back(0);
+			kvd.insert(kvd.end(), value.begin(), value.end());
+			kvd.push_back(0);
+			pad(kvd, 4);
+		};
+
+		//keys have to be sorted
+		add("KTXorientation", "rd");
+		if (!image.swizzle.empty())
+			add("KTXswizzle", image.swizzle);
+		add("KTXwriter", "texbake");
+		return kvd;
+	}
+}
+
+bool texbake::writeKtx2(const std::string& path, const Ktx2Image& image)
+{
+	uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+	std::vector<uint8_t> dfd = createDfd(image);
+	std::vector<uint8_t> kvd = createKvd(image);
+
+	ktx2::Header header = {};
+	memcpy(header.identifier, ktx2::identifier, sizeof(ktx2::identifier));
+	header.vkFormat = getVkFormat(image);
+	header.typeSize = 1;
+	header.pixelWidth = image.width;
+	header.pixelHeight = image.height;
+	header.faceCount = 1;
+	header.levelCount = levelCount;
+
+	std::vector<uint8_t> file(sizeof(ktx2::Header) + levelCount * sizeof(ktx2::LevelIndex));
+
+	header.dfdByteOffset = static_cast<uint32_t>(file.size());
+	header.dfdByteLength = static_cast<uint32_t>(dfd.size());
+	file.insert(file.end(), dfd.begin(), dfd.end());
+
+	header.kvdByteOffset = static_cast<uint32_t>(file.size());
+	header.kvdByteLength = static_cast<uint32_t>(kvd.size());
+	file.insert(file.end(), kvd.begin(), kvd.end());
+
+	//levels are stored smallest first, each aligned to the block size
+	std::vector<ktx2::LevelIndex> levelIndex(levelCount);
+	for (uint32_t i = levelCount; i-- > 0;)
+	{
+		pad(file, getBlockSize(image.format));
+		levelIndex[i].byteOffset = file.size();
+		levelIndex[i].byteLength = image.levels[i].size();
+		levelIndex[i].uncompressedByteLength = image.levels[i].size();
+		file.insert(file.end(), image.levels[i].begin(), image.levels[i].end());
+	}
+
+	memcpy(file.data(), &header, sizeof(header));
+	memcpy(file.data() + sizeof(header), levelIndex.data(), levelCount * sizeof(ktx2::LevelIndex));
+
+	//written to a temporary file first so an interrupted bake never leaves a truncated texture behind
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+		if (!stream.write(reinterpret_cast<const char*>(file.data()), file.size()))
+		{
+			Log::error("error in texbake::writeKtx2(): failed to write {}", tempPath);
+			return false;
+		}
+	}
+
+	std::remove(path.c_str());
+	if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		Log::error("error in texbake::writeKtx2(): failed to rename {} to {}", tempPath, path);
+		return false;
+	}
+
+	return true;
+}
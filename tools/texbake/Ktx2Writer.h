@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+
+namespace texbake
+{
+	struct Ktx2Image
+	{
+		BlockFormat format;
+		bool srgb = false;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		/// level 0 first
+		std::vector<std::vector<uint8_t>> levels;
+		/// stored as KTXswizzle, empty for rgba
+		std::string swizzle;
+	};
+
+	bool writeKtx2(const std::string& path, const Ktx2Image& image);
+}
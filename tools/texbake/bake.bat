@@ -0,0 +1,2 @@
+texbake.exe ../../res/models/Sponza/glTF/Sponza.gltf
+pause
\ No newline at end of file
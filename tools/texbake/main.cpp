@@ -0,0 +1,180 @@
+#include "BlockCompression.h"
+#include "Ktx2Writer.h"
+
+#include "framework/image/MipChain.h"
+#include "framework/utils/ThreadPool.h"
+#include "framework/utils/Timer.h"
+#include "framework/utils/Log.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#define TINYGLTF_IMPLEMENTATION
+#include <tiny_gltf.h>
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//bakes every image of a gltf model into a block compressed ktx2 file next to it,
+//the renderer picks up <image>.ktx2 instead of the original when it exists
+namespace
+{
+	enum class Usage
+	{
+		eColor,
+		eNormal,
+		eMetallicRoughness,
+		eOcclusion
+	};
+
+	struct BakeJob
+	{
+		std::string source;
+		std::string destination;
+		Usage usage;
+	};
+
+	std::string getKtx2Path(const std::string& path)
+	{
+		return std::filesystem::path(path).replace_extension(".ktx2").string();
+	}
+
+	bool isUpToDate(const std::string& source, const std::string& destination)
+	{
+		std::error_code error;
+		auto destinationTime = std::filesystem::last_write_time(destination, error);
+		if (error)
+			return false;
+		return destinationTime >= std::filesystem::last_write_time(source, error) && !error;
+	}
+
+	bool bake(const BakeJob& job)
+	{
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(job.source.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels)
+		{
+			Log::error("failed to load {}", job.source);
+			return false;
+		}
+
+		texbake::Ktx2Image image;
+		image.width = static_cast<uint32_t>(width);
+		image.height = static_cast<uint32_t>(height);
+
+		//metallic roughness keeps g (roughness) and b (metallic) in bc5 r and g, the view swizzle moves them back
+		uint32_t channelSelection[2] = { 0, 1 };
+		switch (job.usage)
+		{
+		case Usage::eColor:
+			image.format = texbake::BlockFormat::eBC7;
+			image.srgb = true;
+			break;
+		case Usage::eNormal:
+			image.format = texbake::BlockFormat::eBC5;
+			break;
+		case Usage::eMetallicRoughness:
+			image.format = texbake::BlockFormat::eBC5;
+			channelSelection[0] = 1;
+			channelSelection[1] = 2;
+			image.swizzle = "0rg1";
+			break;
+		case Usage::eOcclusion:
+			image.format = texbake::BlockFormat::eBC4;
+			image.swizzle = "rrr1";
+			break;
+		}
+
+		uint32_t levelCount = utils::getMipLevelCount(image.width, image.height);
+		std::vector<uint8_t> chain(utils::getMipChainSize(image.width, image.height, levelCount));
+		memcpy(chain.data(), pixels, static_cast<size_t>(width) * height * 4);
+		stbi_image_free(pixels);
+
+		//normals are renormalized by the shader, so a plain box filter is good enough here
+		utils::generateMipChain(chain.data(), image.width, image.height, levelCount, image.srgb);
+
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			uint32_t levelWidth = std::max(image.width >> level, 1u);
+			uint32_t levelHeight = std::max(image.height >> level, 1u);
+			const uint8_t* levelData = chain.data() + utils::getMipOffset(image.width, image.height, level);
+			image.levels.push_back(texbake::compressImage(levelData, levelWidth, levelHeight, image.format, channelSelection));
+		}
+
+		return texbake::writeKtx2(job.destination, image);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		Log::info("usage: texbake <model.gltf> [--force]");
+		return 1;
+	}
+
+	std::string filename = argv[1];
+	bool force = argc > 2 && std::string(argv[2]) == "--force";
+
+	tinygltf::Model model;
+	tinygltf::TinyGLTF loader;
+	std::string err, warn;
+	if (!loader.LoadASCIIFromFile(&model, &err, &warn, filename))
+	{
+		Log::error("tinygltf error: {}", err);
+		return 1;
+	}
+
+	//textures referenced as normal or metallic roughness maps get two channel formats, everything else bc7
+	std::vector<Usage> usages(model.images.size(), Usage::eColor);
+	auto setUsage = [&model, &usages](int texture, Usage usage)
+	{
+		if (texture >= 0 && model.textures[texture].source >= 0)
+			usages[model.textures[texture].source] = usage;
+	};
+
+	for (auto& material : model.materials)
+	{
+		setUsage(material.occlusionTexture.index, Usage::eOcclusion);
+		setUsage(material.pbrMetallicRoughness.metallicRoughnessTexture.index, Usage::eMetallicRoughness);
+		setUsage(material.normalTexture.index, Usage::eNormal);
+	}
+
+	std::string directory = std::filesystem::path(filename).parent_path().string();
+	std::vector<BakeJob> jobs;
+	for (size_t i = 0; i < model.images.size(); i++)
+	{
+		if (model.images[i].uri.empty() || model.images[i].uri.rfind("data:", 0) == 0)
+			continue;
+
+		std::string source = (std::filesystem::path(directory) / model.images[i].uri).string();
+		std::string destination = getKtx2Path(source);
+		if (!force && isUpToDate(source, destination))
+			continue;
+
+		jobs.push_back({ source, destination, usages[i] });
+	}
+
+	Timer timer;
+	std::atomic<uint32_t> failed = 0;
+	{
+		ThreadPool pool;
+		for (auto& job : jobs)
+		{
+			pool.submit([&job, &failed]()
+			{
+				Timer jobTimer;
+				if (bake(job))
+					Log::info("baked {} in {:.0f} ms", job.destination, jobTimer.elapsedMs());
+				else
+					failed++;
+			});
+		}
+		pool.wait();
+	}
+
+	Log::info("baked {} of {} images in {:.2f} s, {} failed", jobs.size() - failed, model.images.size(), timer.elapsedMs() / 1000.0, failed.load());
+	return failed == 0 ? 0 : 1;
+}